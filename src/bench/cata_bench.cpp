@@ -0,0 +1,175 @@
+/* Headless benchmark
+ * Starts a "Play Now" game in a fresh world and lets the character wait for a
+ * number of turns without drawing anything, then prints the simulation speed
+ * and how long each phase of the turn took.
+ */
+
+#include "cursesdef.h"
+#include "morale.h"
+#include "game.h"
+#include "player.h"
+#include "mapbuffer.h"
+#include "worldfactory.h"
+#include "rng.h"
+#include "color.h"
+#include "options.h"
+#include "debug.h"
+#include "filesystem.h"
+#include "path_info.h"
+#include "mapsharing.h"
+#include "turn_profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "stdio.h"
+
+namespace {
+
+void print_usage( const char *name )
+{
+    printf( "Usage: %s [--turns <number>] [--seed <string of letters and or numbers>]\n", name );
+    printf( "  --turns  Number of game turns to simulate (default 1000)\n" );
+    printf( "  --seed   Sets the random number generator's seed value\n" );
+}
+
+// Duration of the turn at `fraction` of the sorted list of turn durations
+double percentile( const std::vector<double> &sorted, const double fraction )
+{
+    if( sorted.empty() ) {
+        return 0.0;
+    }
+    return sorted[std::min( sorted.size() - 1, size_t( sorted.size() * fraction ) )];
+}
+
+} // namespace
+
+int main( int argc, char *argv[] )
+{
+    int turns = 1000;
+    // Unlike the game itself, default to the same world every run
+    int seed = djb2_hash( ( const unsigned char * ) "cata_bench" );
+
+    for( int i = 1; i < argc; i++ ) {
+        if( std::strcmp( argv[i], "--turns" ) == 0 && i + 1 < argc ) {
+            turns = std::max( 1, atoi( argv[++i] ) );
+        } else if( std::strcmp( argv[i], "--seed" ) == 0 && i + 1 < argc ) {
+            seed = djb2_hash( ( const unsigned char * ) argv[++i] );
+        } else {
+            print_usage( argv[0] );
+            return 1;
+        }
+    }
+
+    // The world is kept next to the binary, not in the player's saves
+    PATH_INFO::init_base_path( "" );
+    PATH_INFO::init_user_dir( "./" );
+    PATH_INFO::set_standard_filenames();
+    MAP_SHARING::setDefaults();
+
+    if( !assure_dir_exist( FILENAMES["user_dir"].c_str() ) ) {
+        printf( "Can't open or create %s. Check permissions.\n", FILENAMES["user_dir"].c_str() );
+        return 1;
+    }
+    setupDebug();
+
+    initOptions();
+    load_options();
+
+    // Nothing is drawn, but the UI code still needs curses to be set up
+    if( initscr() == NULL ) {
+        printf( "initscr failed!\n" );
+        return 1;
+    }
+    init_interface();
+#if !(defined TILES || defined _WIN32 || defined WINDOWS)
+    init_colors();
+#endif
+
+    std::srand( seed );
+
+    g = new game;
+    g->load_static_data();
+    g->init_ui();
+    if( g->game_error() ) {
+        endwin();
+        printf( "Failed to load the game data.\n" );
+        return 1;
+    }
+
+    // Same as "Play Now" in the main menu
+    WORLDPTR world = world_generator->make_new_world( false );
+    if( world == NULL ) {
+        endwin();
+        printf( "Failed to create a world.\n" );
+        return 1;
+    }
+    world_generator->set_active_world( world );
+    g->setup();
+    while( g->u.create( PLTYPE_NOW ) < 0 ) {
+        g->u = player();
+    }
+    MAPBUFFER.load( world->world_name );
+    g->start_game( world->world_name );
+
+    turn_profiler::set_enabled( true );
+    std::vector<double> durations;
+    durations.reserve( turns );
+    const auto start = std::chrono::steady_clock::now();
+    for( int i = 0; i < turns; i++ ) {
+        if( g->u.is_dead_state() ) {
+            break;
+        }
+        // Scripted "wait" action, the turn passes without asking for input
+        g->u.pause();
+
+        const auto turn_start = std::chrono::steady_clock::now();
+        if( g->do_turn() ) {
+            break;
+        }
+        const auto turn_end = std::chrono::steady_clock::now();
+        durations.push_back( std::chrono::duration<double, std::milli>( turn_end - turn_start ).count() );
+    }
+    const auto end = std::chrono::steady_clock::now();
+    const double seconds = std::chrono::duration<double>( end - start ).count();
+
+    const std::string world_name = world->world_name;
+    endwin();
+
+    std::vector<double> sorted = durations;
+    std::sort( sorted.begin(), sorted.end() );
+    printf( "Simulated %d turns in %f seconds (%.1f turns per second).\n",
+            int( durations.size() ), seconds, durations.size() / seconds );
+    printf( "Turn duration (ms): median %.3f, 95th percentile %.3f, max %.3f\n",
+            percentile( sorted, 0.5 ), percentile( sorted, 0.95 ), percentile( sorted, 1.0 ) );
+    if( int( durations.size() ) < turns ) {
+        printf( "The character died after %d turns.\n", int( durations.size() ) );
+    }
+
+    const int profiled = std::max( 1, turn_profiler::recorded_turns() );
+    printf( "\n%-16s %10s %10s %10s\n", "phase", "mean (ms)", "p95 (ms)", "share" );
+    double phases_total = 0.0;
+    for( int i = 0; i < turn_profiler::NUM_PHASES; i++ ) {
+        phases_total += turn_profiler::get_stats( static_cast<turn_profiler::phase>( i ) ).total;
+    }
+    for( int i = 0; i < turn_profiler::NUM_PHASES; i++ ) {
+        const auto p = static_cast<turn_profiler::phase>( i );
+        const turn_profiler::phase_stats stats = turn_profiler::get_stats( p );
+        printf( "%-16s %10.3f %10.3f %9.1f%%\n", turn_profiler::phase_name( p ),
+                stats.total / profiled, stats.p95,
+                phases_total > 0.0 ? 100.0 * stats.total / phases_total : 0.0 );
+    }
+    printf( "(p95 over the last %d turns)\n", std::min( profiled, turn_profiler::WINDOW_TURNS ) );
+    printf( "\n%-16s %10s\n", "counter", "per turn" );
+    for( int i = 0; i < turn_profiler::NUM_COUNTERS; i++ ) {
+        const auto c = static_cast<turn_profiler::counter>( i );
+        printf( "%-16s %10.1f\n", turn_profiler::counter_name( c ),
+                double( turn_profiler::get_stats( c ).total ) / profiled );
+    }
+
+    g->delete_world( world_name, true );
+    deinitDebug();
+    return 0;
+}
@@ -1111,7 +1111,7 @@ bool cata_tiles::draw_field_or_item( const tripoint &p )
         if( !g->m.sees_some_items( p, g->u ) ) {
             return false;
         }
-        auto items = g->m.i_at( p );
+        const map_stack items = g->m.i_at( p );
         // get the last item in the stack, it will be used for display
         const item &display_item = items[items.size() - 1];
         // get the item's name, as that is the key used to find it in the map
@@ -808,7 +808,7 @@ of pureed bone & LSD."));
                         const mtype *mt = blood.get_mtype();
                         if( mt == nullptr || mt->id == "mon_null" ) {
                             print_line(_("Result:  Human blood, no pathogens found."));
-                        } else if( mt->in_species( "ZOMBIE" ) ) {
+                        } else if( mt->in_species( species_zombie ) ) {
                             if( mt->sym == "Z" ) {
                                 print_line(_("Result:  Human blood.  Unknown pathogen found."));
                             } else {
@@ -10,6 +10,7 @@
 #include "npc.h"
 #include "itype.h"
 #include "vehicle.h"
+#include "sight_cache.h"
 
 #include <algorithm>
 #include <numeric>
@@ -182,8 +183,20 @@ bool Creature::sees( const Creature &critter ) const
     return sees( critter, junk1, junk2 );
 }
 
-extern bool debug_mode;
 bool Creature::sees( const Creature &critter, int &bresen1, int &bresen2 ) const
+{
+    sight_cache::result r;
+    if( !sight_cache::lookup( *this, critter, r ) ) {
+        r.seen = sees_uncached( critter, r.bresen1, r.bresen2 );
+        sight_cache::store( *this, critter, r );
+    }
+    bresen1 = r.bresen1;
+    bresen2 = r.bresen2;
+    return r.seen;
+}
+
+extern bool debug_mode;
+bool Creature::sees_uncached( const Creature &critter, int &bresen1, int &bresen2 ) const
 {
     if( critter.is_hallucination() ) {
         // hallucinations are imaginations of the player character, npcs or monsters don't hallucinate.
@@ -252,12 +265,11 @@ bool Creature::sees( const tripoint &t, int &bresen1, int &bresen2 ) const
     if( wanted_range <= range_min ||
         ( wanted_range <= range_day &&
           g->m.ambient_light_at( t ) > g->natural_light_level() ) ) {
+        const int range = g->m.ambient_light_at( t ) > g->natural_light_level() ? wanted_range : range_min;
         if( is_player() ) {
             return g->m.pl_sees( t, wanted_range );
-        } else if( g->m.ambient_light_at( t ) > g->natural_light_level() ) {
-            return g->m.sees( pos3(), t, wanted_range, bresen1, bresen2 );
         } else {
-            return g->m.sees( pos3(), t, range_min, bresen1, bresen2 );
+            return g->m.sees( pos3(), t, range, bresen1, bresen2 );
         }
     } else {
         return false;
@@ -795,6 +807,8 @@ void Creature::add_effect( efftype_id eff_id, int dur, body_part bp,
     if( !force && is_immune_effect( eff_id ) ) {
         return;
     }
+    // Blindness, invisibility and the like change what we see and who sees us
+    sight_cache::invalidate();
 
     // Mutate to a main (HP'd) body_part if necessary.
     if (effect_types[eff_id].get_main_parts()) {
@@ -906,6 +920,7 @@ bool Creature::add_env_effect( efftype_id eff_id, body_part vector, int strength
 void Creature::clear_effects()
 {
     effects.clear();
+    sight_cache::invalidate();
 }
 bool Creature::remove_effect(efftype_id eff_id, body_part bp)
 {
@@ -913,6 +928,7 @@ bool Creature::remove_effect(efftype_id eff_id, body_part bp)
         //Effect doesn't exist, so do nothing
         return false;
     }
+    sight_cache::invalidate();
 
     if (is_player()) {
         // Print the removal message and add the memorial log if needed
@@ -590,6 +590,10 @@ class Creature
         void store(JsonOut &jsout) const;
         // Load creature data from the given json object.
         void load(JsonObject &jsin);
+
+    private:
+        // Creature::sees( Creature ) without looking at the sight_cache
+        bool sees_uncached( const Creature &critter, int &bresen1, int &bresen2 ) const;
 };
 
 #endif
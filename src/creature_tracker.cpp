@@ -2,8 +2,19 @@
 #include "monster.h"
 #include "mongroup.h"
 #include "debug.h"
+#include "sight_cache.h"
+#include "game.h"
+#include "npc.h"
+#include "line.h"
+#include "monfaction.h"
 
-Creature_tracker::Creature_tracker()
+#include <algorithm>
+
+// The submaps of the reality bubble on each z-level come first
+static const int outside_bucket = OVERMAP_LAYERS * MAPSIZE * MAPSIZE;
+
+Creature_tracker::Creature_tracker() : buckets( outside_bucket + 1 ),
+    bucket_changes( outside_bucket + 1, 0 )
 {
 }
 
@@ -55,6 +66,10 @@ bool Creature_tracker::add( monster &critter )
 
     monsters_by_location[critter.pos3()] = monsters_list.size();
     monsters_list.push_back(new monster(critter));
+    monster_buckets.push_back( outside_bucket );
+    add_to_bucket( monsters_list.size() - 1, critter.pos3() );
+    monster_factions.push_back( planning_faction( critter ) );
+    add_to_faction( monsters_list.size() - 1 );
     return true;
 }
 
@@ -66,6 +81,17 @@ size_t Creature_tracker::size() const
 bool Creature_tracker::update_pos(const monster &critter, const tripoint &new_pos)
 {
     const auto old_pos = critter.pos();
+    // The monster moves even if the checks below fail
+    int index = mon_at( old_pos );
+    if( index < 0 || monsters_list[index] != &critter ) {
+        const auto iter = std::find( monsters_list.begin(), monsters_list.end(), &critter );
+        index = iter != monsters_list.end() ? iter - monsters_list.begin() : -1;
+    }
+    if( index >= 0 ) {
+        remove_from_bucket( index );
+        add_to_bucket( index, new_pos );
+    }
+
     if( critter.is_dead() ) {
         // mon_at ignores dead critters anyway, changing their position in the
         // monsters_by_location map is useless.
@@ -127,9 +153,15 @@ void Creature_tracker::remove( const int idx )
 
     monster &m = *monsters_list[idx];
     remove_from_location_map( m );
+    remove_from_bucket( idx );
+    remove_from_faction( idx );
 
+    // A new monster may get the same address
+    sight_cache::invalidate();
     delete monsters_list[idx];
     monsters_list.erase( monsters_list.begin() + idx );
+    monster_buckets.erase( monster_buckets.begin() + idx );
+    monster_factions.erase( monster_factions.begin() + idx );
 
     // Fix indices in monsters_by_location for any zombies that were just moved down 1 place.
     for( auto &elem : monsters_by_location ) {
@@ -137,23 +169,49 @@ void Creature_tracker::remove( const int idx )
             --elem.second;
         }
     }
+    for( auto &bucket : buckets ) {
+        for( auto &elem : bucket ) {
+            if( elem > idx ) {
+                --elem;
+            }
+        }
+    }
+    for( auto &members : faction_members ) {
+        for( auto &elem : members ) {
+            if( elem > idx ) {
+                --elem;
+            }
+        }
+    }
 }
 
 void Creature_tracker::clear()
 {
+    sight_cache::invalidate();
     for( auto monster_ptr : monsters_list ) {
         delete monster_ptr;
     }
     monsters_list.clear();
     monsters_by_location.clear();
+    for( auto &bucket : buckets ) {
+        bucket.clear();
+    }
+    monster_buckets.clear();
+    faction_members.clear();
+    monster_factions.clear();
+    active_factions.clear();
 }
 
 void Creature_tracker::rebuild_cache()
 {
     monsters_by_location.clear();
+    for( auto &bucket : buckets ) {
+        bucket.clear();
+    }
     for( size_t i = 0; i < monsters_list.size(); i++ ) {
         monster &critter = *monsters_list[i];
         monsters_by_location[critter.pos3()] = i;
+        add_to_bucket( i, critter.pos3() );
     }
 }
 
@@ -166,3 +224,232 @@ const std::vector<monster> &Creature_tracker::list() const
     }
     return for_now;
 }
+
+int Creature_tracker::bucket_of( const tripoint &p )
+{
+    if( p.x < 0 || p.y < 0 || p.x >= SEEX * MAPSIZE || p.y >= SEEY * MAPSIZE ||
+        p.z < -OVERMAP_DEPTH || p.z > OVERMAP_HEIGHT ) {
+        return outside_bucket;
+    }
+    return ( ( p.z + OVERMAP_DEPTH ) * MAPSIZE + p.x / SEEX ) * MAPSIZE + p.y / SEEY;
+}
+
+void Creature_tracker::add_to_bucket( const int index, const tripoint &p )
+{
+    const int b = bucket_of( p );
+    buckets[b].push_back( index );
+    monster_buckets[index] = b;
+    bucket_changes[b] = ++changes;
+}
+
+void Creature_tracker::remove_from_bucket( const int index )
+{
+    auto &bucket = buckets[monster_buckets[index]];
+    bucket_changes[monster_buckets[index]] = ++changes;
+    const auto iter = std::find( bucket.begin(), bucket.end(), index );
+    if( iter != bucket.end() ) {
+        // The order within a bucket doesn't matter
+        *iter = bucket.back();
+        bucket.pop_back();
+    }
+}
+
+template<typename F>
+void Creature_tracker::for_each_bucket( const tripoint &min, const tripoint &max, F f ) const
+{
+    const int minx = std::max( min.x, 0 );
+    const int miny = std::max( min.y, 0 );
+    const int minz = std::max( min.z, -OVERMAP_DEPTH );
+    const int maxx = std::min( max.x, SEEX * MAPSIZE - 1 );
+    const int maxy = std::min( max.y, SEEY * MAPSIZE - 1 );
+    const int maxz = std::min( max.z, OVERMAP_HEIGHT );
+    if( minx <= maxx && miny <= maxy ) {
+        for( int z = minz; z <= maxz; z++ ) {
+            for( int smx = minx / SEEX; smx <= maxx / SEEX; smx++ ) {
+                for( int smy = miny / SEEY; smy <= maxy / SEEY; smy++ ) {
+                    f( ( ( z + OVERMAP_DEPTH ) * MAPSIZE + smx ) * MAPSIZE + smy );
+                }
+            }
+        }
+    }
+    if( min.x < 0 || min.y < 0 || min.z < -OVERMAP_DEPTH || max.x >= SEEX * MAPSIZE ||
+        max.y >= SEEY * MAPSIZE || max.z > OVERMAP_HEIGHT ) {
+        f( outside_bucket );
+    }
+}
+
+std::vector<int> Creature_tracker::monsters_within_radius( const tripoint &p, const int radius ) const
+{
+    std::vector<int> result;
+    // rl_dist is never less than the distance along each axis
+    const tripoint r( radius, radius, radius );
+    for_each_bucket( p - r, p + r, [&]( const int b ) {
+        const std::vector<int> &bucket = buckets[b];
+        for( size_t i = 0; i < bucket.size(); i++ ) {
+            if( rl_dist( p, monsters_list[bucket[i]]->pos3() ) <= radius ) {
+                result.push_back( bucket[i] );
+            }
+        }
+    } );
+    std::sort( result.begin(), result.end() );
+    return result;
+}
+
+static bool in_box( const tripoint &p, const tripoint &min, const tripoint &max )
+{
+    return p.x >= min.x && p.y >= min.y && p.z >= min.z && p.x <= max.x && p.y <= max.y && p.z <= max.z;
+}
+
+std::vector<int> Creature_tracker::monsters_in_rect( const tripoint &min, const tripoint &max ) const
+{
+    std::vector<int> result;
+    for_each_bucket( min, max, [&]( const int b ) {
+        const std::vector<int> &bucket = buckets[b];
+        for( size_t i = 0; i < bucket.size(); i++ ) {
+            if( in_box( monsters_list[bucket[i]]->pos3(), min, max ) ) {
+                result.push_back( bucket[i] );
+            }
+        }
+    } );
+    std::sort( result.begin(), result.end() );
+    return result;
+}
+
+int Creature_tracker::change_count() const
+{
+    return changes;
+}
+
+bool Creature_tracker::changed_within( const tripoint &p, const int radius, const int since ) const
+{
+    bool changed = false;
+    const tripoint r( radius, radius, radius );
+    for_each_bucket( p - r, p + r, [&]( const int b ) {
+        changed = changed || bucket_changes[b] > since;
+    } );
+    return changed;
+}
+
+std::vector<Creature *> Creature_tracker::within_radius( const tripoint &p, const int radius ) const
+{
+    std::vector<Creature *> result;
+    for( const int index : monsters_within_radius( p, radius ) ) {
+        result.push_back( monsters_list[index] );
+    }
+    // There are only a few of those
+    for( npc *n : g->active_npc ) {
+        if( rl_dist( p, n->pos3() ) <= radius ) {
+            result.push_back( n );
+        }
+    }
+    if( rl_dist( p, g->u.pos3() ) <= radius ) {
+        result.push_back( &g->u );
+    }
+    return result;
+}
+
+std::vector<Creature *> Creature_tracker::in_rect( const tripoint &min, const tripoint &max ) const
+{
+    std::vector<Creature *> result;
+    for( const int index : monsters_in_rect( min, max ) ) {
+        result.push_back( monsters_list[index] );
+    }
+    for( npc *n : g->active_npc ) {
+        if( in_box( n->pos3(), min, max ) ) {
+            result.push_back( n );
+        }
+    }
+    if( in_box( g->u.pos3(), min, max ) ) {
+        result.push_back( &g->u );
+    }
+    return result;
+}
+
+mfaction_id Creature_tracker::planning_faction( const monster &critter )
+{
+    if( critter.friendly != 0 ) {
+        return mfaction_str_id( "player" );
+    }
+    // Only 1 faction per mon at the moment.
+    return critter.faction;
+}
+
+void Creature_tracker::add_to_faction( const int index )
+{
+    const mfaction_id faction = monster_factions[index];
+    if( faction_members.size() <= static_cast<size_t>( faction.to_i() ) ) {
+        faction_members.resize( faction.to_i() + 1 );
+    }
+    auto &members = faction_members[faction.to_i()];
+    if( members.empty() ) {
+        active_factions.insert( std::lower_bound( active_factions.begin(), active_factions.end(), faction ),
+                                faction );
+    }
+    members.insert( std::lower_bound( members.begin(), members.end(), index ), index );
+}
+
+void Creature_tracker::remove_from_faction( const int index )
+{
+    const mfaction_id faction = monster_factions[index];
+    auto &members = faction_members[faction.to_i()];
+    const auto iter = std::lower_bound( members.begin(), members.end(), index );
+    if( iter != members.end() && *iter == index ) {
+        members.erase( iter );
+    }
+    if( members.empty() ) {
+        active_factions.erase( std::remove( active_factions.begin(), active_factions.end(), faction ),
+                               active_factions.end() );
+    }
+}
+
+void Creature_tracker::update_factions()
+{
+    for( size_t i = 0; i < monsters_list.size(); i++ ) {
+        const mfaction_id faction = planning_faction( *monsters_list[i] );
+        if( faction != monster_factions[i] ) {
+            remove_from_faction( i );
+            monster_factions[i] = faction;
+            add_to_faction( i );
+        }
+    }
+}
+
+const std::vector<mfaction_id> &Creature_tracker::factions() const
+{
+    return active_factions;
+}
+
+std::vector<int> Creature_tracker::faction_members_within_radius( const mfaction_id &faction,
+        const tripoint &p, const int radius ) const
+{
+    std::vector<int> result;
+    if( faction_members.size() <= static_cast<size_t>( faction.to_i() ) ) {
+        return result;
+    }
+    const auto &members = faction_members[faction.to_i()];
+    const tripoint r( radius, radius, radius );
+    size_t nearby = 0;
+    for_each_bucket( p - r, p + r, [&]( const int b ) {
+        nearby += buckets[b].size();
+    } );
+    if( members.size() <= nearby ) {
+        // Checking the members is cheaper than the monsters around (and they are sorted already)
+        for( size_t i = 0; i < members.size(); i++ ) {
+            if( rl_dist( p, monsters_list[members[i]]->pos3() ) <= radius ) {
+                result.push_back( members[i] );
+            }
+        }
+        return result;
+    }
+    for_each_bucket( p - r, p + r, [&]( const int b ) {
+        const std::vector<int> &bucket = buckets[b];
+        for( size_t i = 0; i < bucket.size(); i++ ) {
+            if( monster_factions[bucket[i]] == faction &&
+                rl_dist( p, monsters_list[bucket[i]]->pos3() ) <= radius ) {
+                result.push_back( bucket[i] );
+            }
+        }
+    } );
+    std::sort( result.begin(), result.end() );
+    return result;
+}
@@ -2,10 +2,15 @@
 #define CREATURE_TRACKER_H
 
 #include "enums.h"
+#include "int_id.h"
 #include <vector>
 #include <unordered_map>
 
 class monster;
+class Creature;
+class monfaction;
+
+using mfaction_id = int_id<monfaction>;
 
 class Creature_tracker
 {
@@ -28,11 +33,73 @@ class Creature_tracker
         void rebuild_cache();
         const std::vector<monster> &list() const;
 
+        /**
+         * Indices of the monsters within `radius` squares (see @ref rl_dist) of `p`, in ascending
+         * order. Includes dead monsters that weren't removed yet.
+         */
+        std::vector<int> monsters_within_radius( const tripoint &p, int radius ) const;
+        /** Indices of the monsters in the box from `min` to `max` (both inclusive), in ascending order. */
+        std::vector<int> monsters_in_rect( const tripoint &min, const tripoint &max ) const;
+        /**
+         * Monsters (in index order, see @ref monsters_within_radius), then NPCs and the player
+         * within `radius` squares of `p`.
+         */
+        std::vector<Creature *> within_radius( const tripoint &p, int radius ) const;
+        /** Like @ref within_radius for the box from `min` to `max`. */
+        std::vector<Creature *> in_rect( const tripoint &min, const tripoint &max ) const;
+        /** Counts the monsters that were added, moved or removed, see @ref changed_within. */
+        int change_count() const;
+        /**
+         * Whether a monster was added to, moved within, moved into or out of, or removed from the
+         * submaps around the squares within `radius` of `p` since @ref change_count returned `since`.
+         */
+        bool changed_within( const tripoint &p, int radius, int since ) const;
+
+        /** Faction a monster plans with: its own, or the one of the player for friendly monsters. */
+        static mfaction_id planning_faction( const monster &critter );
+        /**
+         * Moves the monsters whose faction or friendliness changed to their new faction.
+         * Adding and removing monsters keeps the factions up to date, game::monmove calls this
+         * once per turn for the rest.
+         */
+        void update_factions();
+        /** Factions with at least one member, in ascending order. */
+        const std::vector<mfaction_id> &factions() const;
+        /** Like @ref monsters_within_radius, but only the members of `faction`. */
+        std::vector<int> faction_members_within_radius( const mfaction_id &faction, const tripoint &p,
+                int radius ) const;
+
     private:
         std::vector<monster *> monsters_list;
         std::unordered_map<tripoint, size_t> monsters_by_location;
+        /**
+         * Indices of the monsters by the submap of the reality bubble they are in (see @ref bucket_of),
+         * the last bucket holds those outside of it. Unlike @ref monsters_by_location it includes
+         * dead monsters.
+         */
+        std::vector<std::vector<int>> buckets;
+        /** Bucket of each monster, by the same index as @ref monsters_list */
+        std::vector<int> monster_buckets;
+        /** The @ref change_count of the last change of each bucket */
+        std::vector<int> bucket_changes;
+        int changes = 0;
+        /** Indices of the members of each faction in ascending order, by mfaction_id */
+        std::vector<std::vector<int>> faction_members;
+        /** Faction of each monster as of the last update, by the same index as @ref monsters_list */
+        std::vector<mfaction_id> monster_factions;
+        /** See @ref factions */
+        std::vector<mfaction_id> active_factions;
         /** Remove the monsters entry in @ref monsters_by_location */
         void remove_from_location_map( const monster &critter );
+        static int bucket_of( const tripoint &p );
+        void add_to_bucket( int index, const tripoint &p );
+        void remove_from_bucket( int index );
+        /** Adds the monster to its faction in @ref monster_factions */
+        void add_to_faction( int index );
+        void remove_from_faction( int index );
+        /** Calls `f` with the index of each bucket that overlaps the box. */
+        template<typename F>
+        void for_each_bucket( const tripoint &min, const tripoint &max, F f ) const;
 };
 
 #endif
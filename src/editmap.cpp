@@ -1665,7 +1665,9 @@ int editmap::mapgen_preview( real_coords &tc, uimenu &gmenu )
                             submap *destsm = g->m.get_submap_at_grid( target_sub.x + x, target_sub.y + y, target.z );
                             submap *srcsm = tmpmap.get_submap_at_grid( x, y, target.z );
                             destsm->is_uniform = false;
+                            destsm->dirty = true;
                             srcsm->is_uniform = false;
+                            srcsm->dirty = true;
 
                             for( auto &v : destsm->vehicles ) {
                                 auto &ch = g->m.access_cache( v->smz );
@@ -1699,6 +1701,7 @@ int editmap::mapgen_preview( real_coords &tc, uimenu &gmenu )
                                 }
                             }
                             destsm->field_count = srcsm->field_count; // and count
+                            std::memcpy( destsm->field_tiles, srcsm->field_tiles, sizeof( srcsm->field_tiles ) );
 
                             std::memcpy( *destsm->ter, srcsm->ter, sizeof( srcsm->ter ) ); // terrain
                             std::memcpy( *destsm->frn, srcsm->frn, sizeof( srcsm->frn ) ); // furniture
@@ -345,29 +345,28 @@ bool map::process_fields()
     bool dirty_transparency_cache = false;
     const int minz = zlevels ? -OVERMAP_DEPTH : abs_sub.z;
     const int maxz = zlevels ? OVERMAP_HEIGHT : abs_sub.z;
-    bool zlev_dirty;
     for( int z = minz; z <= maxz; z++ ) {
-        zlev_dirty = false;
         for( int x = 0; x < my_MAPSIZE; x++ ) {
             for( int y = 0; y < my_MAPSIZE; y++ ) {
                 submap * const current_submap = get_submap_at_grid( x, y, z );
-                if( current_submap->field_count > 0 ) {
-                    const bool cur_dirty = process_fields_in_submap( current_submap, x, y, z );
-                    zlev_dirty |= cur_dirty;
+                if( current_submap->field_count > 0 &&
+                    process_fields_in_submap( current_submap, x, y, z ) ) {
+                    // For now, just always dirty the transparency cache
+                    // when a field might possibly be changed.
+                    // TODO: check if there are any fields(mostly fire)
+                    //       that frequently change, if so set the dirty
+                    //       flag, otherwise only set the dirty flag if
+                    //       something actually changed
+                    // Fields spread into the neighboring submaps as well.
+                    for( int nx = x - 1; nx <= x + 1; nx++ ) {
+                        for( int ny = y - 1; ny <= y + 1; ny++ ) {
+                            set_transparency_cache_dirty( tripoint( nx * SEEX, ny * SEEY, z ) );
+                        }
+                    }
+                    dirty_transparency_cache = true;
                 }
             }
         }
-
-        if( zlev_dirty ) {
-            // For now, just always dirty the transparency cache
-            // when a field might possibly be changed.
-            // TODO: check if there are any fields(mostly fire)
-            //       that frequently change, if so set the dirty
-            //       flag, otherwise only set the dirty flag if
-            //       something actually changed
-            set_transparency_cache_dirty( z );
-            dirty_transparency_cache = true;
-        }
     }
 
     return dirty_transparency_cache;
@@ -432,6 +431,8 @@ If you need to insert a new field behavior per unit time add a case statement in
 bool map::process_fields_in_submap( submap *const current_submap,
                                     const int submap_x, const int submap_y, const int submap_z )
 {
+    // The fields age and change in place
+    current_submap->dirty = true;
     const auto get_neighbors = [this]( const tripoint &pt ) {
         // Wrapper to allow skipping bound checks except at the edges of the map
         const auto maptile_has_bounds = [this]( const tripoint &pt, const bool bounds_checked ) {
@@ -469,7 +470,7 @@ bool map::process_fields_in_submap( submap *const current_submap,
         tmp.z = p.z;
         for( tmp.x = p.x - 1; tmp.x <= p.x + 1; tmp.x++ ) {
             for( tmp.y = p.y - 1; tmp.y <= p.y + 1; tmp.y++ ) {
-                g->scent( tmp ) = 0;
+                g->set_scent( tmp, 0 );
             }
         }
 
@@ -598,9 +599,13 @@ bool map::process_fields_in_submap( submap *const current_submap,
     maptile map_tile( current_submap, 0, 0 );
     size_t &locx = map_tile.x;
     size_t &locy = map_tile.y;
-    //Loop through all tiles in this submap indicated by current_submap
+    //Loop through all tiles with fields in this submap indicated by current_submap.
+    //The mask is read again for every tile, as processing can add fields further down.
     for( locx = 0; locx < SEEX; locx++ ) {
-        for( locy = 0; locy < SEEY; locy++ ) {
+        for( locy = 0; ( current_submap->field_tiles[locx] >> locy ) != 0; locy++ ) {
+            if( !current_submap->has_field_tile( locx, locy ) ) {
+                continue;
+            }
             // This is a translation from local coordinates to submap coords.
             // All submaps are in one long 1d array.
             thep.x = locx + submap_x * SEEX;
@@ -619,7 +624,7 @@ bool map::process_fields_in_submap( submap *const current_submap,
                         dirty_transparency_cache = true;
                     }
                     current_submap->field_count--;
-                    curfield.removeField( it++ );
+                    it = curfield.removeField( it );
                     continue;
                 }
 
@@ -734,7 +739,7 @@ bool map::process_fields_in_submap( submap *const current_submap,
                         break;
                     case fd_slime:
                         if( g->scent( p ) < cur->getFieldDensity() * 10 ) {
-                            g->scent( p ) = cur->getFieldDensity() * 10;
+                            g->set_scent( p, cur->getFieldDensity() * 10 );
                         }
                         break;
                     case fd_plasma:
@@ -1273,7 +1278,7 @@ bool map::process_fields_in_submap( submap *const current_submap,
                         mondex = g->mon_at( p );
                         if( move_cost( p ) > 0 ) {
                             if( mondex != -1 ) { // Haze'd!
-                                if( !g->zombie(mondex).type->in_species("FUNGUS") &&
+                                if( !g->zombie(mondex).type->in_species(species_fungus) &&
                                     !g->zombie(mondex).type->has_flag("NO_BREATHE")) {
                                     if( g->u.sees( p ) ) {
                                         add_msg( m_info, _("The %s inhales thousands of live spores!"),
@@ -1695,11 +1700,14 @@ bool map::process_fields_in_submap( submap *const current_submap,
                 }
                 if( !cur->isAlive() ) {
                     current_submap->field_count--;
-                    curfield.removeField( it++ );
+                    it = curfield.removeField( it );
                 } else {
                     ++it;
                 }
             }
+            if( curfield.fieldCount() == 0 ) {
+                current_submap->clear_field_tile( locx, locy );
+            }
         }
     }
     return dirty_transparency_cache;
@@ -2441,15 +2449,76 @@ int field_entry::setFieldAge(const int new_age){
 }
 
 field::field()
-    : field_list()
-    , draw_symbol( fd_null )
+    : draw_symbol( fd_null )
+    , inline_count( 0 )
+    , overflow()
 {
 }
 
+field::field( const field &other )
+    : draw_symbol( other.draw_symbol )
+    , inline_count( other.inline_count )
+    , overflow( other.overflow ? new std::list<value_type>( *other.overflow ) : nullptr )
+{
+    std::copy( other.inline_entries, other.inline_entries + inline_count, inline_entries );
+}
+
 field::~field()
 {
 }
 
+field &field::operator=( const field &other )
+{
+    if( this != &other ) {
+        std::copy( other.inline_entries, other.inline_entries + other.inline_count, inline_entries );
+        inline_count = other.inline_count;
+        overflow.reset( other.overflow ? new std::list<value_type>( *other.overflow ) : nullptr );
+        draw_symbol = other.draw_symbol;
+    }
+    return *this;
+}
+
+const field::value_type *field::next_entry( const int after ) const
+{
+    const value_type *next = nullptr;
+    for( int i = 0; i < inline_count; i++ ) {
+        const value_type &entry = inline_entries[i];
+        if( entry.first > after && ( next == nullptr || entry.first < next->first ) ) {
+            next = &entry;
+        }
+    }
+    if( overflow ) {
+        for( const value_type &entry : *overflow ) {
+            if( entry.first > after && ( next == nullptr || entry.first < next->first ) ) {
+                next = &entry;
+            }
+        }
+    }
+    return next;
+}
+
+field::value_type *field::next_entry( const int after )
+{
+    return const_cast<value_type *>( static_cast<const field *>( this )->next_entry( after ) );
+}
+
+field::value_type *field::find_entry( const field_id type )
+{
+    for( int i = 0; i < inline_count; i++ ) {
+        if( inline_entries[i].first == type ) {
+            return &inline_entries[i];
+        }
+    }
+    if( overflow ) {
+        for( value_type &entry : *overflow ) {
+            if( entry.first == type ) {
+                return &entry;
+            }
+        }
+    }
+    return nullptr;
+}
+
 /*
 Function: findField
 Returns a field entry corresponding to the field_id parameter passed in. If no fields are found then returns NULL.
@@ -2457,20 +2526,13 @@ Good for checking for exitence of a field: if(myfield.findField(fd_fire)) would
 */
 field_entry *field::findField( const field_id field_to_find )
 {
-    const auto it = field_list.find( field_to_find );
-    if( it != field_list.end() ) {
-        return &it->second;
-    }
-    return nullptr;
+    value_type *const entry = find_entry( field_to_find );
+    return entry != nullptr ? &entry->second : nullptr;
 }
 
 const field_entry *field::findFieldc( const field_id field_to_find ) const
 {
-    const auto it = field_list.find( field_to_find );
-    if( it != field_list.end() ) {
-        return &it->second;
-    }
-    return nullptr;
+    return const_cast<field *>( this )->findField( field_to_find );
 }
 
 const field_entry *field::findField( const field_id field_to_find ) const
@@ -2487,41 +2549,68 @@ If you wish to modify an already existing field use findField and modify the res
 Density defaults to 1, and age to 0 (permanent) if not specified.
 */
 bool field::addField(const field_id field_to_add, const int new_density, const int new_age){
-    auto it = field_list.find(field_to_add);
+    value_type *const existing = find_entry( field_to_add );
     if (fieldlist[field_to_add].priority >= fieldlist[draw_symbol].priority)
         draw_symbol = field_to_add;
-    if(it != field_list.end()) {
+    if( existing != nullptr ) {
         //Already exists, but lets update it. This is tentative.
-        it->second.setFieldDensity(it->second.getFieldDensity() + new_density);
+        existing->second.setFieldDensity( existing->second.getFieldDensity() + new_density );
         return false;
     }
-    field_list[field_to_add] = field_entry(field_to_add, new_density, new_age);
+    const value_type entry( field_to_add, field_entry( field_to_add, new_density, new_age ) );
+    if( inline_count < INLINE_ENTRIES ) {
+        inline_entries[inline_count++] = entry;
+    } else {
+        if( !overflow ) {
+            overflow.reset( new std::list<value_type>() );
+        }
+        overflow->push_back( entry );
+    }
     return true;
 }
 
 bool field::removeField( field_id const field_to_remove )
 {
-    const auto it = field_list.find( field_to_remove );
-    if( it == field_list.end() ) {
+    value_type *const entry = find_entry( field_to_remove );
+    if( entry == nullptr ) {
         return false;
     }
-    removeField( it );
+    removeField( iterator( this, entry ) );
     return true;
 }
 
-void field::removeField( std::map<field_id, field_entry>::iterator const it )
+field::iterator field::removeField( iterator const it )
 {
-        field_list.erase( it );
-        if( field_list.empty() ) {
-            draw_symbol = fd_null;
+    const field_id removed = it->first;
+    value_type *const entry = it.cur;
+    if( entry >= inline_entries && entry < inline_entries + inline_count ) {
+        // Fill the hole, entries that didn't fit inline come first
+        if( overflow ) {
+            *entry = overflow->back();
+            overflow->pop_back();
         } else {
-            draw_symbol = fd_null;
-            for( auto &fld : field_list ) {
-                if (fieldlist[fld.first].priority >= fieldlist[draw_symbol].priority) {
-                    draw_symbol = fld.first;
-                }
+            *entry = inline_entries[inline_count - 1];
+            inline_count--;
+        }
+    } else {
+        for( auto list_it = overflow->begin(); list_it != overflow->end(); ++list_it ) {
+            if( &*list_it == entry ) {
+                overflow->erase( list_it );
+                break;
             }
         }
+    }
+    if( overflow && overflow->empty() ) {
+        overflow.reset();
+    }
+
+    draw_symbol = fd_null;
+    for( auto &fld : *this ) {
+        if (fieldlist[fld.first].priority >= fieldlist[draw_symbol].priority) {
+            draw_symbol = fld.first;
+        }
+    }
+    return iterator( this, next_entry( removed ) );
 }
 
 /*
@@ -2530,27 +2619,27 @@ Returns the number of fields existing on the current tile.
 */
 unsigned int field::fieldCount() const
 {
-    return field_list.size();
+    return inline_count + ( overflow ? overflow->size() : 0 );
 }
 
-std::map<field_id, field_entry>::iterator field::begin()
+field::iterator field::begin()
 {
-    return field_list.begin();
+    return iterator( this, next_entry( -1 ) );
 }
 
-std::map<field_id, field_entry>::const_iterator field::begin() const
+field::const_iterator field::begin() const
 {
-    return field_list.begin();
+    return const_iterator( this, next_entry( -1 ) );
 }
 
-std::map<field_id, field_entry>::iterator field::end()
+field::iterator field::end()
 {
-    return field_list.end();
+    return iterator( this, nullptr );
 }
 
-std::map<field_id, field_entry>::const_iterator field::end() const
+field::const_iterator field::end() const
 {
-    return field_list.end();
+    return const_iterator( this, nullptr );
 }
 
 /*
@@ -2565,7 +2654,7 @@ field_id field::fieldSymbol() const
 int field::move_cost() const
 {
     int current_cost = 0;
-    for( auto & fld : field_list ) {
+    for( auto & fld : *this ) {
         current_cost += fld.second.move_cost();
     }
     return current_cost;
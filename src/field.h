@@ -6,6 +6,10 @@
 #include <vector>
 #include <string>
 #include <map>
+#include <list>
+#include <memory>
+#include <iterator>
+#include <utility>
 #include <iosfwd>
 
 /*
@@ -175,12 +179,69 @@ private:
  * Use @ref findField to get the field entry of a specific type, or iterate over
  * all entries via @ref begin and @ref end (allows range based iteration).
  * There is @ref fieldSymbol to specific which field should be drawn on the map.
+ *
+ * Most squares have no more than one entry, it is stored inline, any further
+ * ones in a list. Entries never move when others are added, so pointers to them stay valid
+ * while fields spread, but removing an entry may move the others.
 */
 class field{
 public:
+    typedef std::pair<field_id, field_entry> value_type;
+
+    /**
+     * Visits the entries in ascending order of their type. Entries added while iterating
+     * are visited if their type comes after the current one.
+     */
+    template<typename F, typename V>
+    class entry_iterator : public std::iterator<std::forward_iterator_tag, V> {
+    public:
+        entry_iterator() : owner( nullptr ), cur( nullptr ) {}
+        entry_iterator( F *owner, V *cur ) : owner( owner ), cur( cur ) {}
+        // iterator to const_iterator
+        template<typename F2, typename V2>
+        entry_iterator( const entry_iterator<F2, V2> &other ) : owner( other.owner ), cur( other.cur ) {}
+
+        V &operator*() const {
+            return *cur;
+        }
+        V *operator->() const {
+            return cur;
+        }
+        entry_iterator &operator++() {
+            cur = owner->next_entry( cur->first );
+            return *this;
+        }
+        entry_iterator operator++( int ) {
+            entry_iterator old = *this;
+            ++*this;
+            return old;
+        }
+        bool operator==( const entry_iterator &other ) const {
+            return cur == other.cur;
+        }
+        bool operator!=( const entry_iterator &other ) const {
+            return cur != other.cur;
+        }
+
+    private:
+        template<typename F2, typename V2>
+        friend class entry_iterator;
+        friend class field;
+
+        F *owner;
+        V *cur;
+    };
+    typedef entry_iterator<field, value_type> iterator;
+    typedef entry_iterator<const field, const value_type> const_iterator;
+
     field();
+    field( const field &other );
+    field( field && ) = default;
     ~field();
 
+    field &operator=( const field &other );
+    field &operator=( field && ) = default;
+
     /**
      * Returns a field entry corresponding to the field_id parameter passed in.
      * If no fields are found then nullptr is returned.
@@ -215,9 +276,10 @@ public:
     bool removeField( field_id field_to_remove );
     /**
      * Make sure to decrement the field counter in the submap.
-     * Removes the field entry, the iterator must point into @ref field_list and must be valid.
+     * Removes the field entry, the iterator must be valid and not the end.
+     * @return Iterator to the entry following the removed one.
      */
-    void removeField( std::map<field_id, field_entry>::iterator );
+    iterator removeField( iterator it );
 
     //Returns the number of fields existing on the current tile.
     unsigned int fieldCount() const;
@@ -227,13 +289,13 @@ public:
      */
     field_id fieldSymbol() const;
 
-    //Returns the vector iterator to begin searching through the list.
-    std::map<field_id, field_entry>::iterator begin();
-    std::map<field_id, field_entry>::const_iterator begin() const;
+    //Returns the iterator to begin searching through the list.
+    iterator begin();
+    const_iterator begin() const;
 
-    //Returns the vector iterator to end searching through the list.
-    std::map<field_id, field_entry>::iterator end();
-    std::map<field_id, field_entry>::const_iterator end() const;
+    //Returns the iterator to end searching through the list.
+    iterator end();
+    const_iterator end() const;
 
     /**
      * Returns the total move cost from all fields.
@@ -241,8 +303,23 @@ public:
     int move_cost() const;
 
 private:
-    std::map<field_id, field_entry> field_list; //A pointer lookup table of all field effects on the current tile.    //Draw_symbol currently is equal to the last field added to the square. You can modify this behavior in the class functions if you wish.
+    // More would make an empty field larger than the std::map it replaced
+    static constexpr int INLINE_ENTRIES = 1;
+
+    // Entry with the lowest type greater than `after`, nullptr if none
+    value_type *next_entry( int after );
+    const value_type *next_entry( int after ) const;
+    value_type *find_entry( field_id type );
+
+    // The first entries, only [0, inline_count) are in use.
+    value_type inline_entries[INLINE_ENTRIES];
+    //Draw_symbol currently is equal to the last field added to the square. You can modify this behavior in the class functions if you wish.
     field_id draw_symbol;
+    unsigned char inline_count;
+    // Entries that didn't fit inline, nullptr unless all of those are in use.
+    std::unique_ptr< std::list<value_type> > overflow;
 };
 
+static_assert( sizeof( field ) <= sizeof( std::map<field_id, field_entry> ), "an empty field shouldn't grow" );
+
 #endif
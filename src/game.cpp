@@ -44,6 +44,10 @@
 #include "debug.h"
 #include "catalua.h"
 #include "sounds.h"
+#include "turn_profiler.h"
+#include "sight_cache.h"
+#include "thread_pool.h"
+#include "save_worker.h"
 #include "iuse_actor.h"
 #include "mutation.h"
 #include "mtype.h"
@@ -589,6 +593,7 @@ void game::setup()
             elem_j = 0;
         }
     }
+    find_scent_region();
 
     load_auto_pickup(false); // Load global auto pickup rules
 
@@ -790,6 +795,11 @@ bool game::cleanup_at_end()
         save_maps(); //Omap also contains the npcs who need to be saved.
     }
 
+    // Maps and overmaps are written in the background, wait for the files before moving on.
+    if( !save_worker::instance().wait() ) {
+        popup(_("Failed to save the maps"));
+    }
+
     if (uquit == QUIT_DIED || uquit == QUIT_SUICIDE) {
         std::vector<std::string> vRip;
 
@@ -1148,7 +1158,10 @@ bool game::do_turn()
         gamemode->per_turn();
         calendar::turn.increment();
     }
-    process_events();
+    {
+        turn_profiler::scoped_timer timer( turn_profiler::PHASE_EVENTS );
+        process_events();
+    }
     mission::process_all();
     if (calendar::turn.hours() == 0 && calendar::turn.minutes() == 0 &&
         calendar::turn.seconds() == 0) { // Midnight!
@@ -1236,36 +1249,69 @@ bool game::do_turn()
             calc_driving_offset(veh);
         }
     }
-    update_scent();
+    {
+        turn_profiler::scoped_timer timer( turn_profiler::PHASE_SCENT );
+        update_scent();
+    }
 
-    m.vehmove();
+    {
+        turn_profiler::scoped_timer timer( turn_profiler::PHASE_VEHMOVE );
+        m.vehmove();
+    }
 
-    // Process power and fuel consumption for all vehicles, including off-map ones.
-    // m.vehmove used to do this, but now it only give them moves instead.
-    for( auto &elem : MAPBUFFER ) {
-        tripoint sm_loc = elem.first;
-        point sm_topleft = overmapbuffer::sm_to_ms_copy(sm_loc.x, sm_loc.y);
-        point in_reality = m.getlocal(sm_topleft);
+    {
+        // Process power and fuel consumption for all vehicles, including off-map ones.
+        // m.vehmove used to do this, but now it only give them moves instead.
+        turn_profiler::scoped_timer timer( turn_profiler::PHASE_VEHICLE_POWER );
+        for( auto &elem : MAPBUFFER ) {
+            tripoint sm_loc = elem.first;
+            point sm_topleft = overmapbuffer::sm_to_ms_copy(sm_loc.x, sm_loc.y);
+            point in_reality = m.getlocal(sm_topleft);
 
-        submap *sm = elem.second;
+            submap *sm = elem.second;
 
-        const bool in_bubble_z = m.has_zlevels() || sm_loc.z == get_levz();
-        for( auto &veh : sm->vehicles ) {
-            veh->power_parts( sm_loc );
-            veh->idle( in_bubble_z && m.inbounds(in_reality.x, in_reality.y) );
+            const bool in_bubble_z = m.has_zlevels() || sm_loc.z == get_levz();
+            for( auto &veh : sm->vehicles ) {
+                veh->power_parts( sm_loc );
+                veh->idle( in_bubble_z && m.inbounds(in_reality.x, in_reality.y) );
+            }
         }
     }
-    m.process_fields();
-    m.process_active_items();
+    {
+        turn_profiler::scoped_timer timer( turn_profiler::PHASE_FIELDS );
+        m.process_fields();
+    }
+    {
+        turn_profiler::scoped_timer timer( turn_profiler::PHASE_ACTIVE_ITEMS );
+        m.process_active_items();
+    }
     m.creature_in_field( u );
 
-    // Apply sounds from previous turn to monster and NPC AI.
-    sounds::process_sounds();
-    // Update vision caches for monsters. If this turns out to be expensive,
-    // consider a stripped down cache just for monsters.
-    m.build_map_cache( get_levz() );
-    monmove();
-    update_stair_monsters();
+    {
+        // Apply sounds from previous turn to monster and NPC AI.
+        turn_profiler::scoped_timer timer( turn_profiler::PHASE_SOUNDS );
+        sounds::process_sounds();
+    }
+    {
+        // Update vision caches for monsters. If this turns out to be expensive,
+        // consider a stripped down cache just for monsters.
+        turn_profiler::scoped_timer timer( turn_profiler::PHASE_MAP_CACHE );
+        m.build_map_cache( get_levz() );
+    }
+    {
+        turn_profiler::scoped_timer timer( turn_profiler::PHASE_MONMOVE );
+        monmove();
+    }
+    {
+        turn_profiler::scoped_timer timer( turn_profiler::PHASE_STAIR_MONSTERS );
+        update_stair_monsters();
+    }
+    {
+        // Nothing but the grid of the map holds on to submaps between turns
+        turn_profiler::scoped_timer timer( turn_profiler::PHASE_MAP_EVICTION );
+        MAPBUFFER.evict( m, size_t( int( OPTIONS["MAP_MEMORY_BUDGET"] ) ) * 1024 * 1024 );
+    }
+    turn_profiler::end_turn( calendar::turn );
     u.process_turn();
     u.process_active_items();
 
@@ -2158,6 +2204,21 @@ void game::setremoteveh(vehicle *veh)
     u.set_value( "remote_controlling_vehicle", remote_veh_string.str() );
 }
 
+const flow_field &game::player_flow_field()
+{
+    if( u_flow_field == nullptr ) {
+        u_flow_field = std::unique_ptr<flow_field>( new flow_field() );
+    }
+
+    u_flow_field->update( m, u.pos3(), calendar::turn );
+    return *u_flow_field;
+}
+
+bool game::player_flow_field_active() const
+{
+    return u_flow_field_active;
+}
+
 bool game::handle_action()
 {
     std::string action;
@@ -2909,6 +2970,7 @@ bool game::handle_action()
             return false;
 
         case ACTION_QUICKLOAD:
+            save_worker::instance().wait();
             MAPBUFFER.reset();
             overmap_buffer.clear();
             setup();
@@ -3024,15 +3086,46 @@ bool outside_scent_radius( const tripoint &p ) {
            p.y < (SEEY * MAPSIZE / 2) - SCENT_RADIUS || p.y >= (SEEY * MAPSIZE / 2) + SCENT_RADIUS;
 }
 
-int &game::scent( const tripoint &p )
+int game::scent( const tripoint &p ) const
 {
     if( outside_scent_radius( p ) ) {
-        nulscent = 0;
-        return nulscent; // Out-of-bounds - null scent
+        return 0; // Out-of-bounds - null scent
     }
     return grscent[p.x][p.y];
 }
 
+void game::set_scent( const tripoint &p, const int value )
+{
+    if( outside_scent_radius( p ) || grscent[p.x][p.y] == value ) {
+        return;
+    }
+    grscent[p.x][p.y] = value;
+    scent_settled = false;
+    if( value != 0 ) {
+        scent_active_min.x = std::min( scent_active_min.x, p.x );
+        scent_active_min.y = std::min( scent_active_min.y, p.y );
+        scent_active_max.x = std::max( scent_active_max.x, p.x );
+        scent_active_max.y = std::max( scent_active_max.y, p.y );
+    }
+}
+
+void game::find_scent_region()
+{
+    scent_active_min = point( SEEX * MAPSIZE, SEEY * MAPSIZE );
+    scent_active_max = point( -1, -1 );
+    for( int x = 0; x < SEEX * MAPSIZE; x++ ) {
+        for( int y = 0; y < SEEY * MAPSIZE; y++ ) {
+            if( grscent[x][y] != 0 ) {
+                scent_active_min.x = std::min( scent_active_min.x, x );
+                scent_active_min.y = std::min( scent_active_min.y, y );
+                scent_active_max.x = std::max( scent_active_max.x, x );
+                scent_active_max.y = std::max( scent_active_max.y, y );
+            }
+        }
+    }
+    scent_settled = false;
+}
+
 void game::update_scent()
 {
     static tripoint player_last_position = tripoint_min;
@@ -3046,103 +3139,72 @@ void game::update_scent()
     } else {
         player_last_position = u.pos();
         player_last_moved = calendar::turn;
+        // The diffused area moves along
+        scent_settled = false;
     }
 
-    // note: the next four intermediate matrices need to be at least
-    // [2*SCENT_RADIUS+3][2*SCENT_RADIUS+1] in size to hold enough data
-    // The code I'm modifying used [SEEX * MAPSIZE]. I'm staying with that to avoid new bugs.
-
-    // These two matrices are transposed so that x addresses are contiguous in memory
-    int sum_3_scent_y[SEEY * MAPSIZE][SEEX * MAPSIZE];  //intermediate variable
-    int squares_used_y[SEEY * MAPSIZE][SEEX * MAPSIZE]; //intermediate variable
-
-    // these are for caching flag lookups
-    bool blocks_scent[SEEX * MAPSIZE][SEEY * MAPSIZE]; // currently only TFLAG_WALL blocks scent
-    bool reduces_scent[SEEX * MAPSIZE][SEEY * MAPSIZE];
-
-
     // for loop constants
     const int scentmap_minx = u.posx() - SCENT_RADIUS;
     const int scentmap_maxx = u.posx() + SCENT_RADIUS;
     const int scentmap_miny = u.posy() - SCENT_RADIUS;
     const int scentmap_maxy = u.posy() + SCENT_RADIUS;
 
-    const int diffusivity = 100; // decrease this to reduce gas spread. Keep it under 125 for
-    // stability. This is essentially a decimal number * 1000.
-
     // No-scent debug mutation has to be processed here or else it takes time to start working
     if( !u.has_active_bionic("bio_scent_mask") && !u.has_trait("DEBUG_NOSCENT") ) {
-        grscent[u.posx()][u.posy()] = u.scent;
-    }
-
-    // The new scent flag searching function. Should be wayyy faster than the old one.
-    m.scent_blockers( blocks_scent, reduces_scent,
-                      scentmap_minx, scentmap_miny, scentmap_maxx, scentmap_maxy );
-    // Sum neighbors in the y direction.  This way, each square gets called 3 times instead of 9
-    // times. This cost us an extra loop here, but it also eliminated a loop at the end, so there
-    // is a net performance improvement over the old code. Could probably still be better.
-    // note: this method needs an array that is one square larger on each side in the x direction
-    // than the final scent matrix. I think this is fine since SCENT_RADIUS is less than
-    // SEEX*MAPSIZE, but if that changes, this may need tweaking.
-    for (int x = scentmap_minx - 1; x <= scentmap_maxx + 1; ++x) {
-        for (int y = scentmap_miny; y <= scentmap_maxy; ++y) {
-            // remember the sum of the scent val for the 3 neighboring squares that can defuse into
-            sum_3_scent_y[y][x] = 0;
-            squares_used_y[y][x] = 0;
-            for (int i = y - 1; i <= y + 1; ++i) {
-                if (! blocks_scent[x][i]) {
-                    if (reduces_scent[x][i]) {
-                        // only 20% of scent can diffuse on REDUCE_SCENT squares
-                        sum_3_scent_y[y][x] += 2 * grscent[x][i];
-                        squares_used_y[y][x] += 2;
-                    } else {
-                        sum_3_scent_y[y][x] += 10 * grscent[x][i];
-                        squares_used_y[y][x] += 10;
-                    }
-                }
-            }
-        }
+        set_scent( u.pos(), u.scent );
     }
 
-    // Rest of the scent map
-    for (int x = scentmap_minx; x <= scentmap_maxx; ++x) {
-        for (int y = scentmap_miny; y <= scentmap_maxy; ++y) {
-            if (! blocks_scent[x][y]) {
-                // to how many neighboring squares do we diffuse out? (include our own square
-                // since we also include our own square when diffusing in)
-                int squares_used = squares_used_y[y][x - 1]
-                                   + squares_used_y[y][x]
-                                   + squares_used_y[y][x + 1];
+    // Another step would give the same result as the last one, unless scent blockers changed
+    if( scent_settled && !m.access_cache( u.posz() ).scent_cache_dirty ) {
+        return;
+    }
 
-                int this_diffusivity;
-                if (! reduces_scent[x][y]) {
-                    this_diffusivity = diffusivity;
-                } else {
-                    this_diffusivity = diffusivity / 5; //less air movement for REDUCE_SCENT square
-                }
-                int temp_scent;
-                // take the old scent and subtract what diffuses out
-                temp_scent = grscent[x][y] * (10 * 1000 - squares_used * this_diffusivity);
-                // neighboring walls and reduce_scent squares absorb some scent
-                temp_scent -= grscent[x][y] * this_diffusivity * (90 - squares_used) / 5;
-                // we've already summed neighboring scent values in the y direction in the previous
-                // loop. Now we do it for the x direction, multiply by diffusion, and this is what
-                // diffuses into our current square.
-                grscent[x][y] =
-                    (temp_scent
-                     + this_diffusivity * (sum_3_scent_y[y][x - 1]
-                                           + sum_3_scent_y[y][x]
-                                           + sum_3_scent_y[y][x + 1])
-                    ) / (1000 * 10);
+    // Tiles of the active box outside of the diffused area keep their scent. Only the sides
+    // of the box sticking out of it are kept, the rest is replaced by the new nonzero tiles.
+    point kept_min( SEEX * MAPSIZE, SEEY * MAPSIZE );
+    point kept_max( -1, -1 );
+    auto keep_box = [&]( const int minx, const int miny, const int maxx, const int maxy ) {
+        if( minx <= maxx && miny <= maxy ) {
+            kept_min.x = std::min( kept_min.x, minx );
+            kept_min.y = std::min( kept_min.y, miny );
+            kept_max.x = std::max( kept_max.x, maxx );
+            kept_max.y = std::max( kept_max.y, maxy );
+        }
+    };
+    const point &amin = scent_active_min;
+    const point &amax = scent_active_max;
+    keep_box( amin.x, amin.y, std::min( amax.x, scentmap_minx - 1 ), amax.y );
+    keep_box( std::max( amin.x, scentmap_maxx + 1 ), amin.y, amax.x, amax.y );
+    keep_box( amin.x, amin.y, amax.x, std::min( amax.y, scentmap_miny - 1 ) );
+    keep_box( amin.x, std::max( amin.y, scentmap_maxy + 1 ), amax.x, amax.y );
+
+    // Tiles further than one step from any scent stay at 0
+    const int minx = std::max( scentmap_minx, amin.x - 1 );
+    const int maxx = std::min( scentmap_maxx, amax.x + 1 );
+    const int miny = std::max( scentmap_miny, amin.y - 1 );
+    const int maxy = std::min( scentmap_maxy, amax.y + 1 );
+    if( minx > maxx || miny > maxy ) {
+        scent_settled = true;
+        return;
+    }
 
-                if (grscent[x][y] > 10000) {
-                    dbg(D_ERROR) << "game:update_scent: Wacky scent at " << x << ","
-                                 << y << " (" << grscent[x][y] << ")";
-                    debugmsg("Wacky scent at %d, %d (%d)", x, y, grscent[x][y]);
-                    grscent[x][y] = 0; // Scent should never be higher
-                }
-            } else { // this cell blocks scent
-                grscent[x][y] = 0;
+    scent_settled = !m.diffuse_scent( grscent, minx, miny, maxx, maxy );
+
+    scent_active_min = kept_min;
+    scent_active_max = kept_max;
+    for (int x = minx; x <= maxx; ++x) {
+        for (int y = miny; y <= maxy; ++y) {
+            if (grscent[x][y] > 10000) {
+                dbg(D_ERROR) << "game:update_scent: Wacky scent at " << x << ","
+                             << y << " (" << grscent[x][y] << ")";
+                debugmsg("Wacky scent at %d, %d (%d)", x, y, grscent[x][y]);
+                grscent[x][y] = 0; // Scent should never be higher
+                scent_settled = false;
+            } else if( grscent[x][y] != 0 ) {
+                scent_active_min.x = std::min( scent_active_min.x, x );
+                scent_active_min.y = std::min( scent_active_min.y, y );
+                scent_active_max.x = std::max( scent_active_max.x, x );
+                scent_active_max.y = std::max( scent_active_max.y, y );
             }
         }
     }
@@ -3292,6 +3354,7 @@ void game::load(std::string worldname, std::string name)
     u.weapon = item("null", 0);
     unserialize(fin);
     fin.close();
+    find_scent_region();
 
     // weather
     std::string wfile = std::string(worldpath + base64_encode(u.name) + ".weather");
@@ -3405,8 +3468,9 @@ bool game::save_maps()
 {
     try {
         m.save();
-        overmap_buffer.save(); // can throw std::ios::failure
-        MAPBUFFER.save(); // can throw std::ios::failure
+        // Both are written in the background, failures show up in save_worker::wait
+        overmap_buffer.save();
+        MAPBUFFER.save();
         return true;
     } catch (std::ios::failure &) {
         popup(_("Failed to save the maps"));
@@ -3502,6 +3566,7 @@ static bool isForbidden(std::string candidate)
 // If it's false, just avoid deleting the two config files and the directory itself.
 void game::delete_world(std::string worldname, bool delete_folder)
 {
+    save_worker::instance().wait();
     std::string worldpath = world_generator->all_worlds[worldname]->world_path;
     std::set<std::string> directory_paths;
 
@@ -3686,6 +3751,8 @@ void game::debug()
                       _("Display weather"), // 25
                       _("Change time"), // 26
                       _("Set automove route"), // 27
+                      _("Turn profiler"), // 28
+                      _("Map buffer statistics"), // 29
                       _("Cancel"),
                       NULL);
     int veh_num;
@@ -4212,6 +4279,48 @@ void game::debug()
     }
     break;
 
+    case 28:
+    {
+        const std::string trace_path = FILENAMES["user_dir"] + "turn_profile.csv";
+        const int choice = menu( true, _("Turn profiler"),
+                                 turn_profiler::is_enabled() ? _("Stop profiling") : _("Start profiling"),
+                                 _("Show phase timings"),
+                                 turn_profiler::overlay_enabled() ? _("Hide overlay") : _("Show overlay"),
+                                 turn_profiler::is_tracing() ? _("Stop CSV trace") : _("Start CSV trace"),
+                                 _("Cancel"),
+                                 NULL );
+        switch( choice ) {
+        case 1:
+            turn_profiler::set_enabled( !turn_profiler::is_enabled() );
+            break;
+        case 2:
+            turn_profiler::show_stats();
+            break;
+        case 3:
+            turn_profiler::set_overlay( !turn_profiler::overlay_enabled() );
+            break;
+        case 4:
+            if( turn_profiler::is_tracing() ) {
+                turn_profiler::stop_trace();
+            } else if( turn_profiler::start_trace( trace_path ) ) {
+                popup( _( "Writing the duration of each turn to %s" ), trace_path.c_str() );
+            } else {
+                popup( _( "Can't open %s" ), trace_path.c_str() );
+            }
+            break;
+        }
+    }
+    break;
+
+    case 29:
+    {
+        const mapbuffer::memory_stats stats = MAPBUFFER.get_memory_stats();
+        popup( "%d submaps in %d quads, about %d KB\nBudget %d MB\n%d quads evicted so far",
+               int( stats.submaps ), int( stats.quads ), int( stats.bytes / 1024 ),
+               int( OPTIONS["MAP_MEMORY_BUDGET"] ), int( stats.evicted_quads ) );
+    }
+    break;
+
     }
     erase();
     refresh_all();
@@ -4745,6 +4854,9 @@ void game::draw()
     // Draw map
     werase(w_terrain);
     draw_ter();
+    if( turn_profiler::overlay_enabled() ) {
+        turn_profiler::draw_overlay( w_terrain );
+    }
     if( !is_draw_tiles_mode() ) {
         wrefresh(w_terrain);
     }
@@ -5468,14 +5580,10 @@ Creature *game::is_hostile_within(int distance)
 std::vector<monster*> game::get_fishable(int distance)
 {
     std::vector<monster*> unique_fish;
-    for (size_t i = 0; i < num_zombies(); i++) {
+    for( const int i : critter_tracker->monsters_within_radius( u.pos(), distance ) ) {
         monster &critter = critter_tracker->find(i);
-
         if (critter.has_flag(MF_FISHABLE)) {
-            int mondist = rl_dist( u.pos(), critter.pos() );
-            if (mondist <= distance) {
             unique_fish.push_back (&critter);
-            }
         }
     }
 
@@ -5622,7 +5730,7 @@ int game::mon_info(WINDOW *w)
                 monster &critter = critter_tracker->find(new_seen_mon.back());
                 cancel_activity_query(_("%s spotted!"), critter.name().c_str());
                 if (u.has_trait("M_DEFENDER")) {
-                    if (critter.type->in_species("PLANT")) {
+                    if (critter.type->in_species(species_plant)) {
                         add_msg(m_warning, _("We have detected a %s."), critter.name().c_str());
                         if (!u.has_effect("adrenaline_mycus")){
                             u.add_effect("adrenaline_mycus", 300);
@@ -5809,6 +5917,7 @@ void game::cleanup_dead()
             const int npc_id = n->getID();
             it = active_npc.erase( it );
             overmap_buffer.remove_npc( npc_id );
+            sight_cache::invalidate();
         } else {
             it++;
         }
@@ -5819,29 +5928,39 @@ void game::monmove()
 {
     cleanup_dead();
 
-    // Make sure these don't match the first time around.
-    tripoint cached_lev = m.get_abs_sub() + tripoint( 1, 0, 0 );
+    // monster::plan() looks up allies and enemies by faction, friendliness may have changed since
+    // the last turn.
+    critter_tracker->update_factions();
 
-    mfactions monster_factions;
-    const auto &playerfaction = mfaction_str_id( "player" );
-    for (size_t i = 0; i < num_zombies(); i++) {
-        // The first time through, and any time the map has been shifted,
-        // recalculate monster factions.
-        if( cached_lev != m.get_abs_sub() ) {
-            // monster::plan() needs to know about all monsters on the same team as the monster.
-            monster_factions.clear();
-            for( int i = 0, numz = num_zombies(); i < numz; i++ ) {
-                monster &critter = zombie( i );
-                if( critter.friendly == 0 ) {
-                    // Only 1 faction per mon at the moment.
-                    monster_factions[ critter.faction ].insert( i );
-                } else {
-                    monster_factions[ playerfaction ].insert( i );
-                }
+    // Choosing targets only reads the world, so it's done for all monsters at once before any
+    // of them moves. Everything random (and every change) happens in the loop below, in the
+    // same order as always, so the results don't depend on the number of threads.
+    {
+        // Lazily computed, so do it before the threads read it
+        light_level();
+        // The sight checks of a monster shouldn't depend on the thread that checked before
+        sight_cache::invalidate();
+        thread_pool::instance().run( num_zombies(), [&]( const int i ) {
+            monster &critter = zombie( i );
+            if( !critter.is_dead() ) {
+                critter.prepare_plan();
             }
-            cached_lev = m.get_abs_sub();
+        } );
+        sight_cache::invalidate();
+    }
+
+    // The flow field pays off for hordes, a few monsters keep walking in straight lines
+    const std::string flow_field_option = OPTIONS["MONSTER_FLOW_FIELD"].getValue();
+    size_t chasers = 0;
+    if( flow_field_option == "groups" ) {
+        for( size_t i = 0; i < num_zombies(); i++ ) {
+            chasers += zombie( i ).can_follow_flow_field();
         }
+    }
+    u_flow_field_active = flow_field_option == "always" ||
+                          ( flow_field_option == "groups" && chasers >= FLOW_FIELD_MIN_CHASERS );
 
+    for (size_t i = 0; i < num_zombies(); i++) {
         monster &critter = critter_tracker->find(i);
         while (!critter.is_dead() && !critter.can_move_to(critter.pos3())) {
             // If we can't move to our current position, assign us to a new one
@@ -5881,16 +6000,17 @@ void game::monmove()
             // Controlled critters don't make their own plans
             if (!critter.has_effect("controlled")) {
                 // Formulate a path to follow
-                critter.plan( monster_factions );
+                critter.plan();
             }
             critter.move(); // Move one square, possibly hit u
             critter.process_triggers();
             m.creature_in_field( critter );
         }
+    }
 
-        if (!critter.is_dead()) {
-            if (u.has_active_bionic("bio_alarm") && u.power_level >= 25 &&
-                rl_dist( u.pos(), critter.pos() ) <= 5) {
+    if( u.has_active_bionic( "bio_alarm" ) ) {
+        for( const int i : critter_tracker->monsters_within_radius( u.pos(), 5 ) ) {
+            if( !zombie( i ).is_dead() && u.power_level >= 25 ) {
                 u.charge_power(-25);
                 add_msg(m_warning, _("Your motion alarm goes off!"));
                 cancel_activity_query(_("Your motion alarm goes off!"));
@@ -6109,19 +6229,17 @@ void game::flashbang( const tripoint &p, bool player_immune)
             u.add_env_effect("blind", bp_eyes, (12 - flash_mod - dist) / 2, 10 - dist);
         }
     }
-    for( size_t i = 0; i < num_zombies(); i++ ) {
+    for( const int i : critter_tracker->monsters_within_radius( p, 8 ) ) {
         monster &critter = critter_tracker->find(i);
         dist = rl_dist( critter.pos3(), p );
         if( dist <= 4 ) {
             critter.add_effect("stunned", 10 - dist);
         }
-        if( dist <= 8 ) {
-            if( critter.has_flag(MF_SEES) && m.sees( critter.pos3(), p, 8 ) ) {
-                critter.add_effect("blind", 18 - dist);
-            }
-            if( critter.has_flag(MF_HEARS) ) {
-                critter.add_effect("deaf", 60 - dist * 4);
-            }
+        if( critter.has_flag(MF_SEES) && m.sees( critter.pos3(), p, 8 ) ) {
+            critter.add_effect("blind", 18 - dist);
+        }
+        if( critter.has_flag(MF_HEARS) ) {
+            critter.add_effect("deaf", 60 - dist * 4);
         }
     }
     sounds::sound( p, 12, _("a huge boom!"));
@@ -6134,7 +6252,8 @@ void game::shockwave( const tripoint &p, int radius, int force, int stun, int da
     draw_explosion( p, radius, c_blue );
 
     sounds::sound( p, force * force * dam_mult / 2, _("Crack!") );
-    for (size_t i = 0; i < num_zombies(); i++) {
+    // Knockback may push other monsters around, so the distance is checked again
+    for( const int i : critter_tracker->monsters_within_radius( p, radius ) ) {
         monster &critter = critter_tracker->find(i);
         if( rl_dist( critter.pos3(), p ) <= radius ) {
             add_msg(_("%s is caught in the shockwave!"), critter.name().c_str());
@@ -7618,7 +7737,7 @@ bool pet_menu(monster *z)
     uimenu amenu;
 
     std::string pet_name = _("dog");
-    if( z->type->in_species("ZOMBIE") ) {
+    if( z->type->in_species(species_zombie) ) {
         pet_name = _("zombie slave");
     }
 
@@ -7647,7 +7766,7 @@ bool pet_menu(monster *z)
         }
     }
 
-    if( z->type->in_species("ZOMBIE") ) {
+    if( z->type->in_species(species_zombie) ) {
         amenu.addentry(pheromone, true, 't', _("Tear out pheromone ball"));
     }
 
@@ -8012,7 +8131,8 @@ void game::print_terrain_info( const tripoint &lp, WINDOW *w_look, int column, i
         tile += "; " + furn.name;
         if( furn.has_flag( "PLANT" ) && !m.i_at( lp ).empty() ) {
             // Plant types are defined by seeds.
-            const item &seed = m.i_at( lp )[0];
+            const map_stack items = m.i_at( lp );
+            const item &seed = items[0];
             tile += " (" + seed.get_plant_name() + ")";
         }
     }
@@ -12894,6 +13014,7 @@ void game::vertical_move(int movez, bool force)
             grscent[x][y] = 0;
         }
     }
+    find_scent_region();
 
     // Figure out where we know there are up/down connectors
     // Fill in all the tiles we know about (e.g. subway stations)
@@ -12933,6 +13054,8 @@ void game::vertical_move(int movez, bool force)
         m.access_cache( z_before ).vehicle_list.clear();
         m.set_transparency_cache_dirty( z_before );
         m.set_outside_cache_dirty( z_before );
+        m.set_pathfinding_cache_dirty( z_before );
+        m.set_scent_cache_dirty( z_before );
         m.load( get_levx(), get_levy(), z_after, true );
     }
 
@@ -13050,9 +13173,12 @@ void game::update_map(int &x, int &y)
     }
     for( tmp.x = 0; tmp.x < SEEX * MAPSIZE; tmp.x++ ) {
         for( tmp.y = 0; tmp.y < SEEY * MAPSIZE; tmp.y++ ) {
-            scent(tmp) = newscent[tmp.x][tmp.y];
+            if( !outside_scent_radius( tmp ) ) {
+                grscent[tmp.x][tmp.y] = newscent[tmp.x][tmp.y];
+            }
         }
     }
+    find_scent_region();
 
     // Make sure map cache is consistent since it may have shifted.
     m.build_map_cache( get_levz() );
@@ -73,6 +73,7 @@ class player;
 class npc;
 class monster;
 class Creature_tracker;
+class flow_field;
 class calendar;
 class scenario;
 class DynamicDataLoader;
@@ -113,6 +114,8 @@ class game
         /** Initializes the UI. */
         void init_ui();
         void setup();
+        /** Starts a new game in a world, for the character in @ref u. Used by the main menu. */
+        void start_game(std::string worldname);
         /** Returns true if we actually quit the game. Used in main.cpp. */
         bool game_quit();
         /** Returns true if the game quits through some error. */
@@ -264,6 +267,17 @@ class game
         /** Sets the current remotely controlled vehicle. */
         void setremoteveh(vehicle *veh);
 
+        /**
+         * Distance map toward the player, computed at most once per turn.
+         * Monsters chasing the player follow it while @ref player_flow_field_active.
+         */
+        const flow_field &player_flow_field();
+        /**
+         * Whether monsters chasing the player follow @ref player_flow_field this turn. Set by
+         * monmove from the MONSTER_FLOW_FIELD option and the number of monsters chasing the player.
+         */
+        bool player_flow_field_active() const;
+
         /** Returns the next available mission id. */
         int assign_mission_id();
         npc *find_npc(int id);
@@ -289,7 +303,10 @@ class game
         void nuke( const tripoint &p );
         bool spread_fungus( const tripoint &p );
         std::vector<faction *> factions_at( const tripoint &p );
-        int &scent( const tripoint &p );
+        /** Scent at p on the current z-level, 0 outside of the scent map. */
+        int scent( const tripoint &p ) const;
+        /** Sets the scent at p on the current z-level, ignored outside of the scent map. */
+        void set_scent( const tripoint &p, int value );
         float ground_natural_light_level() const;
         float natural_light_level() const;
         unsigned char light_level();
@@ -513,7 +530,6 @@ class game
         bool load_master(std::string worldname); // Load the master data file, with factions &c
         void load_weather(std::ifstream &fin);
         void load(std::string worldname, std::string name); // Load a player-specific save file
-        void start_game(std::string worldname); // Starts a new game in a world
         void start_special_game(special_game_id gametype); // See gamemode.cpp
 
         //private save functions.
@@ -669,6 +685,7 @@ class game
         bool disable_robot( const tripoint &p );
 
         void update_scent();     // Updates the scent map
+        void find_scent_region(); // Recomputes the active box of grscent after it was changed directly
         bool is_game_over();     // Returns true if the player quit or died
         void death_screen();     // Display our stats, "GAME OVER BOO HOO"
         void gameover();         // Ends the game
@@ -716,7 +733,12 @@ class game
         calendar nextweather; // The turn on which weather will shift next.
         int next_npc_id, next_faction_id, next_mission_id; // Keep track of UIDs
         int grscent[SEEX *MAPSIZE][SEEY *MAPSIZE];   // The scent map
-        int nulscent;    // Returned for OOB scent checks
+        // Bounding box of the tiles of grscent that may be nonzero, empty if min.x > max.x.
+        // update_scent only diffuses this box (and its border).
+        point scent_active_min;
+        point scent_active_max;
+        // Set when a diffusion step changed nothing and nothing changed since then
+        bool scent_settled;
         std::list<event> events;         // Game events to be processed
         std::map<std::string, int> kills;         // Player's kill count
         int moves_since_last_save;
@@ -726,6 +748,9 @@ class game
         // remoteveh() cache
         int remoteveh_cache_turn;
         vehicle *remoteveh_cache;
+        // player_flow_field() cache
+        std::unique_ptr<flow_field> u_flow_field;
+        bool u_flow_field_active = false;
 
         special_game *gamemode;
 
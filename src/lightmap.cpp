@@ -7,7 +7,9 @@
 #include "monster.h"
 #include "veh_type.h"
 #include "vehicle.h"
+#include "thread_pool.h"
 
+#include <algorithm>
 #include <cmath>
 #include <cstring>
 
@@ -37,22 +39,44 @@ void map::add_light_from_items( const int x, const int y, std::list<item>::itera
     }
 }
 
+void map::set_transparency_cache_dirty( const tripoint &p )
+{
+    if( inbounds( p ) ) {
+        get_cache( p.z ).transparency_dirty_submaps.set( ( p.x / SEEX ) * MAPSIZE + p.y / SEEY );
+    }
+}
+
+std::bitset<MAPSIZE*MAPSIZE> map::transparency_changes( const int zlev, int &generation ) const
+{
+    const auto &ch = get_cache( zlev );
+    std::bitset<MAPSIZE*MAPSIZE> changes;
+    for( size_t i = 0; i < changes.size(); i++ ) {
+        changes[i] = ch.transparency_changed_at[i] > generation;
+    }
+    generation = ch.transparency_generation;
+    return changes;
+}
+
 // TODO Consider making this just clear the cache and dynamically fill it in as trans() is called
 void map::build_transparency_cache( const int zlev )
 {
     auto &ch = get_cache( zlev );
     auto &transparency_cache = ch.transparency_cache;
-    if( !ch.transparency_cache_dirty ) {
+    if( ch.transparency_cache_dirty ) {
+        // Default to fully transparent, also beyond the submaps of a smaller map
+        std::uninitialized_fill_n(
+            &transparency_cache[0][0], MAPSIZE*SEEX * MAPSIZE*SEEY, LIGHT_TRANSPARENCY_CLEAR);
+        ch.transparency_dirty_submaps.set();
+    } else if( ch.transparency_dirty_submaps.none() ) {
         return;
     }
 
-    // Default to fully transparent.
-    std::uninitialized_fill_n(
-        &transparency_cache[0][0], MAPSIZE*SEEX * MAPSIZE*SEEY, LIGHT_TRANSPARENCY_CLEAR);
-
-    // Traverse the submaps in order
+    // Traverse the dirty submaps in order
     for( int smx = 0; smx < my_MAPSIZE; ++smx ) {
         for( int smy = 0; smy < my_MAPSIZE; ++smy ) {
+            if( !ch.transparency_dirty_submaps[smx * MAPSIZE + smy] ) {
+                continue;
+            }
             auto const cur_submap = get_submap_at_grid( smx, smy, zlev );
 
             for( int sx = 0; sx < SEEX; ++sx ) {
@@ -61,6 +85,7 @@ void map::build_transparency_cache( const int zlev )
                     const int y = sy + smy * SEEY;
 
                     auto &value = transparency_cache[x][y];
+                    value = LIGHT_TRANSPARENCY_CLEAR;
 
                     if( !(terlist [cur_submap->ter[sx][sy]].transparent &&
                           furnlist[cur_submap->frn[sx][sy]].transparent) ) {
@@ -112,6 +137,12 @@ void map::build_transparency_cache( const int zlev )
             }
         }
     }
+    for( size_t i = 0; i < ch.transparency_dirty_submaps.size(); i++ ) {
+        if( ch.transparency_dirty_submaps[i] ) {
+            ch.transparency_changed( i );
+        }
+    }
+    ch.transparency_dirty_submaps.reset();
     ch.transparency_cache_dirty = false;
 }
 
@@ -129,6 +160,9 @@ void map::generate_lightmap( const int zlev )
     auto &sm = get_cache( zlev ).sm;
     std::memset(lm, 0, sizeof(lm));
     std::memset(sm, 0, sizeof(sm));
+    // Light sources are only collected first, apply_light_sources adds their light at the end
+    auto &light_sources = get_cache( zlev ).light_sources;
+    light_sources.clear();
 
     /* Bulk light sources wastefully cast rays into neighbors; a burning hospital can produce
          significant slowdown, so for stuff like fire and lava:
@@ -189,7 +223,12 @@ void map::generate_lightmap( const int zlev )
                         for(int i = 0; i < 4; ++i) {
                             if (INBOUNDS(x + dir_x[i], y + dir_y[i]) &&
                                 is_outside(x + dir_x[i], y + dir_y[i])) {
-                                lm[x][y] = natural_light;
+                                light_source fill = {};
+                                fill.type = light_source::FILL;
+                                fill.x = x;
+                                fill.y = y;
+                                fill.luminance = natural_light;
+                                light_sources.push_back( fill );
 
                                 if (light_transparency(x, y) > LIGHT_TRANSPARENCY_SOLID) {
                                     apply_light_arc(x, y, dir_d[i], natural_light);
@@ -388,6 +427,7 @@ void map::generate_lightmap( const int zlev )
         }
     }
 
+    apply_light_sources( zlev );
 
     if (g->u.has_active_bionic("bio_night") ) {
         for(int sx = 0; sx < LIGHTMAP_CACHE_X; ++sx) {
@@ -406,6 +446,87 @@ void map::add_light_source(int x, int y, float luminance )
     light_source_buffer[x][y] = std::max(luminance, light_source_buffer[x][y]);
 }
 
+void map::apply_light_sources( const int zlev )
+{
+    auto &ch = get_cache( zlev );
+    auto &lm = ch.lm;
+    auto &sm = ch.sm;
+    auto &light_cache = ch.light_cache;
+    const int generation = ++ch.light_generation;
+
+    // Submaps where the transparency of any square changed since the last time,
+    // only those that were rebuilt in between can have changed
+    const auto rebuilt = transparency_changes( zlev, ch.light_transparency_generation );
+    bool changed[MAPSIZE][MAPSIZE] = {};
+    for( int smx = 0; smx < MAPSIZE; smx++ ) {
+        for( int smy = 0; smy < MAPSIZE; smy++ ) {
+            if( !rebuilt[smx * MAPSIZE + smy] ) {
+                continue;
+            }
+            for( int x = smx * SEEX; x < ( smx + 1 ) * SEEX; x++ ) {
+                for( int y = smy * SEEY; y < ( smy + 1 ) * SEEY; y++ ) {
+                    if( ch.transparency_cache[x][y] != ch.light_transparency[x][y] ) {
+                        changed[smx][smy] = true;
+                        ch.light_transparency[x][y] = ch.transparency_cache[x][y];
+                    }
+                }
+            }
+        }
+    }
+    const auto is_outdated = [&changed]( const light_contribution &light ) {
+        for( int smx = std::max( light.min_x, 0 ) / SEEX; smx <= light.max_x / SEEX; smx++ ) {
+            for( int smy = std::max( light.min_y, 0 ) / SEEY; smy <= light.max_y / SEEY; smy++ ) {
+                if( changed[smx][smy] ) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    };
+
+    float *const lm_squares = &lm[0][0];
+    float *const sm_squares = &sm[0][0];
+    for( const light_source &source : ch.light_sources ) {
+        if( source.type == light_source::FILL ) {
+            lm[source.x][source.y] = source.luminance;
+            continue;
+        }
+
+        auto it = light_cache.find( source );
+        if( it == light_cache.end() || is_outdated( it->second ) ) {
+            light_contribution light;
+            if( source.type == light_source::ARC ) {
+                cast_light_arc( light, source );
+            } else {
+                cast_light_source( light, source );
+            }
+            if( it == light_cache.end() ) {
+                it = light_cache.emplace( source, std::move( light ) ).first;
+            } else {
+                it->second = std::move( light );
+            }
+        }
+        it->second.generation = generation;
+
+        // Same as applying the light directly, lights only ever brighten squares
+        for( const auto &square : it->second.lm ) {
+            lm_squares[square.first] = std::max( lm_squares[square.first], square.second );
+        }
+        for( const auto &square : it->second.sm ) {
+            sm_squares[square.first] = std::max( sm_squares[square.first], square.second );
+        }
+    }
+
+    // Forget the lights that are gone
+    for( auto it = light_cache.begin(); it != light_cache.end(); ) {
+        if( it->second.generation != generation ) {
+            it = light_cache.erase( it );
+        } else {
+            ++it;
+        }
+    }
+}
+
 // Tile light/transparency: 2D overloads
 
 lit_level map::light_at(int dx, int dy)
@@ -525,6 +646,54 @@ bool map::pl_sees( const tripoint &t, const int max_range )
     return get_cache( t.z ).seen_cache[t.x][t.y];
 }
 
+void map::build_field_of_view( const tripoint &origin, const int range, field_of_view &fov ) const
+{
+    fov.m = this;
+    fov.origin = origin;
+    fov.radius = range >= 0 && range < 60 ? range : 60;
+    std::memset( fov.reachable, false, sizeof( fov.reachable ) );
+    if( !inbounds( origin ) ) {
+        fov.radius = -1;
+        return;
+    }
+    fov.reachable[origin.x][origin.y] = true;
+
+    // Each step of a line goes one square away from the origin along one axis or both, and
+    // the line only goes on from transparent squares (see map::sees). One quadrant at a time,
+    // a square is reachable if one of the squares a step could have come from is the origin
+    // or reachable and transparent.
+    for( const int sx : { -1, 1 } ) {
+        for( const int sy : { -1, 1 } ) {
+            const auto passes = [&]( const int i, const int j ) {
+                if( i < 0 || j < 0 ) {
+                    return false;
+                }
+                const int x = origin.x + sx * i;
+                const int y = origin.y + sy * j;
+                return ( i == 0 && j == 0 ) || ( fov.reachable[x][y] && trans( x, y ) );
+            };
+            for( int i = 0; i <= fov.radius && INBOUNDS( origin.x + sx * i, origin.y ); i++ ) {
+                for( int j = 0; j <= fov.radius && INBOUNDS( origin.x + sx * i, origin.y + sy * j ); j++ ) {
+                    if( passes( i - 1, j ) || passes( i, j - 1 ) || passes( i - 1, j - 1 ) ) {
+                        fov.reachable[origin.x + sx * i][origin.y + sy * j] = true;
+                    }
+                }
+            }
+        }
+    }
+}
+
+bool field_of_view::sees( const tripoint &p, const int range, int &t1, int &t2 ) const
+{
+    if( p.z == origin.z && m->inbounds( p ) && square_dist( origin, p ) <= radius &&
+        !reachable[p.x][p.y] ) {
+        t1 = 0;
+        t2 = 0;
+        return false;
+    }
+    return m->sees( origin, p, range, t1, t2 );
+}
+
 /**
  * Calculates the Field Of View for the provided map from the given x, y
  * coordinates. Returns a lightmap for a result where the values represent a
@@ -547,17 +716,7 @@ void map::build_seen_cache(const tripoint &origin)
     std::memset(seen_cache, false, sizeof(seen_cache));
     seen_cache[origin.x][origin.y] = true;
 
-    castLight<0, 1, 1, 0>( seen_cache, transparency_cache, origin.x, origin.y, 0 );
-    castLight<1, 0, 0, 1>( seen_cache, transparency_cache, origin.x, origin.y, 0 );
-
-    castLight<0, -1, 1, 0>( seen_cache, transparency_cache, origin.x, origin.y, 0 );
-    castLight<-1, 0, 0, 1>( seen_cache, transparency_cache, origin.x, origin.y, 0 );
-
-    castLight<0, 1, -1, 0>( seen_cache, transparency_cache, origin.x, origin.y, 0 );
-    castLight<1, 0, 0, -1>( seen_cache, transparency_cache, origin.x, origin.y, 0 );
-
-    castLight<0, -1, -1, 0>( seen_cache, transparency_cache, origin.x, origin.y, 0 );
-    castLight<-1, 0, 0, -1>( seen_cache, transparency_cache, origin.x, origin.y, 0 );
+    castLightAll( seen_cache, transparency_cache, origin.x, origin.y, 0, &thread_pool::instance() );
 
     int part;
     if ( vehicle *veh = veh_at( origin, part ) ) {
@@ -608,25 +767,8 @@ void map::build_seen_cache(const tripoint &origin)
             //
             // The naive solution of making the mirrors act like a second player
             // at an offset appears to give reasonable results though.
-            castLight<0, 1, 1, 0>( seen_cache, transparency_cache,
-                                   mirror_pos.x, mirror_pos.y, offsetDistance );
-            castLight<1, 0, 0, 1>( seen_cache, transparency_cache,
-                                   mirror_pos.x, mirror_pos.y, offsetDistance );
-
-            castLight<0, -1, 1, 0>( seen_cache, transparency_cache,
-                                    mirror_pos.x, mirror_pos.y, offsetDistance );
-            castLight<-1, 0, 0, 1>( seen_cache, transparency_cache,
-                                    mirror_pos.x, mirror_pos.y, offsetDistance );
-
-            castLight<0, 1, -1, 0>( seen_cache, transparency_cache,
-                                    mirror_pos.x, mirror_pos.y, offsetDistance );
-            castLight<1, 0, 0, -1>( seen_cache, transparency_cache,
-                                    mirror_pos.x, mirror_pos.y, offsetDistance );
-
-            castLight<0, -1, -1, 0>( seen_cache, transparency_cache,
-                                     mirror_pos.x, mirror_pos.y, offsetDistance );
-            castLight<-1, 0, 0, -1>( seen_cache, transparency_cache,
-                                     mirror_pos.x, mirror_pos.y, offsetDistance );
+            castLightAll( seen_cache, transparency_cache, mirror_pos.x, mirror_pos.y,
+                          offsetDistance, &thread_pool::instance() );
         }
     }
 }
@@ -702,27 +844,69 @@ void castLight( bool (&output_cache)[MAPSIZE*SEEX][MAPSIZE*SEEY],
     }
 }
 
-void map::apply_light_source(int x, int y, float luminance, bool trig_brightcalc )
+void castLightAll( bool (&output_cache)[MAPSIZE*SEEX][MAPSIZE*SEEY],
+                   const float (&input_array)[MAPSIZE*SEEX][MAPSIZE*SEEY],
+                   const int offsetX, const int offsetY, const int offsetDistance,
+                   thread_pool *pool )
 {
-    auto &lm = get_cache( abs_sub.z ).lm;
-    auto &sm = get_cache( abs_sub.z ).sm;
-    if (INBOUNDS(x, y)) {
-        lm[x][y] = std::max(lm[x][y], static_cast<float>(LL_LOW));
-        lm[x][y] = std::max(lm[x][y], luminance);
-        sm[x][y] = std::max(sm[x][y], luminance);
-    }
-    if ( luminance <= 1 ) {
+    typedef void ( *octant_caster )( bool (&)[MAPSIZE*SEEX][MAPSIZE*SEEY],
+                                     const float (&)[MAPSIZE*SEEX][MAPSIZE*SEEY],
+                                     int, int, int, int, float, float );
+    static const octant_caster octants[8] = {
+        castLight<0, 1, 1, 0>, castLight<1, 0, 0, 1>,
+        castLight<0, -1, 1, 0>, castLight<-1, 0, 0, 1>,
+        castLight<0, 1, -1, 0>, castLight<1, 0, 0, -1>,
+        castLight<0, -1, -1, 0>, castLight<-1, 0, 0, -1>
+    };
+
+    if( pool == nullptr || pool->size() == 1 ) {
+        for( const auto cast : octants ) {
+            cast( output_cache, input_array, offsetX, offsetY, offsetDistance, 1, 1.0f, 0.0f );
+        }
         return;
-    } else if ( luminance <= 2 ) {
-        luminance = 1.49f;
-    } else if (luminance <= LIGHT_SOURCE_LOCAL) {
+    }
+
+    // Neighbouring octants share the squares on the diagonals and axes between them,
+    // so each gets its own buffer instead of racing for those squares.
+    static bool octant_caches[8][MAPSIZE*SEEX][MAPSIZE*SEEY];
+    // Nothing outside of the radius is touched, so only that part needs clearing and merging
+    const int radius = 60 - offsetDistance;
+    const int minx = std::max( 0, offsetX - radius );
+    const int maxx = std::min( MAPSIZE*SEEX - 1, offsetX + radius );
+    const int miny = std::max( 0, offsetY - radius );
+    const int maxy = std::min( MAPSIZE*SEEY - 1, offsetY + radius );
+    if( minx > maxx || miny > maxy ) {
         return;
     }
 
-    bool lit[LIGHTMAP_CACHE_X][LIGHTMAP_CACHE_Y] {};
-    if (INBOUNDS(x, y)) {
-        lit[x][y] = true;
+    pool->run( 8, [&]( const int i ) {
+        auto &cache = octant_caches[i];
+        for( int x = minx; x <= maxx; x++ ) {
+            std::fill( &cache[x][miny], &cache[x][maxy] + 1, false );
+        }
+        octants[i]( cache, input_array, offsetX, offsetY, offsetDistance, 1, 1.0f, 0.0f );
+    } );
+
+    // Merging is an or over all octants in a fixed order, whichever finished first
+    for( int x = minx; x <= maxx; x++ ) {
+        for( int y = miny; y <= maxy; y++ ) {
+            bool seen = output_cache[x][y];
+            for( const auto &cache : octant_caches ) {
+                seen |= cache[x][y];
+            }
+            output_cache[x][y] = seen;
+        }
     }
+}
+
+void map::apply_light_source(int x, int y, float luminance, bool trig_brightcalc )
+{
+    light_source source = {};
+    source.type = light_source::POINT;
+    source.x = x;
+    source.y = y;
+    source.luminance = luminance;
+    source.trig = trig_brightcalc;
 
     /* If we're a 5 luminance fire , we skip casting rays into ey && sx if we have
          neighboring fires to the north and west that were applied via light_source_buffer
@@ -742,10 +926,36 @@ void map::apply_light_source(int x, int y, float luminance, bool trig_brightcalc
     */
     auto &light_source_buffer = get_cache( abs_sub.z ).light_source_buffer;
     const int peer_inbounds = LIGHTMAP_CACHE_X - 1;
-    bool north = (y != 0 && light_source_buffer[x][y - 1] < luminance );
-    bool south = (y != peer_inbounds && light_source_buffer[x][y + 1] < luminance );
-    bool east = (x != peer_inbounds && light_source_buffer[x + 1][y] < luminance );
-    bool west = (x != 0 && light_source_buffer[x - 1][y] < luminance );
+    source.north = (y != 0 && light_source_buffer[x][y - 1] < luminance );
+    source.south = (y != peer_inbounds && light_source_buffer[x][y + 1] < luminance );
+    source.east = (x != peer_inbounds && light_source_buffer[x + 1][y] < luminance );
+    source.west = (x != 0 && light_source_buffer[x - 1][y] < luminance );
+
+    get_cache( abs_sub.z ).light_sources.push_back( source );
+}
+
+void map::cast_light_source( light_contribution &out, const light_source &source ) const
+{
+    const int x = source.x;
+    const int y = source.y;
+    float luminance = source.luminance;
+    if (INBOUNDS(x, y)) {
+        out.visit( x, y );
+        out.lm.emplace_back( x * LIGHTMAP_CACHE_Y + y, std::max( static_cast<float>( LL_LOW ), luminance ) );
+        out.sm.emplace_back( x * LIGHTMAP_CACHE_Y + y, luminance );
+    }
+    if ( luminance <= 1 ) {
+        return;
+    } else if ( luminance <= 2 ) {
+        luminance = 1.49f;
+    } else if (luminance <= LIGHT_SOURCE_LOCAL) {
+        return;
+    }
+
+    bool lit[LIGHTMAP_CACHE_X][LIGHTMAP_CACHE_Y] {};
+    if (INBOUNDS(x, y)) {
+        lit[x][y] = true;
+    }
 
     int range = LIGHT_RANGE(luminance);
     int sx = x - range;
@@ -754,21 +964,21 @@ void map::apply_light_source(int x, int y, float luminance, bool trig_brightcalc
     int ey = y + range;
 
     for(int off = sx; off <= ex; ++off) {
-        if ( south ) {
-            apply_light_ray(lit, x, y, off, sy, luminance, trig_brightcalc);
+        if ( source.south ) {
+            apply_light_ray(out, lit, x, y, off, sy, luminance, source.trig);
         }
-        if ( north ) {
-            apply_light_ray(lit, x, y, off, ey, luminance, trig_brightcalc);
+        if ( source.north ) {
+            apply_light_ray(out, lit, x, y, off, ey, luminance, source.trig);
         }
     }
 
     // Skip corners with + 1 and < as they were done
     for(int off = sy + 1; off < ey; ++off) {
-        if ( west ) {
-            apply_light_ray(lit, x, y, sx, off, luminance, trig_brightcalc);
+        if ( source.west ) {
+            apply_light_ray(out, lit, x, y, sx, off, luminance, source.trig);
         }
-        if ( east ) {
-            apply_light_ray(lit, x, y, ex, off, luminance, trig_brightcalc);
+        if ( source.east ) {
+            apply_light_ray(out, lit, x, y, ex, off, luminance, source.trig);
         }
     }
 }
@@ -780,24 +990,47 @@ void map::apply_light_arc(int x, int y, int angle, float luminance, int wideangl
         return;
     }
 
+    light_source source = {};
+    source.type = light_source::ARC;
+    source.x = x;
+    source.y = y;
+    source.luminance = luminance;
+    source.angle = angle;
+    source.width = wideangle;
+    source.trig = trigdist;
+    get_cache( abs_sub.z ).light_sources.push_back( source );
+}
+
+void map::cast_light_arc( light_contribution &out, const light_source &source ) const
+{
+    const int x = source.x;
+    const int y = source.y;
+    const bool trig = source.trig;
+
     bool lit[LIGHTMAP_CACHE_X][LIGHTMAP_CACHE_Y] {};
 
     constexpr float lum_mult = 3.0f;
 
-    luminance = luminance * lum_mult;
+    const float luminance = source.luminance * lum_mult;
 
     int range = LIGHT_RANGE(luminance);
-    apply_light_source(x, y, LIGHT_SOURCE_LOCAL, trigdist);
+    light_source local = {};
+    local.type = light_source::POINT;
+    local.x = x;
+    local.y = y;
+    local.luminance = LIGHT_SOURCE_LOCAL;
+    local.trig = trig;
+    cast_light_source( out, local );
 
     // Normalise (should work with negative values too)
-    const double wangle = wideangle / 2.0;
+    const double wangle = source.width / 2.0;
 
-    int nangle = angle % 360;
+    int nangle = source.angle % 360;
 
     int endx, endy;
     double rad = PI * (double)nangle / 180;
     calc_ray_end(nangle, range, x, y, &endx, &endy);
-    apply_light_ray(lit, x, y, endx, endy , luminance, trigdist);
+    apply_light_ray(out, lit, x, y, endx, endy , luminance, trig);
 
     int testx, testy;
     calc_ray_end(wangle + nangle, range, x, y, &testx, &testy);
@@ -811,21 +1044,21 @@ void map::apply_light_arc(int x, int y, int angle, float luminance, int wideangl
     const double wstep = ( wangle / ( wdist * SQRT_2 ) );
 
     for (double ao = wstep; ao <= wangle; ao += wstep) {
-        if ( trigdist ) {
+        if ( trig ) {
             double fdist = (ao * HALFPI) / wangle;
             double orad = ( PI * ao / 180.0 );
             endx = int( x + ( (double)range - fdist * 2.0) * cos(rad + orad) );
             endy = int( y + ( (double)range - fdist * 2.0) * sin(rad + orad) );
-            apply_light_ray(lit, x, y, endx, endy , luminance, true);
+            apply_light_ray(out, lit, x, y, endx, endy , luminance, true);
 
             endx = int( x + ( (double)range - fdist * 2.0) * cos(rad - orad) );
             endy = int( y + ( (double)range - fdist * 2.0) * sin(rad - orad) );
-            apply_light_ray(lit, x, y, endx, endy , luminance, true);
+            apply_light_ray(out, lit, x, y, endx, endy , luminance, true);
         } else {
             calc_ray_end(nangle + ao, range, x, y, &endx, &endy);
-            apply_light_ray(lit, x, y, endx, endy , luminance, false);
+            apply_light_ray(out, lit, x, y, endx, endy , luminance, false);
             calc_ray_end(nangle - ao, range, x, y, &endx, &endy);
-            apply_light_ray(lit, x, y, endx, endy , luminance, false);
+            apply_light_ray(out, lit, x, y, endx, endy , luminance, false);
         }
     }
 }
@@ -854,8 +1087,8 @@ void map::calc_ray_end(int angle, int range, int x, int y, int *outx, int *outy)
     }
 }
 
-void map::apply_light_ray(bool lit[LIGHTMAP_CACHE_X][LIGHTMAP_CACHE_Y],
-                          int sx, int sy, int ex, int ey, float luminance, bool trig_brightcalc)
+void map::apply_light_ray(light_contribution &out, bool lit[LIGHTMAP_CACHE_X][LIGHTMAP_CACHE_Y],
+                          int sx, int sy, int ex, int ey, float luminance, bool trig_brightcalc) const
 {
     int ax = abs(ex - sx) * 2;
     int ay = abs(ey - sy) * 2;
@@ -868,8 +1101,6 @@ void map::apply_light_ray(bool lit[LIGHTMAP_CACHE_X][LIGHTMAP_CACHE_Y],
         return;
     }
 
-    auto &lm = get_cache( abs_sub.z ).lm;
-
     float transparency = LIGHT_TRANSPARENCY_CLEAR;
     float light = 0.0;
     int td = 0;
@@ -886,6 +1117,7 @@ void map::apply_light_ray(bool lit[LIGHTMAP_CACHE_X][LIGHTMAP_CACHE_Y],
             t += ay;
 
             if (INBOUNDS(x, y)) {
+                out.visit( x, y );
                 if (!lit[x][y]) {
                     // Multiple rays will pass through the same squares so we need to record that
                     lit[x][y] = true;
@@ -898,7 +1130,7 @@ void map::apply_light_ray(bool lit[LIGHTMAP_CACHE_X][LIGHTMAP_CACHE_Y],
                     } else {
                         light = luminance / ((sx - x) * (sx - x));
                     }
-                    lm[x][y] = std::max(lm[x][y], light * transparency);
+                    out.lm.emplace_back( x * LIGHTMAP_CACHE_Y + y, light * transparency );
                 }
                 transparency *= light_transparency(x, y);
             }
@@ -920,6 +1152,7 @@ void map::apply_light_ray(bool lit[LIGHTMAP_CACHE_X][LIGHTMAP_CACHE_Y],
             t += ax;
 
             if (INBOUNDS(x, y)) {
+                out.visit( x, y );
                 if(!lit[x][y]) {
                     // Multiple rays will pass through the same squares so we need to record that
                     lit[x][y] = true;
@@ -932,7 +1165,7 @@ void map::apply_light_ray(bool lit[LIGHTMAP_CACHE_X][LIGHTMAP_CACHE_Y],
                     } else {
                         light = luminance / ((sy - y) * (sy - y));
                     }
-                    lm[x][y] = std::max(lm[x][y], light * transparency);
+                    out.lm.emplace_back( x * LIGHTMAP_CACHE_Y + y, light * transparency );
                 }
                 transparency *= light_transparency(x, y);
             }
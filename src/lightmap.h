@@ -1,6 +1,12 @@
 #ifndef LIGHTMAP_H
 #define LIGHTMAP_H
 
+#include <algorithm>
+#include <climits>
+#include <tuple>
+#include <utility>
+#include <vector>
+
 #define LIGHT_SOURCE_LOCAL  0.1f
 #define LIGHT_SOURCE_BRIGHT 10
 
@@ -21,4 +27,58 @@ enum lit_level {
     LL_BLANK // blank space, not an actual light level
 };
 
+/**
+ * A light source found by map::generate_lightmap. Its light only depends on these values
+ * and the transparency of the squares it goes through, see level_cache::light_cache.
+ */
+struct light_source {
+    enum source_type : int {
+        POINT, // Rays in all directions
+        ARC, // Rays across `width` degrees around `angle`
+        FILL // Sets the light level of its own square, no rays
+    };
+
+    source_type type;
+    int x;
+    int y;
+    float luminance;
+    int angle;
+    int width;
+    bool trig;
+    // Sides of the square around a POINT that get rays, see map::apply_light_source
+    bool north;
+    bool south;
+    bool east;
+    bool west;
+
+    bool operator<( const light_source &other ) const {
+        return std::tie( type, x, y, luminance, angle, width, trig, north, south, east, west ) <
+               std::tie( other.type, other.x, other.y, other.luminance, other.angle, other.width,
+                         other.trig, other.north, other.south, other.east, other.west );
+    }
+};
+
+/**
+ * The light a light source adds to the lightmap, as (x * MAPSIZE * SEEY + y, luminance) pairs
+ * for the light map (`lm`) and the light source map (`sm`).
+ */
+struct light_contribution {
+    std::vector< std::pair<int, float> > lm;
+    std::vector< std::pair<int, float> > sm;
+    // Bounding box of the squares the light went through
+    int min_x = INT_MAX;
+    int min_y = INT_MAX;
+    int max_x = INT_MIN;
+    int max_y = INT_MIN;
+    // Last call of map::generate_lightmap that used it
+    int generation = 0;
+
+    void visit( const int x, const int y ) {
+        min_x = std::min( min_x, x );
+        min_y = std::min( min_y, y );
+        max_x = std::max( max_x, x );
+        max_y = std::max( max_y, y );
+    }
+};
+
 #endif
@@ -14,6 +14,7 @@
 #include "filesystem.h"
 #include "path_info.h"
 #include "mapsharing.h"
+#include "map_pack.h"
 
 #include <cstring>
 #include <ctime>
@@ -63,6 +64,7 @@ int main(int argc, char *argv[])
     int seed = time(NULL);
     bool verifyexit = false;
     bool check_all_mods = false;
+    std::string pack_maps_world;
 
     // Set default file paths
 #ifdef PREFIX
@@ -115,6 +117,16 @@ int main(int argc, char *argv[])
                     return 0;
                 }
             },
+            {
+                "--pack-maps", "<world directory>",
+                "Moves the map files of a world saved by older versions into map packs",
+                section_default,
+                [&pack_maps_world](int num_args, const char **params) -> int {
+                    if (num_args < 1) return -1;
+                    pack_maps_world = params[0];
+                    return 1;
+                }
+            },
             {
                 "--basepath", "<path>",
                 "Base path for all game data subdirectories",
@@ -357,6 +369,16 @@ int main(int argc, char *argv[])
 
     setupDebug();
 
+    if (!pack_maps_world.empty()) {
+        const int moved_quads = map_pack::migrate(pack_maps_world + "/maps");
+        if (moved_quads < 0) {
+            printf("Failed to move the map files of %s into map packs.\n", pack_maps_world.c_str());
+            exit(1);
+        }
+        printf("Moved %d map files into map packs.\n", moved_quads);
+        exit(0);
+    }
+
     if (setlocale(LC_ALL, "") == NULL) {
         DebugLog(D_WARNING, D_MAIN) << "Error while setlocale(LC_ALL, '').";
     }
@@ -25,11 +25,13 @@
 #include "omdata.h"
 
 #include "map_iterator.h"
+#include "sight_cache.h"
 
 #include <cmath>
 #include <stdlib.h>
 #include <fstream>
 #include <cstring>
+#include <memory>
 
 extern bool is_valid_in_w_terrain(int,int);
 
@@ -77,6 +79,9 @@ void map_stack::insert_at( std::list<item>::iterator index,
 
 std::list<item>::iterator map_stack::begin()
 {
+    if( mydirty != nullptr ) {
+        *mydirty = true;
+    }
     return mystack->begin();
 }
 
@@ -97,6 +102,9 @@ std::list<item>::const_iterator map_stack::end() const
 
 std::list<item>::reverse_iterator map_stack::rbegin()
 {
+    if( mydirty != nullptr ) {
+        *mydirty = true;
+    }
     return mystack->rbegin();
 }
 
@@ -117,14 +125,30 @@ std::list<item>::const_reverse_iterator map_stack::rend() const
 
 item &map_stack::front()
 {
+    if( mydirty != nullptr ) {
+        *mydirty = true;
+    }
     return mystack->front();
 }
 
 item &map_stack::operator[]( size_t index )
 {
+    if( mydirty != nullptr ) {
+        *mydirty = true;
+    }
     return *(std::next(mystack->begin(), index));
 }
 
+const item &map_stack::front() const
+{
+    return mystack->front();
+}
+
+const item &map_stack::operator[]( size_t index ) const
+{
+    return *(std::next(mystack->cbegin(), index));
+}
+
 // Map class methods.
 
 map::map( int mapsize, bool zlev )
@@ -216,6 +240,7 @@ void map::update_vehicle_cache( vehicle *veh, const bool brand_new )
 
     auto &ch = get_cache( veh->smz );
     ch.veh_in_active_range = true;
+    set_scent_cache_dirty( veh->smz );
 
     if( !brand_new ) {
         // Existing must be cleared
@@ -223,11 +248,12 @@ void map::update_vehicle_cache( vehicle *veh, const bool brand_new )
         const auto end = ch.veh_cached_parts.end();
         while( it != end ) {
             if( it->second.first == veh ) {
-                const auto &p = it->first;
+                const tripoint p = it->first;
                 if( inbounds( p.x, p.y ) ) {
                     ch.veh_exists_at[p.x][p.y] = false;
                 }
                 ch.veh_cached_parts.erase( it++ );
+                set_pathfinding_cache_dirty( p );
             } else {
                 ++it;
             }
@@ -248,12 +274,15 @@ void map::update_vehicle_cache( vehicle *veh, const bool brand_new )
         if( inbounds( p.x, p.y ) ) {
             ch.veh_exists_at[p.x][p.y] = true;
         }
+        set_pathfinding_cache_dirty( p );
     }
 }
 
 void map::clear_vehicle_cache( const int zlev )
 {
     auto &ch = get_cache( zlev );
+    set_pathfinding_cache_dirty( zlev );
+    set_scent_cache_dirty( zlev );
     while( !ch.veh_cached_parts.empty() ) {
         const auto part = ch.veh_cached_parts.begin();
         const auto &p = part->first;
@@ -301,6 +330,7 @@ void map::destroy_vehicle (vehicle *veh)
             ch.vehicle_list.erase(veh);
             reset_vehicle_cache( zlev );
             current_submap->vehicles.erase (current_submap->vehicles.begin() + i);
+            current_submap->dirty = true;
             delete veh;
             return;
         }
@@ -311,6 +341,10 @@ void map::destroy_vehicle (vehicle *veh)
 void map::on_vehicle_moved( const int smz ) {
     set_outside_cache_dirty( smz );
     set_transparency_cache_dirty( smz );
+    // Move costs were already updated tile by tile along with the vehicle cache
+    if( inbounds_z( smz ) ) {
+        get_cache( smz ).portals.dirty = true;
+    }
 }
 
 void map::vehmove()
@@ -1155,6 +1189,8 @@ bool map::displace_vehicle( tripoint &p, const tripoint &dp, bool test )
         veh->set_submap_moved( int( p2.x / SEEX ), int( p2.y / SEEY ) );
         dst_submap->vehicles.push_back( veh );
         src_submap->vehicles.erase( src_submap->vehicles.begin() + our_i );
+        src_submap->dirty = true;
+        dst_submap->dirty = true;
     }
 
     // Need old coords to check for remote control
@@ -1350,8 +1386,10 @@ void map::furn_set( const tripoint &p, const furn_id new_furniture)
 
     // set the dirty flags
     // TODO: consider checking if the transparency value actually changes
-    set_transparency_cache_dirty( p.z );
+    set_transparency_cache_dirty( p );
     current_submap->set_furn( lx, ly, new_furniture );
+    set_pathfinding_cache_dirty( p );
+    set_scent_cache_dirty( p.z );
 }
 
 void map::furn_set( const tripoint &p, const std::string new_furniture) {
@@ -1515,12 +1553,14 @@ void map::ter_set( const tripoint &p, const ter_id new_terrain) {
 
     // set the dirty flags
     // TODO: consider checking if the transparency value actually changes
-    set_transparency_cache_dirty( p.z );
-    set_outside_cache_dirty( p.z );
+    set_transparency_cache_dirty( p );
+    set_outside_cache_dirty( p );
 
     int lx, ly;
     submap *const current_submap = get_submap_at( p, lx, ly );
     current_submap->set_ter( lx, ly, new_terrain );
+    set_pathfinding_cache_dirty( p );
+    set_scent_cache_dirty( p.z );
 }
 
 std::string map::tername( const tripoint &p ) const
@@ -1637,6 +1677,13 @@ int map::move_cost( const tripoint &p, const vehicle *ignored_vehicle ) const
         return 0;
     }
 
+    if( ignored_vehicle == nullptr ) {
+        const auto &ch = get_cache( p.z );
+        if( !ch.move_cost_cache_dirty && ch.move_cost_cache[p.x][p.y] != MOVE_COST_CACHE_OVERFLOW ) {
+            return ch.move_cost_cache[p.x][p.y];
+        }
+    }
+
     int part;
     const furn_t &furniture = furn_at( p );
     const ter_t &terrain = ter_at( p );
@@ -2217,7 +2264,8 @@ bool map::flammable_items_at( const tripoint &p )
         return false;
     }
 
-    for( const auto &i : i_at( p ) ) {
+    const map_stack items = i_at( p );
+    for( const auto &i : items ) {
         if( i.flammable() ) {
             // Total fire resistance == 0
             return true;
@@ -2229,7 +2277,8 @@ bool map::flammable_items_at( const tripoint &p )
 
 bool map::moppable_items_at( const tripoint &p )
 {
-    for (auto &i : i_at(p)) {
+    const map_stack items = i_at( p );
+    for( const auto &i : items ) {
         if (i.made_of(LIQUID)) {
             return true;
         }
@@ -2264,7 +2313,7 @@ void map::decay_fields_and_scent( const int amount )
     for( tmp.x = 0; tmp.x < my_MAPSIZE * SEEX; tmp.x++ ) {
         for( tmp.y = 0; tmp.y < my_MAPSIZE * SEEY; tmp.y++ ) {
             if( g->scent( tmp ) > 0 ) {
-                g->scent( tmp )--;
+                g->set_scent( tmp, g->scent( tmp ) - 1 );
             }
         }
     }
@@ -2290,6 +2339,7 @@ void map::decay_fields_and_scent( const int amount )
                 // This submap has no fields
                 continue;
             }
+            cur_submap->dirty = true;
 
             for( int sx = 0; sx < SEEX; ++sx ) {
                 if( to_proc < 1 ) {
@@ -2298,6 +2348,9 @@ void map::decay_fields_and_scent( const int amount )
                 }
 
                 for( int sy = 0; sy < SEEY; ++sy ) {
+                    if( !cur_submap->has_field_tile( sx, sy ) ) {
+                        continue;
+                    }
                     const int x = sx + smx * SEEX;
                     const int y = sy + smy * SEEY;
 
@@ -2458,7 +2511,7 @@ void map::create_spores( const tripoint &p, Creature* source )
             if (move_cost( tmp ) > 0 || (i == x && j == y)) {
                 if (mondex != -1) { // Spores hit a monster
                     if (g->u.sees( tmp ) &&
-                        !g->zombie(mondex).type->in_species("FUNGUS")) {
+                        !g->zombie(mondex).type->in_species(species_fungus)) {
                         add_msg(_("The %s is covered in tiny spores!"),
                                 g->zombie(mondex).name().c_str());
                     }
@@ -3686,10 +3739,13 @@ int& map::temperature( const tripoint &p )
 
 void map::set_temperature( const tripoint &p, int new_temperature )
 {
-    temperature( p ) = new_temperature;
-    temperature( tripoint( p.x + SEEX, p.y, p.z ) ) = new_temperature;
-    temperature( tripoint( p.x, p.y + SEEY, p.z ) ) = new_temperature;
-    temperature( tripoint( p.x + SEEX, p.y + SEEY, p.z ) ) = new_temperature;
+    for( const tripoint &q : { p, tripoint( p.x + SEEX, p.y, p.z ), tripoint( p.x, p.y + SEEY, p.z ),
+                               tripoint( p.x + SEEX, p.y + SEEY, p.z ) } ) {
+        temperature( q ) = new_temperature;
+        if( inbounds( q ) ) {
+            get_submap_at( q )->dirty = true;
+        }
+    }
 }
 
 void map::set_temperature( const int x, const int y, int new_temperature )
@@ -3708,7 +3764,8 @@ map_stack map::i_at( const int x, const int y )
     int lx, ly;
     submap *const current_submap = get_submap_at( x, y, lx, ly );
 
-    return map_stack{ &current_submap->itm[lx][ly], tripoint( x, y, abs_sub.z ), this };
+    return map_stack{ &current_submap->itm[lx][ly], tripoint( x, y, abs_sub.z ), this,
+                      &current_submap->dirty };
 }
 
 std::list<item>::iterator map::i_rem( const point location, std::list<item>::iterator it )
@@ -3791,7 +3848,7 @@ map_stack map::i_at( const tripoint &p )
     int lx, ly;
     submap *const current_submap = get_submap_at( p, lx, ly );
 
-    return map_stack{ &current_submap->itm[lx][ly], p, this };
+    return map_stack{ &current_submap->itm[lx][ly], p, this, &current_submap->dirty };
 }
 
 std::list<item>::iterator map::i_rem( const tripoint &p, std::list<item>::iterator it )
@@ -3851,6 +3908,7 @@ void map::i_clear(const tripoint &p)
         }
     }
 
+    current_submap->dirty = true;
     current_submap->lum[lx][ly] = 0;
     current_submap->itm[lx][ly].clear();
 }
@@ -3949,7 +4007,8 @@ int map::stored_volume(const tripoint &p) {
         return 0;
     }
     int cur_volume = 0;
-    for( auto &n : i_at(p) ) {
+    const map_stack items = i_at( p );
+    for( const auto &n : items ) {
         cur_volume += n.volume();
     }
     return cur_volume;
@@ -4065,6 +4124,7 @@ void map::add_item_at( const tripoint &p,
     int lx, ly;
     submap * const current_submap = get_submap_at( p, lx, ly );
     current_submap->is_uniform = false;
+    current_submap->dirty = true;
 
     current_submap->update_lum_add(new_item, lx, ly);
     const auto new_pos = current_submap->itm[lx][ly].insert( index, new_item );
@@ -4189,6 +4249,11 @@ void map::process_items( bool const active, T processor, std::string const &sign
         for( gx = 0; gx < my_MAPSIZE; ++gx ) {
             for( gy = 0; gy < my_MAPSIZE; ++gy ) {
                 submap *const current_submap = get_submap_at_grid( gp );
+                // Processing changes the items in place. This also covers the vehicles, which
+                // change every turn anyway (moves, fuel, ...).
+                if( !current_submap->vehicles.empty() || !current_submap->active_items.empty() ) {
+                    current_submap->dirty = true;
+                }
                 // Vehicles first in case they get blown up and drop active items on the map.
                 if( !current_submap->vehicles.empty() ) {
                     process_items_in_vehicles(current_submap, processor, signal);
@@ -4812,6 +4877,10 @@ field &map::field_at( const tripoint &p )
 
     int lx, ly;
     submap *const current_submap = get_submap_at( p, lx, ly );
+    // Fields are only changed through here once they exist, new ones are made by add_field
+    if( current_submap->fld[lx][ly].fieldCount() > 0 ) {
+        current_submap->dirty = true;
+    }
 
     return current_submap->fld[lx][ly];
 }
@@ -4880,8 +4949,12 @@ field_entry *map::get_field( const tripoint &p, const field_id t ) {
 
     int lx, ly;
     submap *const current_submap = get_submap_at( p, lx, ly );
+    field_entry *const entry = current_submap->fld[lx][ly].findField( t );
+    if( entry != nullptr ) {
+        current_submap->dirty = true;
+    }
 
-    return current_submap->fld[lx][ly].findField( t );
+    return entry;
 }
 
 bool map::add_field(const tripoint &p, const field_id t, int density, const int age)
@@ -4901,10 +4974,12 @@ bool map::add_field(const tripoint &p, const field_id t, int density, const int
     int lx, ly;
     submap *const current_submap = get_submap_at( p, lx, ly );
     current_submap->is_uniform = false;
+    current_submap->dirty = true;
 
     if( current_submap->fld[lx][ly].addField( t, density, age ) ) {
         //Only adding it to the count if it doesn't exist.
         current_submap->field_count++;
+        current_submap->set_field_tile( lx, ly );
     }
 
     if( g != nullptr && this == &g->m && p == g->u.pos3() ) {
@@ -4913,7 +4988,7 @@ bool map::add_field(const tripoint &p, const field_id t, int density, const int
 
     // Dirty the transparency cache now that field processing doesn't always do it
     // TODO: Make it skip transparent fields
-    set_transparency_cache_dirty( p.z );
+    set_transparency_cache_dirty( p );
     return true;
 }
 
@@ -4929,10 +5004,14 @@ void map::remove_field( const tripoint &p, const field_id field_to_remove )
     if( current_submap->fld[lx][ly].removeField( field_to_remove ) ) {
         // Only adjust the count if the field actually existed.
         current_submap->field_count--;
+        current_submap->dirty = true;
+        if( current_submap->fld[lx][ly].fieldCount() == 0 ) {
+            current_submap->clear_field_tile( lx, ly );
+        }
         const auto &fdata = fieldlist[ field_to_remove ];
         for( int i = 0; i < 3; ++i ) {
             if( !fdata.transparent[i] ) {
-                set_transparency_cache_dirty( p.z );
+                set_transparency_cache_dirty( p );
                 break;
             }
         }
@@ -4951,6 +5030,7 @@ computer* map::computer_at( const tripoint &p )
         return nullptr;
     }
 
+    current_submap->dirty = true;
     return &(current_submap->comp);
 }
 
@@ -4976,6 +5056,7 @@ basecamp* map::camp_at( const tripoint &p, const int radius)
             submap * const current_submap = get_submap_at( p );
             if( current_submap->camp.is_valid() ) {
                 // we only allow on camp per size radius, kinda
+                current_submap->dirty = true;
                 return &(current_submap->camp);
             }
         }
@@ -4991,7 +5072,9 @@ void map::add_camp( const tripoint &p, const std::string& name )
         return;
     }
 
-    get_submap_at( p )->camp = basecamp( name, p.x, p.y );
+    submap *const current_submap = get_submap_at( p );
+    current_submap->camp = basecamp( name, p.x, p.y );
+    current_submap->dirty = true;
 }
 
 void map::debug()
@@ -5434,6 +5517,25 @@ bool map::sees( const tripoint &F, const tripoint &T, const int range ) const
     return sees( F.x, F.y, T.x, T.y, range, t1 );
 }
 
+void map::sees( const tripoint &F, const std::vector<tripoint> &targets, const int range,
+                std::vector<bool> &seen, std::vector<int> *slopes ) const
+{
+    std::unique_ptr<field_of_view> fov( new field_of_view() );
+    build_field_of_view( F, range, *fov );
+    seen.resize( targets.size() );
+    if( slopes != nullptr ) {
+        slopes->assign( targets.size(), 0 );
+    }
+    int t1 = 0;
+    int t2 = 0;
+    for( size_t i = 0; i < targets.size(); i++ ) {
+        seen[i] = fov->sees( targets[i], range, t1, t2 );
+        if( slopes != nullptr ) {
+            ( *slopes )[i] = t1;
+        }
+    }
+}
+
 bool map::sees( const point F, const point T, const int range, int &bresenham_slope ) const
 {
     return sees( F.x, F.y, T.x, T.y, range, bresenham_slope );
@@ -5742,6 +5844,9 @@ void map::shift( const int sx, const int sy )
         // Clear vehicle list and rebuild after shift
         clear_vehicle_cache( gridz );
         get_cache( gridz ).vehicle_list.clear();
+        // Every square moves, loadn below only dirties the caches of the new submaps
+        set_transparency_cache_dirty( gridz );
+        set_outside_cache_dirty( gridz );
         if (sx >= 0) {
             for (int gridx = 0; gridx < my_MAPSIZE; gridx++) {
                 if (sy >= 0) {
@@ -5953,9 +6058,17 @@ void map::loadn( const int gridx, const int gridy, const int gridz, const bool u
         }
     }
 
-    // New submap changes the content of the map and all caches must be recalculated
-    set_transparency_cache_dirty( gridz );
-    set_outside_cache_dirty( gridz );
+    // New submap changes the content of the map and all caches must be recalculated,
+    // the transparency and outside caches only for this submap and around it
+    const tripoint grid_start( gridx * SEEX, gridy * SEEY, gridz );
+    for( int x = 0; x < SEEX; x += SEEX - 1 ) {
+        for( int y = 0; y < SEEY; y += SEEY - 1 ) {
+            set_outside_cache_dirty( grid_start + tripoint( x, y, 0 ) );
+        }
+    }
+    set_transparency_cache_dirty( grid_start );
+    set_pathfinding_cache_dirty( gridz );
+    set_scent_cache_dirty( gridz );
     setsubmap( gridn, tmpsub );
 
     for( auto it : tmpsub->vehicles ) {
@@ -6056,7 +6169,7 @@ void map::grow_plant( const tripoint &p )
     if( !furn.has_flag( "PLANT" ) ) {
         return;
     }
-    auto items = i_at( p );
+    const map_stack items = i_at( p );
     if( items.empty() ) {
         // No seed there anymore, we don't know what kind of plant it was.
         dbg( D_ERROR ) << "a seed item has vanished at " << p.x << "," << p.y << "," << p.z;
@@ -6276,7 +6389,10 @@ void map::spawn_monsters_submap( const tripoint &gp, bool ignore_sight )
             }
         }
     }
-    current_submap->spawns.clear();
+    if( !current_submap->spawns.empty() ) {
+        current_submap->spawns.clear();
+        current_submap->dirty = true;
+    }
     overmap_buffer.spawn_monster( abs_sub.x + gp.x, abs_sub.y + gp.y, gp.z );
 }
 
@@ -6300,7 +6416,10 @@ void map::spawn_monsters(bool ignore_sight)
 void map::clear_spawns()
 {
     for( auto & smap : grid ) {
-        smap->spawns.clear();
+        if( !smap->spawns.empty() ) {
+            smap->spawns.clear();
+            smap->dirty = true;
+        }
     }
 }
 
@@ -6425,59 +6544,82 @@ long map::determine_wall_corner( const tripoint &p ) const
     }
 }
 
+void map::set_outside_cache_dirty( const tripoint &p )
+{
+    if( !inbounds( p ) ) {
+        return;
+    }
+    auto &ch = get_cache( p.z );
+    const int max = my_MAPSIZE * SEEX - 1;
+    // Submaps of the square and its neighbors, which are all made indoors by an indoor square
+    for( int smx = std::max( p.x - 1, 0 ) / SEEX; smx <= std::min( p.x + 1, max ) / SEEX; smx++ ) {
+        for( int smy = std::max( p.y - 1, 0 ) / SEEY; smy <= std::min( p.y + 1, max ) / SEEY; smy++ ) {
+            ch.outside_dirty_submaps.set( smx * MAPSIZE + smy );
+        }
+    }
+}
+
 void map::build_outside_cache( const int zlev )
 {
     auto &ch = get_cache( zlev );
-    if( !ch.outside_cache_dirty ) {
+    if( ch.outside_cache_dirty ) {
+        ch.outside_dirty_submaps.set();
+    } else if( ch.outside_dirty_submaps.none() ) {
         return;
     }
 
-    // Make a bigger cache to avoid bounds checking
-    // We will later copy it to our regular cache
-    const size_t padded_w = ( my_MAPSIZE * SEEX ) + 2;
-    const size_t padded_h = ( my_MAPSIZE * SEEY ) + 2;
-    bool padded_cache[padded_w][padded_h];
-
     auto &outside_cache = ch.outside_cache;
     if( zlev < 0 )
     {
         std::uninitialized_fill_n(
             &outside_cache[0][0], ( MAPSIZE * SEEX ) * ( MAPSIZE * SEEY ), false );
+        ch.outside_dirty_submaps.reset();
+        ch.outside_cache_dirty = false;
         return;
     }
 
-    std::uninitialized_fill_n(
-            &padded_cache[0][0], padded_w * padded_h, true );
-
+    // Indoor squares of a submap and the squares around it, the squares beyond the
+    // edges of the map are outside.
+    bool indoors[SEEX + 2][SEEY + 2];
+    const int max = my_MAPSIZE * SEEX - 1;
     for( int smx = 0; smx < my_MAPSIZE; ++smx ) {
         for( int smy = 0; smy < my_MAPSIZE; ++smy ) {
-            auto const cur_submap = get_submap_at_grid( smx, smy, zlev );
+            if( !ch.outside_dirty_submaps[smx * MAPSIZE + smy] ) {
+                continue;
+            }
 
-            for( int sx = 0; sx < SEEX; ++sx ) {
-                for( int sy = 0; sy < SEEY; ++sy ) {
-                    if( terlist[ cur_submap->get_ter( sx, sy ) ].has_flag( TFLAG_INDOORS ) ||
-                        furnlist[ cur_submap->get_furn( sx, sy ) ].has_flag( TFLAG_INDOORS ) ) {
-                        const int x = sx + ( smx * SEEX );
-                        const int y = sy + ( smy * SEEY );
-                        // Add 1 to both coords, because we're operating on the padded cache
-                        for( int dx = 0; dx <= 2; dx++ )
-                        {
-                            for( int dy = 0; dy <= 2; dy++ )
-                            {
-                                padded_cache[x + dx][y + dy] = false;
-                            }
+            for( int dx = 0; dx < SEEX + 2; dx++ ) {
+                for( int dy = 0; dy < SEEY + 2; dy++ ) {
+                    const int x = smx * SEEX + dx - 1;
+                    const int y = smy * SEEY + dy - 1;
+                    if( x < 0 || y < 0 || x > max || y > max ) {
+                        indoors[dx][dy] = false;
+                        continue;
+                    }
+                    auto const cur_submap = get_submap_at_grid( x / SEEX, y / SEEY, zlev );
+                    const int sx = x % SEEX;
+                    const int sy = y % SEEY;
+                    indoors[dx][dy] = terlist[ cur_submap->get_ter( sx, sy ) ].has_flag( TFLAG_INDOORS ) ||
+                                      furnlist[ cur_submap->get_furn( sx, sy ) ].has_flag( TFLAG_INDOORS );
+                }
+            }
+
+            // A square is outside unless it or a neighbor is indoors
+            for( int sx = 0; sx < SEEX; sx++ ) {
+                for( int sy = 0; sy < SEEY; sy++ ) {
+                    bool outside = true;
+                    for( int dx = 0; dx <= 2; dx++ ) {
+                        for( int dy = 0; dy <= 2; dy++ ) {
+                            outside &= !indoors[sx + dx][sy + dy];
                         }
                     }
+                    outside_cache[smx * SEEX + sx][smy * SEEY + sy] = outside;
                 }
             }
         }
     }
 
-    // Copy the padded cache back to the proper one, but with no padding
-    for( int x = 0; x < my_MAPSIZE * SEEX; x++ ) {
-        std::copy_n( &padded_cache[x + 1][1], my_MAPSIZE * SEEX, &outside_cache[x][0] );
-    }
-
+    ch.outside_dirty_submaps.reset();
     ch.outside_cache_dirty = false;
 }
 
@@ -6485,6 +6627,7 @@ void map::build_map_cache( const int zlev )
 {
     build_outside_cache( zlev );
     build_transparency_cache( zlev );
+    build_move_cost_cache( zlev );
 
     tripoint start( 0, 0, zlev );
     tripoint end( my_MAPSIZE * SEEX, my_MAPSIZE * SEEY, zlev );
@@ -6492,6 +6635,7 @@ void map::build_map_cache( const int zlev )
     VehicleList vehs = get_vehicles( start, end );
     auto &outside_cache = get_cache( zlev ).outside_cache;
     auto &transparency_cache = get_cache( zlev ).transparency_cache;
+    auto &ch = get_cache( zlev );
     // Cache all the vehicle stuff in one loop
     for( auto &v : vehs ) {
         for( size_t part = 0; part < v.v->parts.size(); part++ ) {
@@ -6503,8 +6647,10 @@ void map::build_map_cache( const int zlev )
                 }
                 if (v.v->part_flag(part, VPFLAG_OPAQUE) && v.v->parts[part].hp > 0) {
                     int dpart = v.v->part_with_feature( part, VPFLAG_OPENABLE );
-                    if (dpart < 0 || !v.v->parts[dpart].open) {
+                    if( ( dpart < 0 || !v.v->parts[dpart].open ) &&
+                        transparency_cache[px][py] != LIGHT_TRANSPARENCY_SOLID ) {
                         transparency_cache[px][py] = LIGHT_TRANSPARENCY_SOLID;
+                        ch.transparency_changed( ( px / SEEX ) * MAPSIZE + py / SEEY );
                     }
                 }
             }
@@ -6513,6 +6659,8 @@ void map::build_map_cache( const int zlev )
 
     build_seen_cache( tripoint( g->u.posx(), g->u.posy(), zlev ) );
     generate_lightmap( zlev );
+    // Creature::sees depends on both
+    sight_cache::invalidate();
 }
 
 std::vector<point> closest_points_first(int radius, point p)
@@ -6762,6 +6910,8 @@ void map::draw_fill_background(ter_id type) {
     // Need to explicitly set caches dirty - set_ter would do it before
     set_transparency_cache_dirty( abs_sub.z );
     set_outside_cache_dirty( abs_sub.z );
+    set_pathfinding_cache_dirty( abs_sub.z );
+    set_scent_cache_dirty( abs_sub.z );
 
     // Fill each submap rather than each tile
     constexpr size_t block_size = SEEX * SEEY;
@@ -6875,6 +7025,10 @@ void map::add_corpse( const tripoint &p ) {
 
 field &map::get_field( const tripoint &p )
 {
+    // The caller may add fields directly
+    if( inbounds( p ) ) {
+        get_submap_at( p )->dirty = true;
+    }
     return field_at( p );
 }
 
@@ -7018,6 +7172,103 @@ void map::scent_blockers( bool (&blocks_scent)[SEEX * MAPSIZE][SEEY * MAPSIZE],
     }
 }
 
+void map::build_scent_cache()
+{
+    auto &ch = get_cache( abs_sub.z );
+    if( !ch.scent_cache_dirty ) {
+        return;
+    }
+
+    // scent_blockers only sets the flags of the tiles it finds
+    bool blocks_scent[SEEX * MAPSIZE][SEEY * MAPSIZE] = {};
+    bool reduces_scent[SEEX * MAPSIZE][SEEY * MAPSIZE] = {};
+    scent_blockers( blocks_scent, reduces_scent, 0, 0, SEEX * my_MAPSIZE - 1, SEEY * my_MAPSIZE - 1 );
+
+    auto &weight = ch.scent_weight_cache;
+    for( int x = 0; x < SEEX * MAPSIZE; x++ ) {
+        for( int y = 0; y < SEEY * MAPSIZE; y++ ) {
+            if( x >= SEEX * my_MAPSIZE || y >= SEEY * my_MAPSIZE || blocks_scent[x][y] ) {
+                weight[x][y] = 0;
+            } else if( reduces_scent[x][y] ) {
+                // only 20% of scent can diffuse on REDUCE_SCENT squares
+                weight[x][y] = 2;
+            } else {
+                weight[x][y] = 10;
+            }
+        }
+    }
+
+    // The scent a tile keeps depends only on the weights around it:
+    // with a diffusivity of 10 * weight (out of 10000 per unit of weight),
+    // it loses what diffuses out to its neighbors (including itself)
+    // and what the neighboring walls and reduce_scent squares absorb.
+    auto &keep = ch.scent_keep_cache;
+    for( int x = 0; x < SEEX * MAPSIZE; x++ ) {
+        for( int y = 0; y < SEEY * MAPSIZE; y++ ) {
+            const int own = weight[x][y];
+            if( own == 0 ) {
+                keep[x][y] = 0;
+                continue;
+            }
+            int squares_used = 0;
+            for( int i = std::max( x - 1, 0 ); i <= std::min( x + 1, SEEX * MAPSIZE - 1 ); i++ ) {
+                for( int j = std::max( y - 1, 0 ); j <= std::min( y + 1, SEEY * MAPSIZE - 1 ); j++ ) {
+                    squares_used += weight[i][j];
+                }
+            }
+            const int diffusivity = 10 * own;
+            keep[x][y] = 10 * 1000 - squares_used * diffusivity - diffusivity / 5 * ( 90 - squares_used );
+        }
+    }
+
+    ch.scent_cache_dirty = false;
+}
+
+bool map::diffuse_scent( int (&scent)[SEEX * MAPSIZE][SEEY * MAPSIZE],
+                         const int minx, const int miny, const int maxx, const int maxy )
+{
+    build_scent_cache();
+    const auto &ch = get_cache( abs_sub.z );
+    const auto &weight = ch.scent_weight_cache;
+    const auto &keep = ch.scent_keep_cache;
+
+    // Weighted sums of the scent of 3 vertically neighboring tiles, one column wider than the
+    // rectangle on each side, and the new scent values. Both are kept between calls to spare
+    // the stack, and the loops below are free of branches so the compiler can vectorize them.
+    static int sum_3_scent_y[SEEX * MAPSIZE][SEEY * MAPSIZE];
+    static int new_scent[SEEX * MAPSIZE][SEEY * MAPSIZE];
+
+    for( int x = minx - 1; x <= maxx + 1; ++x ) {
+        const int *const col = scent[x];
+        const int16_t *const w = weight[x];
+        int *const sum = sum_3_scent_y[x];
+        for( int y = miny; y <= maxy; ++y ) {
+            sum[y] = w[y - 1] * col[y - 1] + w[y] * col[y] + w[y + 1] * col[y + 1];
+        }
+    }
+
+    for( int x = minx; x <= maxx; ++x ) {
+        const int *const col = scent[x];
+        const int16_t *const w = weight[x];
+        const int16_t *const k = keep[x];
+        const int *const left = sum_3_scent_y[x - 1];
+        const int *const mid = sum_3_scent_y[x];
+        const int *const right = sum_3_scent_y[x + 1];
+        int *const out = new_scent[x];
+        for( int y = miny; y <= maxy; ++y ) {
+            // Tiles blocking scent have neither weight nor anything to keep, so they end up at 0
+            out[y] = ( col[y] * k[y] + 10 * w[y] * ( left[y] + mid[y] + right[y] ) ) / ( 1000 * 10 );
+        }
+    }
+
+    bool changed = false;
+    for( int x = minx; x <= maxx; ++x ) {
+        changed = changed || !std::equal( new_scent[x] + miny, new_scent[x] + maxy + 1, scent[x] + miny );
+        std::copy( new_scent[x] + miny, new_scent[x] + maxy + 1, scent[x] + miny );
+    }
+    return changed;
+}
+
 tripoint_range map::points_in_rectangle( const tripoint &from, const tripoint &to ) const
 {
     const int minx = std::max( 0, std::min( from.x, to.x ) );
@@ -7064,6 +7315,13 @@ level_cache::level_cache()
 {
     transparency_cache_dirty = true;
     outside_cache_dirty = true;
+    move_cost_cache_dirty = true;
+    scent_cache_dirty = true;
+    light_generation = 0;
+    std::fill_n( &light_transparency[0][0], SEEX * MAPSIZE * SEEY * MAPSIZE, LIGHT_TRANSPARENCY_CLEAR );
+    light_transparency_generation = 0;
+    transparency_generation = 0;
+    std::fill_n( transparency_changed_at, MAPSIZE * MAPSIZE, 0 );
     veh_in_active_range = false;
     std::fill_n( &veh_exists_at[0][0], SEEX * MAPSIZE * SEEY * MAPSIZE, false );
 }
@@ -10,6 +10,8 @@
 #include <map>
 #include <unordered_map>
 #include <unordered_set>
+#include <cstdint>
+#include <bitset>
 
 #include "game_constants.h"
 #include "mapdata.h"
@@ -19,6 +21,7 @@
 #include "item_stack.h"
 #include "active_item_cache.h"
 #include "string_id.h"
+#include "pathfinding.h"
 
 //TODO: include comments about how these variables work. Where are they used. Are they constant etc.
 #define CAMPSIZE 1
@@ -61,9 +64,12 @@ private:
     std::list<item> *mystack;
     tripoint location;
     map *myorigin;
+    // The dirty flag of the submap, set by the non-const accessors because they allow changing
+    // the items in place, read the items through a const map_stack to leave it alone
+    bool *mydirty;
 public:
-    map_stack( std::list<item> *newstack, tripoint newloc, map *neworigin ) :
-    mystack(newstack), location(newloc), myorigin(neworigin) {};
+    map_stack( std::list<item> *newstack, tripoint newloc, map *neworigin, bool *newdirty = nullptr ) :
+    mystack(newstack), location(newloc), myorigin(neworigin), mydirty(newdirty) {};
     size_t size() const override;
     bool empty() const override;
     std::list<item>::iterator erase( std::list<item>::iterator it ) override;
@@ -79,6 +85,8 @@ public:
     std::list<item>::const_reverse_iterator rend() const;
     item &front() override;
     item &operator[]( size_t index ) override;
+    const item &front() const;
+    const item &operator[]( size_t index ) const;
 };
 
 struct visibility_variables {
@@ -104,27 +112,93 @@ enum visibility_type {
   VIS_BOOMER_DARK
 };
 
+// Value of level_cache::move_cost_cache for tiles whose move cost doesn't fit in it
+constexpr int MOVE_COST_CACHE_OVERFLOW = UINT8_MAX;
+
 struct level_cache {
     level_cache(); // Zeroes all relevant values
     level_cache( const level_cache &other ) = default;
 
+    // The whole level has to be rebuilt
     bool transparency_cache_dirty;
     bool outside_cache_dirty;
+    // Submaps (bit smx * MAPSIZE + smy) that have to be rebuilt after changes to single squares
+    std::bitset<MAPSIZE*MAPSIZE> transparency_dirty_submaps;
+    std::bitset<MAPSIZE*MAPSIZE> outside_dirty_submaps;
+    // Counts the changes of transparency_cache, transparency_changed_at has the count of the
+    // last change of each submap. Readers of map::transparency_changes keep their own count.
+    int transparency_generation;
+    int transparency_changed_at[MAPSIZE*MAPSIZE];
+    // Records that the part of transparency_cache in the submap may have changed
+    void transparency_changed( size_t submap ) {
+        transparency_changed_at[submap] = ++transparency_generation;
+    }
+    bool move_cost_cache_dirty;
+    bool scent_cache_dirty;
 
     float lm[MAPSIZE*SEEX][MAPSIZE*SEEY];
     float sm[MAPSIZE*SEEX][MAPSIZE*SEEY];
     // To prevent redundant ray casting into neighbors: precalculate bulk light source positions.
     // This is only valid for the duration of generate_lightmap
     float light_source_buffer[MAPSIZE*SEEX][MAPSIZE*SEEY];
+    // Light sources in the order generate_lightmap applies them, only valid during that call
+    std::vector<light_source> light_sources;
+    // Light of the sources of the last call of generate_lightmap, reused while the transparency
+    // of the squares it went through doesn't change
+    std::map<light_source, light_contribution> light_cache;
+    int light_generation;
+    // transparency_cache as of the last call of generate_lightmap
+    float light_transparency[MAPSIZE*SEEX][MAPSIZE*SEEY];
+    // Count of the transparency changes when light_transparency was updated
+    int light_transparency_generation;
     bool outside_cache[MAPSIZE*SEEX][MAPSIZE*SEEY];
     float transparency_cache[MAPSIZE*SEEX][MAPSIZE*SEEY];
     bool seen_cache[MAPSIZE*SEEX][MAPSIZE*SEEY];
     lit_level visibility_cache[MAPSIZE*SEEX][MAPSIZE*SEEY];
+    // map::move_cost of every tile, 0 if impassable
+    uint8_t move_cost_cache[MAPSIZE*SEEX][MAPSIZE*SEEY];
+    // Share of the scent of a tile that diffuses to its neighbors: 0 if it blocks scent,
+    // 2 if it reduces it and 10 otherwise. See map::diffuse_scent.
+    int16_t scent_weight_cache[MAPSIZE*SEEX][MAPSIZE*SEEY];
+    // Factor of the scent a tile keeps after diffusion, times 10000
+    int16_t scent_keep_cache[MAPSIZE*SEEX][MAPSIZE*SEEY];
 
     bool veh_in_active_range;
     bool veh_exists_at[SEEX * MAPSIZE][SEEY * MAPSIZE];
     std::map< tripoint, std::pair<vehicle*,int> > veh_cached_parts;
     std::set<vehicle*> vehicle_list;
+
+    // Abstract graph of the submap borders, used by map::route for long routes.
+    // Built by the first route that needs it after it was marked dirty.
+    mutable portal_graph portals;
+};
+
+/**
+ * Squares that may be seen from one square of the map, for answering many line of sight
+ * checks from there without tracing the Bresenham lines of the squares that can't be seen.
+ * See map::build_field_of_view.
+ */
+class field_of_view
+{
+    public:
+        field_of_view() = default;
+        field_of_view( const field_of_view & ) = delete;
+        field_of_view &operator=( const field_of_view & ) = delete;
+
+        /**
+         * Same as map::sees( origin, p, range, t1, t2 ), the line is only traced if `p`
+         * may be seen.
+         */
+        bool sees( const tripoint &p, int range, int &t1, int &t2 ) const;
+
+    private:
+        friend class map;
+        const map *m = nullptr;
+        tripoint origin;
+        // Squares up to this far from origin (along either axis) are covered by `reachable`
+        int radius = 0;
+        // Squares that a Bresenham line from origin may reach, the others can't be seen
+        bool reachable[MAPSIZE*SEEX][MAPSIZE*SEEY];
 };
 
 /**
@@ -177,6 +251,11 @@ class map
         }
     }
 
+    /**
+     * Same as above for a change of the square at p, which only dirties its submap.
+     */
+    void set_transparency_cache_dirty( const tripoint &p );
+
     /**
      * Sets a dirty flag on the outside cache.
      *
@@ -190,6 +269,50 @@ class map
         }
     }
 
+    /**
+     * Same as above for a change of the square at p. Indoor squares make
+     * their neighbors indoors, so this dirties the submaps of those as well.
+     */
+    void set_outside_cache_dirty( const tripoint &p );
+
+    /**
+     * Submaps (bit smx * MAPSIZE + smy) whose part of the transparency cache of
+     * the z-level was rebuilt or changed since `generation`, which is then set to
+     * the current count of changes. Each reader keeps its own count, starting at 0.
+     */
+    std::bitset<MAPSIZE*MAPSIZE> transparency_changes( int zlev, int &generation ) const;
+
+    /**
+     * Sets a dirty flag on the pathfinding caches.
+     *
+     * Needs to be called whenever terrain, furniture or vehicles
+     * change in a way that could change movement costs.
+     */
+    void set_pathfinding_cache_dirty( const int zlev ) {
+        if( inbounds_z( zlev ) ) {
+            get_cache( zlev ).portals.dirty = true;
+            get_cache( zlev ).move_cost_cache_dirty = true;
+        }
+    }
+
+    /**
+     * Same as above for a change limited to a single tile, which has to be called
+     * after the change. The move cost cache is updated in place instead of being rebuilt.
+     */
+    void set_pathfinding_cache_dirty( const tripoint &p );
+
+    /**
+     * Sets a dirty flag on the scent diffusion cache.
+     *
+     * Needs to be called whenever terrain, furniture or vehicles
+     * change in a way that could block or reduce scent.
+     */
+    void set_scent_cache_dirty( const int zlev ) {
+        if( inbounds_z( zlev ) ) {
+            get_cache( zlev ).scent_cache_dirty = true;
+        }
+    }
+
     /**
      * Callback invoked when a vehicle has moved.
      */
@@ -350,6 +473,23 @@ public:
     */
     bool sees( const tripoint &F, const tripoint &T, int range, int &t1, int &t2 ) const;
     bool sees( const tripoint &F, const tripoint &T, int range ) const;
+    /**
+     * Checks the line of sight from `F` to each of `targets`, with the same results as the
+     * function above but skipping the targets that can't be seen, see @ref build_field_of_view.
+     *
+     * @param seen Set to whether each target is seen with a view range of `range`.
+     * @param slopes If not null, set to the Bresenham slope (`t1` of the function above) of each
+     *               target, 0 for those that aren't seen.
+     */
+    void sees( const tripoint &F, const std::vector<tripoint> &targets, int range,
+               std::vector<bool> &seen, std::vector<int> *slopes = nullptr ) const;
+    /**
+     * Prepares `fov` for checking the line of sight from `origin` to squares up to `range`
+     * (at most 60) squares away. Every line traced by @ref sees steps away from `origin`
+     * through transparent squares, so the squares no such path reaches can't be seen.
+     * That rules out the inside of closed buildings and the like without tracing any line.
+     */
+    void build_field_of_view( const tripoint &origin, int range, field_of_view &fov ) const;
 
  /**
   * Check whether there's a direct line of sight between `(Fx, Fy)` and
@@ -402,6 +542,16 @@ public:
  std::vector<tripoint> route( const tripoint &f, const tripoint &t,
                               const int bash, const int maxdist ) const;
 
+    /**
+     * Cost of a single step from `cur` onto the adjacent tile `p`, as used by @ref route.
+     * Includes the penalties for opening doors and bashing obstacles.
+     *
+     * @param bash Bashing strength of the creature (0 means no bashing).
+     * @return -1 if `p` can't be entered from anywhere, 0 if it can't be entered
+     *         from `cur` (e.g. an inside door), the cost of the step otherwise.
+     */
+    int route_step_cost( const tripoint &cur, const tripoint &p, const int bash ) const;
+
  int coord_to_angle(const int x, const int y, const int tgtx, const int tgty) const;
 // Vehicles: Common to 2D and 3D
     VehicleList get_vehicles();
@@ -917,6 +1067,14 @@ void add_corpse( const tripoint &p );
     void scent_blockers( bool (&blocks_scent)[SEEX * MAPSIZE][SEEY * MAPSIZE],
                          bool (&reduces_scent)[SEEX * MAPSIZE][SEEY * MAPSIZE],
                          int minx, int miny, int maxx, int maxy );
+    /**
+     * One step of diffusion of the scent map of the current z-level, limited to the
+     * rectangle between (minx, miny) and (maxx, maxy), which must not touch the map edges.
+     * Blockers come from a cache that is only rebuilt after @ref set_scent_cache_dirty.
+     * @return Whether the scent of any tile changed.
+     */
+    bool diffuse_scent( int (&scent)[SEEX * MAPSIZE][SEEY * MAPSIZE],
+                        int minx, int miny, int maxx, int maxy );
 
 // Computers
     computer* computer_at( const tripoint &p );
@@ -1095,6 +1253,19 @@ protected:
                 const int zlevel, const regional_settings * rsettings);
  void add_extra(map_extra type);
  void build_transparency_cache( int zlev );
+    /**
+     * Rebuilds the scent diffusion cache of the current z-level if it was marked dirty.
+     */
+    void build_scent_cache();
+    /**
+     * Rebuilds the move cost cache of the z-level if it was marked dirty.
+     */
+    void build_move_cost_cache( int zlev );
+    /**
+     * Rebuilds the portal graph of the z-level if it was marked dirty.
+     * See @ref portal_graph.
+     */
+    void build_portal_graph( int zlev ) const;
 public:
  void build_outside_cache( int zlev );
  void build_seen_cache(const tripoint &origin);
@@ -1175,6 +1346,22 @@ private:
     int bash_rating_internal( const int str, const furn_t &furniture,
                               const ter_t &terrain, bool allow_floor,
                               const vehicle *veh, const int part ) const;
+    /** @ref move_cost of the tile as stored in @ref level_cache::move_cost_cache */
+    uint8_t move_cost_cache_value( const tripoint &p ) const;
+
+    /**
+     * Tile by tile A* search used by @ref route, limited to the box between `min` and `max`.
+     */
+    std::vector<tripoint> route_tiles( const tripoint &f, const tripoint &t,
+                                       const int bash, const int maxdist,
+                                       const tripoint &min, const tripoint &max ) const;
+    /**
+     * Plans the route on the portal graph and refines it with @ref route_tiles.
+     * Returns an empty vector if the graph can't be used or doesn't give a route.
+     */
+    std::vector<tripoint> route_portals( const tripoint &f, const tripoint &t,
+                                         const int bash, const int maxdist,
+                                         const tripoint &min, const tripoint &max ) const;
 
      /**
       * Internal version of the drawsq. Keeps a cached maptile for less re-getting.
@@ -1186,14 +1373,19 @@ private:
 
  long determine_wall_corner( const tripoint &p ) const;
  void cache_seen(const int fx, const int fy, const int tx, const int ty, const int max_range);
- // apply a circular light pattern immediately, however it's best to use...
+ // apply a circular light pattern in call order, however it's best to use...
  void apply_light_source(int x, int y, float luminance, bool trig_brightcalc);
  // ...this, which will apply the light after at the end of generate_lightmap, and prevent redundant
  // light rays from causing massive slowdowns, if there's a huge amount of light.
  void add_light_source(int x, int y, float luminance);
  void apply_light_arc(int x, int y, int angle, float luminance, int wideangle = 30 );
- void apply_light_ray(bool lit[MAPSIZE*SEEX][MAPSIZE*SEEY],
-                      int sx, int sy, int ex, int ey, float luminance, bool trig_brightcalc = true);
+ // Adds the light of the queued light sources to the lightmap, only casting the rays of those
+ // that aren't in level_cache::light_cache or whose surroundings changed
+ void apply_light_sources( int zlev );
+ void cast_light_source( light_contribution &out, const light_source &source ) const;
+ void cast_light_arc( light_contribution &out, const light_source &source ) const;
+ void apply_light_ray( light_contribution &out, bool lit[MAPSIZE*SEEX][MAPSIZE*SEEY],
+                       int sx, int sy, int ex, int ey, float luminance, bool trig_brightcalc = true ) const;
  void add_light_from_items( const int x, const int y, std::list<item>::iterator begin,
                             std::list<item>::iterator end );
  void calc_ray_end(int angle, int range, int x, int y, int* outx, int* outy) const;
@@ -1295,5 +1487,16 @@ template<int xx, int xy, int yx, int yy>
                     const int offsetX, const int offsetY, const int offsetDistance,
                     const int row = 1, float start = 1.0f, const float end = 0.0f );
 
+class thread_pool;
+/**
+ * Casts all eight octants around the offset point into output_cache.
+ * With a pool the octants are cast in parallel into separate buffers which are
+ * then merged into output_cache, the result is the same as without one.
+ */
+void castLightAll( bool (&output_cache)[MAPSIZE*SEEX][MAPSIZE*SEEY],
+                   const float (&input_array)[MAPSIZE*SEEX][MAPSIZE*SEEY],
+                   const int offsetX, const int offsetY, const int offsetDistance = 0,
+                   thread_pool *pool = nullptr );
+
 #endif
 
@@ -0,0 +1,427 @@
+#include "map_pack.h"
+#include "debug.h"
+#include "filesystem.h"
+#include "mapsharing.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <set>
+#include <sstream>
+
+#if (defined _WIN32 || defined __WIN32__)
+#else
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#endif
+
+#define dbg(x) DebugLog((DebugLevel)(x),D_MAP) << __FILE__ << ":" << __LINE__ << ": "
+
+namespace
+{
+
+const char pack_magic[4] = { 'C', 'S', 'P', 'K' };
+const char footer_magic[4] = { 'C', 'S', 'P', 'E' };
+const std::uint32_t pack_version = 1;
+const size_t header_size = 8;
+// kind, x, y, z, size of the data, checksum of the data
+const size_t record_header_size = 24;
+// x, y, z, offset of the record, size of the data
+const size_t index_entry_size = 24;
+// offset of the index record, size of its data, magic
+const size_t footer_size = 16;
+
+const std::uint32_t record_quad = 1;
+const std::uint32_t record_index = 2;
+
+// Rewrite the pack once its garbage exceeds both its current data and this
+const std::uint64_t min_compact_garbage = 64 * 1024;
+
+// The numbers are little endian no matter the platform
+void put_u32( std::string &out, std::uint32_t value )
+{
+    for( int i = 0; i < 4; i++ ) {
+        out.push_back( static_cast<char>( ( value >> ( 8 * i ) ) & 0xff ) );
+    }
+}
+
+void put_u64( std::string &out, std::uint64_t value )
+{
+    put_u32( out, static_cast<std::uint32_t>( value ) );
+    put_u32( out, static_cast<std::uint32_t>( value >> 32 ) );
+}
+
+std::uint32_t get_u32( const char *p )
+{
+    std::uint32_t value = 0;
+    for( int i = 0; i < 4; i++ ) {
+        value |= static_cast<std::uint32_t>( static_cast<unsigned char>( p[i] ) ) << ( 8 * i );
+    }
+    return value;
+}
+
+std::uint64_t get_u64( const char *p )
+{
+    return get_u32( p ) | static_cast<std::uint64_t>( get_u32( p + 4 ) ) << 32;
+}
+
+// FNV-1a
+std::uint32_t checksum( const char *data, size_t size )
+{
+    std::uint32_t hash = 2166136261u;
+    for( size_t i = 0; i < size; i++ ) {
+        hash ^= static_cast<unsigned char>( data[i] );
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+void put_record( std::string &out, std::uint32_t kind, const tripoint &p, const char *data,
+                 size_t size )
+{
+    put_u32( out, kind );
+    put_u32( out, static_cast<std::uint32_t>( p.x ) );
+    put_u32( out, static_cast<std::uint32_t>( p.y ) );
+    put_u32( out, static_cast<std::uint32_t>( p.z ) );
+    put_u32( out, static_cast<std::uint32_t>( size ) );
+    put_u32( out, checksum( data, size ) );
+    out.append( data, size );
+}
+
+tripoint get_tripoint( const char *p )
+{
+    return tripoint( static_cast<std::int32_t>( get_u32( p ) ),
+                     static_cast<std::int32_t>( get_u32( p + 4 ) ),
+                     static_cast<std::int32_t>( get_u32( p + 8 ) ) );
+}
+
+// The record with the offset table, which starts at `index_offset`, followed by the footer.
+template<typename Index>
+std::string index_and_footer( const Index &records, std::uint64_t index_offset )
+{
+    std::string table;
+    put_u32( table, static_cast<std::uint32_t>( records.size() ) );
+    for( auto &elem : records ) {
+        put_u32( table, static_cast<std::uint32_t>( elem.first.x ) );
+        put_u32( table, static_cast<std::uint32_t>( elem.first.y ) );
+        put_u32( table, static_cast<std::uint32_t>( elem.first.z ) );
+        put_u64( table, elem.second.offset );
+        put_u32( table, elem.second.size );
+    }
+    std::string out;
+    put_record( out, record_index, tripoint( 0, 0, 0 ), table.data(), table.size() );
+    put_u64( out, index_offset );
+    put_u32( out, static_cast<std::uint32_t>( table.size() ) );
+    out.append( footer_magic, sizeof( footer_magic ) );
+    return out;
+}
+
+std::string read_file( const std::string &path )
+{
+    std::ifstream fin( path.c_str(), std::ios_base::in | std::ios_base::binary );
+    std::ostringstream data;
+    data << fin.rdbuf();
+    return data.str();
+}
+
+}
+
+map_pack::map_pack( const std::string &path )
+{
+    map_file( path );
+    if( size < header_size || memcmp( data, pack_magic, sizeof( pack_magic ) ) != 0 ||
+        get_u32( data + 4 ) > pack_version ) {
+        if( size > 0 ) {
+            dbg( D_ERROR ) << path << " is not a map pack";
+        }
+        return;
+    }
+    load_index();
+    if( !complete ) {
+        scan_records();
+        dbg( D_WARNING ) << path << " has no offset table, read it up to offset " << valid_end;
+    }
+}
+
+map_pack::~map_pack()
+{
+#if !(defined _WIN32 || defined __WIN32__)
+    if( mapped ) {
+        munmap( const_cast<char *>( data ), size );
+    }
+#endif
+}
+
+void map_pack::map_file( const std::string &path )
+{
+#if (defined _WIN32 || defined __WIN32__)
+    buffer = read_file( path );
+#else
+    const int fd = open( path.c_str(), O_RDONLY );
+    if( fd == -1 ) {
+        return;
+    }
+    struct stat info;
+    if( fstat( fd, &info ) == 0 && info.st_size > 0 ) {
+        void *const mapping = mmap( nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+        if( mapping != MAP_FAILED ) {
+            data = static_cast<const char *>( mapping );
+            size = info.st_size;
+            mapped = true;
+        }
+    }
+    close( fd );
+    if( mapped ) {
+        return;
+    }
+    buffer = read_file( path );
+#endif
+    data = buffer.data();
+    size = buffer.size();
+}
+
+void map_pack::load_index()
+{
+    if( size < header_size + record_header_size + footer_size ) {
+        return;
+    }
+    const char *const footer = data + size - footer_size;
+    if( memcmp( footer + 12, footer_magic, sizeof( footer_magic ) ) != 0 ) {
+        return;
+    }
+    const std::uint64_t index_offset = get_u64( footer );
+    const std::uint32_t table_size = get_u32( footer + 8 );
+    if( index_offset < header_size ||
+        index_offset + record_header_size + table_size + footer_size != size ) {
+        return;
+    }
+    const char *const record = data + index_offset;
+    const char *const table = record + record_header_size;
+    if( get_u32( record ) != record_index || get_u32( record + 16 ) != table_size ||
+        get_u32( record + 20 ) != checksum( table, table_size ) || table_size < 4 ) {
+        return;
+    }
+    const std::uint32_t count = get_u32( table );
+    if( ( table_size - 4 ) / index_entry_size < count ) {
+        return;
+    }
+    for( std::uint32_t i = 0; i < count; i++ ) {
+        const char *const p = table + 4 + i * index_entry_size;
+        const entry e{ get_u64( p + 12 ), get_u32( p + 20 ) };
+        if( e.offset < header_size || e.offset + record_header_size + e.size > index_offset ) {
+            index.clear();
+            live_size = 0;
+            return;
+        }
+        index[get_tripoint( p )] = e;
+        live_size += record_header_size + e.size;
+    }
+    valid_end = size;
+    complete = true;
+}
+
+void map_pack::scan_records()
+{
+    index.clear();
+    live_size = 0;
+    size_t pos = header_size;
+    while( size - pos >= record_header_size ) {
+        const char *const record = data + pos;
+        const std::uint32_t kind = get_u32( record );
+        const std::uint32_t record_size = get_u32( record + 16 );
+        if( ( kind != record_quad && kind != record_index ) ||
+            size - pos - record_header_size < record_size ||
+            get_u32( record + 20 ) != checksum( record + record_header_size, record_size ) ) {
+            break;
+        }
+        size_t next = pos + record_header_size + record_size;
+        if( kind == record_index ) {
+            // Followed by the footer
+            if( size - next < footer_size ) {
+                break;
+            }
+            next += footer_size;
+        } else {
+            index[get_tripoint( record + 4 )] = entry{ pos, record_size };
+        }
+        pos = next;
+    }
+    for( auto &elem : index ) {
+        live_size += record_header_size + elem.second.size;
+    }
+    valid_end = pos;
+}
+
+bool map_pack::find( const tripoint &om_addr, const char *&quad_data, size_t &quad_size ) const
+{
+    const auto iter = index.find( om_addr );
+    if( iter == index.end() ) {
+        return false;
+    }
+    const char *const record = data + iter->second.offset;
+    quad_data = record + record_header_size;
+    quad_size = iter->second.size;
+    if( get_u32( record ) != record_quad || get_tripoint( record + 4 ) != om_addr ||
+        get_u32( record + 20 ) != checksum( quad_data, quad_size ) ) {
+        throw std::string( "the data of the quad in the map pack is damaged" );
+    }
+    return true;
+}
+
+std::vector<tripoint> map_pack::quads() const
+{
+    std::vector<tripoint> result;
+    for( auto &elem : index ) {
+        result.push_back( elem.first );
+    }
+    return result;
+}
+
+bool map_pack::write( const std::string &path, const quad_list &quads )
+{
+    const map_pack old( path );
+    std::uint64_t new_size = 0;
+    std::set<tripoint> new_quads;
+    for( auto &elem : quads ) {
+        new_size += record_header_size + elem.second.size();
+        new_quads.insert( elem.first );
+    }
+    std::uint64_t live_size = old.live_size + new_size;
+    for( auto &elem : old.index ) {
+        if( new_quads.count( elem.first ) > 0 ) {
+            live_size -= record_header_size + elem.second.size;
+        }
+    }
+    const std::uint64_t garbage = old.size + new_size - header_size - live_size;
+    if( !old.complete || ( garbage > live_size && garbage > min_compact_garbage ) ) {
+        return compact( path, old, quads );
+    }
+
+    std::map<tripoint, entry> index = old.index;
+    std::string out;
+    for( auto &elem : quads ) {
+        index[elem.first] = entry{ old.size + out.size(), static_cast<std::uint32_t>( elem.second.size() ) };
+        put_record( out, record_quad, elem.first, elem.second.data(), elem.second.size() );
+    }
+    out += index_and_footer( index, old.size + out.size() );
+
+    std::ofstream fout;
+    fout.exceptions( std::ios::badbit | std::ios::failbit );
+    try {
+        fout.open( path.c_str(), std::ios_base::out | std::ios_base::app | std::ios_base::binary );
+        fout.write( out.data(), out.size() );
+        fout.close();
+    } catch( const std::ios::failure & ) {
+        // Readers ignore the partial records at the end
+        return false;
+    }
+    return true;
+}
+
+bool map_pack::compact( const std::string &path, const map_pack &old, const quad_list &quads )
+{
+    std::map<tripoint, const std::string *> new_quads;
+    for( auto &elem : quads ) {
+        new_quads[elem.first] = &elem.second;
+    }
+    std::map<tripoint, entry> index;
+    std::string out( pack_magic, sizeof( pack_magic ) );
+    put_u32( out, pack_version );
+    for( auto &elem : old.index ) {
+        if( new_quads.count( elem.first ) == 0 ) {
+            index[elem.first] = entry{ out.size(), elem.second.size };
+            put_record( out, record_quad, elem.first,
+                        old.data + elem.second.offset + record_header_size, elem.second.size );
+        }
+    }
+    for( auto &elem : new_quads ) {
+        index[elem.first] = entry{ out.size(), static_cast<std::uint32_t>( elem.second->size() ) };
+        put_record( out, record_quad, elem.first, elem.second->data(), elem.second->size() );
+    }
+    out += index_and_footer( index, out.size() );
+
+    const std::string temp_path = path + ".temp";
+    std::ofstream fout;
+    fout.exceptions( std::ios::badbit | std::ios::failbit );
+    try {
+        fout.open( temp_path.c_str(), std::ios_base::out | std::ios_base::trunc | std::ios_base::binary );
+        fout.write( out.data(), out.size() );
+        fout.close();
+    } catch( const std::ios::failure & ) {
+        remove_file( temp_path );
+        return false;
+    }
+    if( !rename_file( temp_path, path ) ) {
+        remove_file( temp_path );
+        return false;
+    }
+    return true;
+}
+
+std::string map_pack::path( const std::string &maps_dir, const tripoint &segment_addr )
+{
+    std::ostringstream result;
+    result << maps_dir << "/" << segment_addr.x << "." << segment_addr.y << "." << segment_addr.z <<
+           ".pack";
+    return result.str();
+}
+
+int map_pack::migrate( const std::string &maps_dir )
+{
+    // Quad files are <maps_dir>/<segment x.y.z>/<quad x.y.z>.map
+    std::map<tripoint, std::vector<std::pair<tripoint, std::string>>> segments;
+    for( auto &file_path : get_files_from_path( ".map", maps_dir, true, true ) ) {
+        const size_t name_start = file_path.find_last_of( "/\\" );
+        if( name_start == std::string::npos || name_start <= maps_dir.size() ) {
+            continue;
+        }
+        const std::string dir = file_path.substr( maps_dir.size() + 1,
+                                name_start - maps_dir.size() - 1 );
+        const std::string name = file_path.substr( name_start + 1 );
+        tripoint segment_addr;
+        tripoint om_addr;
+        char end;
+        if( sscanf( dir.c_str(), "%d.%d.%d%c", &segment_addr.x, &segment_addr.y, &segment_addr.z,
+                    &end ) != 3 ||
+            sscanf( name.c_str(), "%d.%d.%d.ma%c", &om_addr.x, &om_addr.y, &om_addr.z, &end ) != 4 ) {
+            continue;
+        }
+        segments[segment_addr].emplace_back( om_addr, file_path );
+    }
+
+    int moved = 0;
+    for( auto &segment : segments ) {
+        const std::string pack_path = path( maps_dir, segment.first );
+        const std::string lock_path = pack_path + ".lock";
+        const int lock = getLock( lock_path.c_str() );
+        if( lock == -1 ) {
+            dbg( D_ERROR ) << "could not lock " << pack_path;
+            return -1;
+        }
+        quad_list quads;
+        {
+            const map_pack pack( pack_path );
+            for( auto &elem : segment.second ) {
+                if( pack.index.count( elem.first ) == 0 ) {
+                    quads.emplace_back( elem.first, read_file( elem.second ) );
+                }
+            }
+        }
+        const bool success = quads.empty() || write( pack_path, quads );
+        releaseLock( lock, lock_path.c_str() );
+        if( !success ) {
+            dbg( D_ERROR ) << "could not write " << pack_path;
+            return -1;
+        }
+        for( auto &elem : segment.second ) {
+            remove_file( elem.second );
+        }
+        // The directory of the segment, if it is empty now
+        const std::string &any_file = segment.second.front().second;
+        remove( any_file.substr( 0, any_file.find_last_of( "/\\" ) ).c_str() );
+        moved += quads.size();
+    }
+    return moved;
+}
@@ -0,0 +1,88 @@
+#ifndef MAP_PACK_H
+#define MAP_PACK_H
+
+#include "enums.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * The saved quads of one map segment (32x32 overmap terrains), kept in a single file instead
+ * of one file per quad.
+ *
+ * The file is a header followed by records, each with the data of one quad. Saving appends the
+ * new records and an offset table of the current ones, which ends the file, so the records it
+ * replaced become garbage. Once there is more garbage than current data, saving rewrites the
+ * file without it. Records carry a checksum: if a save was cut short, the offset table at the
+ * end is broken, and reading falls back to scanning the records up to the damage.
+ *
+ * Reading maps the file into memory, so only the quads that are looked up are read from disk.
+ */
+class map_pack
+{
+    public:
+        typedef std::vector<std::pair<tripoint, std::string>> quad_list;
+
+        /** Opens the pack at `path`, an empty pack if there is no such file. */
+        explicit map_pack( const std::string &path );
+        ~map_pack();
+
+        map_pack( const map_pack & ) = delete;
+        map_pack &operator=( const map_pack & ) = delete;
+
+        /**
+         * Finds the data of the quad at `om_addr`, which is valid as long as the pack is open.
+         * @return false if the pack doesn't have the quad.
+         * @throws std::string if the data of the quad is damaged.
+         */
+        bool find( const tripoint &om_addr, const char *&data, size_t &size ) const;
+        /** The quads in the pack. */
+        std::vector<tripoint> quads() const;
+
+        /**
+         * Adds the quads to the pack at `path`, replacing the ones it had at the same places.
+         * The caller must hold the lock of the file, see @ref fopen_exclusive.
+         * @return false if the file could not be written, it is left as it was then.
+         */
+        static bool write( const std::string &path, const quad_list &quads );
+        /** The path of the pack of the segment `segment_addr` in the directory `maps_dir`. */
+        static std::string path( const std::string &maps_dir, const tripoint &segment_addr );
+        /**
+         * Moves the quad files that older versions saved in `maps_dir`, one directory per
+         * segment, into the packs of the segments. Quads the packs already have are newer and
+         * are kept.
+         * @return the number of quads that were moved, or -1 if a pack could not be written.
+         */
+        static int migrate( const std::string &maps_dir );
+
+    private:
+        struct entry {
+            std::uint64_t offset;
+            std::uint32_t size;
+        };
+
+        void map_file( const std::string &path );
+        void load_index();
+        void scan_records();
+        static bool compact( const std::string &path, const map_pack &old, const quad_list &quads );
+
+        const char *data = nullptr;
+        size_t size = 0;
+        // Copy of the file where it can't be mapped
+        std::string buffer;
+        bool mapped = false;
+        // Offset of the records of the current quads
+        std::map<tripoint, entry> index;
+        // Where the undamaged part of the file ends
+        size_t valid_end = 0;
+        // Whether the file ends with a complete offset table
+        bool complete = false;
+        // Size of the records of the current quads
+        std::uint64_t live_size = 0;
+};
+
+#endif
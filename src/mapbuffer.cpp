@@ -12,14 +12,45 @@
 #include "map.h"
 #include "trap.h"
 #include "vehicle.h"
+#include "map_pack.h"
+#include "submap_io.h"
+#include "save_worker.h"
 
-#include <fstream>
+#include <algorithm>
 #include <sstream>
 
 #define dbg(x) DebugLog((DebugLevel)(x),D_MAP) << __FILE__ << ":" << __LINE__ << ": "
 
 mapbuffer MAPBUFFER;
 
+struct mapbuffer::segment_batch {
+    // The snapshots of the quads
+    std::vector<std::pair<tripoint, submap_io::quad_in>> quads;
+};
+
+// Rough estimate of the memory of a submap: dynamic parts are counted by their elements plus
+// the overhead of the list and map nodes. Fields are mostly stored inline, in the submap itself.
+static size_t submap_memory( const submap &sm )
+{
+    const size_t node = 2 * sizeof( void * );
+    size_t bytes = sizeof( submap );
+    for( int x = 0; x < SEEX; x++ ) {
+        for( int y = 0; y < SEEY; y++ ) {
+            for( const item &it : sm.itm[x][y] ) {
+                bytes += node + sizeof( item ) + it.contents.capacity() * sizeof( item );
+            }
+            for( const auto &elem : sm.cosmetics[x][y] ) {
+                bytes += 2 * node + sizeof( elem ) + elem.first.capacity() + elem.second.capacity();
+            }
+        }
+    }
+    bytes += sm.spawns.capacity() * sizeof( spawn_point );
+    for( const vehicle *veh : sm.vehicles ) {
+        bytes += sizeof( vehicle ) + veh->parts.capacity() * sizeof( vehicle_part );
+    }
+    return bytes;
+}
+
 mapbuffer::mapbuffer()
 {
 }
@@ -35,6 +66,10 @@ void mapbuffer::reset()
         delete elem.second;
     }
     submaps.clear();
+    packs.clear();
+    failed_packs.clear();
+    grown = false;
+    evicted_quads = 0;
 }
 
 bool mapbuffer::add_submap(const tripoint &p, submap *sm)
@@ -44,6 +79,10 @@ bool mapbuffer::add_submap(const tripoint &p, submap *sm)
     }
 
     submaps[p] = sm;
+    if( sm != nullptr ) {
+        sm->last_used = use_clock;
+    }
+    grown = true;
 
     return true;
 }
@@ -97,15 +136,154 @@ submap *mapbuffer::lookup_submap( const tripoint &p )
         return NULL;
     }
 
+    if( iter->second != nullptr ) {
+        iter->second->last_used = use_clock;
+    }
     return iter->second;
 }
 
+mapbuffer::memory_stats mapbuffer::get_memory_stats() const
+{
+    memory_stats stats;
+    std::set<tripoint> quads;
+    for( auto &elem : submaps ) {
+        if( elem.second == nullptr ) {
+            continue;
+        }
+        stats.submaps++;
+        stats.bytes += submap_memory( *elem.second );
+        quads.insert( overmapbuffer::sm_to_omt_copy( elem.first ) );
+    }
+    stats.quads = quads.size();
+    stats.evicted_quads = evicted_quads;
+    return stats;
+}
+
+// Turns until the quads of a pack that failed to be written are evicted again, it may be locked
+// by another game for a while
+static const int failed_write_retry_turns = 100;
+
+void mapbuffer::evict( const map &m, size_t budget )
+{
+    for( auto iter = failed_packs.begin(); iter != failed_packs.end(); ) {
+        if( iter->second <= int( calendar::turn ) ) {
+            // Those quads were put back without counting as growth
+            grown = true;
+            iter = failed_packs.erase( iter );
+        } else {
+            ++iter;
+        }
+    }
+    // Nothing to do unless the buffer grew or the budget shrank since last time
+    if( budget == 0 || ( !grown && budget >= last_budget ) ) {
+        return;
+    }
+    grown = false;
+    last_budget = budget;
+    use_clock++;
+
+    // The grid and a quad around it, stepping back and forth across the edge of the grid
+    // shouldn't write and load the same quads every time.
+    const int margin = 2;
+    const tripoint abs_sub = m.get_abs_sub();
+    const int min_x = abs_sub.x - margin;
+    const int min_y = abs_sub.y - margin;
+    const int max_x = abs_sub.x + m.getmapsize() - 1 + margin;
+    const int max_y = abs_sub.y + m.getmapsize() - 1 + margin;
+
+    struct quad_info {
+        size_t bytes = 0;
+        int last_used = 0;
+        bool keep = false;
+    };
+    std::map<tripoint, quad_info> quads;
+    size_t total = 0;
+    for( auto &elem : submaps ) {
+        if( elem.second == nullptr ) {
+            continue;
+        }
+        const tripoint &p = elem.first;
+        quad_info &quad = quads[overmapbuffer::sm_to_omt_copy( p )];
+        const size_t bytes = submap_memory( *elem.second );
+        quad.bytes += bytes;
+        total += bytes;
+        if( p.x >= min_x && p.x <= max_x && p.y >= min_y && p.y <= max_y &&
+            ( m.has_zlevels() || p.z == abs_sub.z ) ) {
+            quad.keep = true;
+        }
+        for( const vehicle *veh : elem.second->vehicles ) {
+            if( veh->engine_on || veh->velocity != 0 ) {
+                quad.keep = true;
+            }
+        }
+        if( quad.keep ) {
+            // Recently used once they are left behind
+            elem.second->last_used = use_clock;
+        }
+        quad.last_used = std::max( quad.last_used, elem.second->last_used );
+    }
+    const std::string map_directory = world_generator->active_world->world_path + "/maps";
+    std::vector<std::pair<int, tripoint>> candidates;
+    for( auto &elem : quads ) {
+        if( elem.second.keep ) {
+            continue;
+        }
+        if( !failed_packs.empty() && failed_packs.count( map_pack::path( map_directory,
+                overmapbuffer::omt_to_seg_copy( elem.first ) ) ) != 0 ) {
+            continue;
+        }
+        candidates.emplace_back( elem.second.last_used, elem.first );
+    }
+    if( total <= budget ) {
+        return;
+    }
+    std::sort( candidates.begin(), candidates.end() );
+
+    assure_dir_exist( map_directory );
+    // Quads that failed to be written last time are dirty again
+    save_worker::instance().collect();
+
+    // Evicting down to less than the budget, the next quads don't evict more right away
+    const size_t target = budget / 4 * 3;
+    const size_t total_before = total;
+    size_t num_evicted = 0;
+    std::list<tripoint> submaps_to_delete;
+    std::map<tripoint, std::shared_ptr<segment_batch>> batches;
+    for( auto &candidate : candidates ) {
+        if( total <= target ) {
+            break;
+        }
+        const tripoint &om_addr = candidate.second;
+        std::shared_ptr<segment_batch> &batch = batches[overmapbuffer::omt_to_seg_copy( om_addr )];
+        if( !batch ) {
+            batch = std::make_shared<segment_batch>();
+        }
+        save_quad( om_addr, *batch, submaps_to_delete, true );
+        total -= quads[om_addr].bytes;
+        num_evicted++;
+    }
+    for( auto &elem : batches ) {
+        if( !elem.second->quads.empty() ) {
+            save_segment( map_pack::path( map_directory, elem.first ), elem.second );
+        }
+    }
+    for( auto &elem : submaps_to_delete ) {
+        remove_submap( elem );
+    }
+    evicted_quads += num_evicted;
+    dbg( D_INFO ) << "mapbuffer::evict: " << num_evicted << " quads, from " << total_before <<
+                  " to " << total << " bytes, budget " << budget;
+}
+
 void mapbuffer::save( bool delete_after_save )
 {
     std::stringstream map_directory;
     map_directory << world_generator->active_world->world_path << "/maps";
     assure_dir_exist( map_directory.str().c_str() );
 
+    // Quads that failed to be written last time are dirty again
+    save_worker::instance().collect();
+
     int num_saved_submaps = 0;
     int num_total_submaps = submaps.size();
 
@@ -115,6 +293,7 @@ void mapbuffer::save( bool delete_after_save )
     // A set of already-saved submaps, in global overmap coordinates.
     std::set<tripoint> saved_submaps;
     std::list<tripoint> submaps_to_delete;
+    std::map<tripoint, std::shared_ptr<segment_batch>> batches;
     for( auto &elem : submaps ) {
         if (num_total_submaps > 100 && num_saved_submaps % 100 == 0) {
             popup_nowait(_("Please wait as the map saves [%d/%d]"),
@@ -131,36 +310,35 @@ void mapbuffer::save( bool delete_after_save )
         }
         saved_submaps.insert( om_addr );
 
-        // A segment is a chunk of 32x32 submap quads.
-        // We're breaking them into subdirectories so there aren't too many files per directory.
-        // Might want to make a set for this one too so it's only checked once per save().
-        std::stringstream dirname;
-        tripoint segment_addr = overmapbuffer::omt_to_seg_copy( om_addr );
-        dirname << map_directory.str() << "/" << segment_addr.x << "." <<
-                     segment_addr.y << "." << segment_addr.z;
-
-        std::stringstream quad_path;
-        quad_path << dirname.str() << "/" << om_addr.x << "." <<
-                  om_addr.y << "." << om_addr.z << ".map";
+        // A segment is a chunk of 32x32 submap quads, all of which are stored in one pack file.
+        const tripoint segment_addr = overmapbuffer::omt_to_seg_copy( om_addr );
+        std::shared_ptr<segment_batch> &batch = batches[segment_addr];
+        if( !batch ) {
+            batch = std::make_shared<segment_batch>();
+        }
 
         // delete_on_save deletes everything, otherwise delete submaps
         // outside the current map.
         const bool zlev_del = !map_has_zlevels && om_addr.z != g->get_levz();
-        save_quad( dirname.str(), quad_path.str(), om_addr, submaps_to_delete,
+        save_quad( om_addr, *batch, submaps_to_delete,
                    delete_after_save || zlev_del ||
                    om_addr.x < map_origin.x || om_addr.y < map_origin.y ||
                    om_addr.x > map_origin.x + (MAPSIZE / 2) ||
                    om_addr.y > map_origin.y + (MAPSIZE / 2) );
         num_saved_submaps += 4;
     }
+    for( auto &elem : batches ) {
+        if( !elem.second->quads.empty() ) {
+            save_segment( map_pack::path( map_directory.str(), elem.first ), elem.second );
+        }
+    }
     for( auto &elem : submaps_to_delete ) {
         remove_submap( elem );
     }
 }
 
-void mapbuffer::save_quad( const std::string &dirname, const std::string &filename, 
-                           const tripoint &om_addr, std::list<tripoint> &submaps_to_delete, 
-                           bool delete_after_save )
+void mapbuffer::save_quad( const tripoint &om_addr, segment_batch &batch,
+                           std::list<tripoint> &submaps_to_delete, bool delete_after_save )
 {
     std::vector<point> offsets;
     std::vector<tripoint> submap_addrs;
@@ -170,6 +348,7 @@ void mapbuffer::save_quad( const std::string &dirname, const std::string &filena
     offsets.push_back( point(1, 1) );
 
     bool all_uniform = true;
+    bool any_dirty = false;
     for( auto &offsets_offset : offsets ) {
         tripoint submap_addr = overmapbuffer::omt_to_sm_copy( om_addr );
         submap_addr.x += offsets_offset.x;
@@ -179,10 +358,14 @@ void mapbuffer::save_quad( const std::string &dirname, const std::string &filena
         if( sm != nullptr && !sm->is_uniform ) {
             all_uniform = false;
         }
+        if( sm != nullptr && sm->dirty ) {
+            any_dirty = true;
+        }
     }
     
-    if( all_uniform ) {
-        // Nothing to save - this quad will be regenerated faster than it would be re-read
+    if( all_uniform || !any_dirty ) {
+        // Nothing to save - this quad will be regenerated faster than it would be re-read,
+        // or the file (or a queued write of it) already has the current data
         if( delete_after_save ) {
             for( auto &submap_addr : submap_addrs ) {
                 if( submaps.count( submap_addr ) > 0 && submaps[submap_addr] != nullptr ) {
@@ -194,16 +377,9 @@ void mapbuffer::save_quad( const std::string &dirname, const std::string &filena
         return;
     }
 
-    // Don't create the directory if it would be empty
-    assure_dir_exist( dirname.c_str() );
-    std::ofstream fout;
-    fopen_exclusive( fout, filename.c_str() );
-    if( !fout.is_open() ) {
-        return;
-    }
-
-    JsonOut jsout( fout );
-    jsout.start_array();
+    // The worker writes copies, the submaps may change or be deleted right away
+    batch.quads.emplace_back( om_addr, submap_io::quad_in() );
+    submap_io::quad_in &snapshot = batch.quads.back().second;
     for( auto &submap_addr : submap_addrs ) {
         if( submaps.count( submap_addr ) == 0 ) {
             continue;
@@ -213,399 +389,108 @@ void mapbuffer::save_quad( const std::string &dirname, const std::string &filena
         if( sm == nullptr ) {
             continue;
         }
-
-        jsout.start_object();
-
-        jsout.member( "version", savegame_version);
-
-        jsout.member( "coordinates" );
-        jsout.start_array();
-        jsout.write( submap_addr.x );
-        jsout.write( submap_addr.y );
-        jsout.write( submap_addr.z );
-        jsout.end_array();
-
-        jsout.member( "turn_last_touched", sm->turn_last_touched );
-        jsout.member( "temperature", sm->temperature );
-
-        jsout.member( "terrain" );
-        jsout.start_array();
-        for(int j = 0; j < SEEY; j++) {
-            for(int i = 0; i < SEEX; i++) {
-                // Save terrains
-                jsout.write( terlist[sm->ter[i][j]].id );
-            }
-        }
-        jsout.end_array();
-
-        // Write out the radiation array in a simple RLE scheme.
-        // written in intensity, count pairs
-        jsout.member( "radiation" );
-        jsout.start_array();
-        int lastrad = -1;
-        int count = 0;
-        for(int j = 0; j < SEEY; j++) {
-            for(int i = 0; i < SEEX; i++) {
-                // Save radiation, re-examine this because it doesnt look like it works right
-                int r = sm->get_radiation(i, j);
-                if (r == lastrad) {
-                    count++;
-                } else {
-                    if (count) {
-                        jsout.write( count );
-                    }
-                    jsout.write( r );
-                    lastrad = r;
-                    count = 1;
-                }
-            }
-        }
-        jsout.write( count );
-        jsout.end_array();
-
-        jsout.member("furniture");
-        jsout.start_array();
-        for(int j = 0; j < SEEY; j++) {
-            for(int i = 0; i < SEEX; i++) {
-                // Save furniture
-                if( sm->get_furn( i, j ) != f_null ) {
-                    jsout.start_array();
-                    jsout.write( i );
-                    jsout.write( j );
-                    jsout.write( furnlist[ sm->get_furn( i, j ) ].id );
-                    jsout.end_array();
-                }
-            }
-        }
-        jsout.end_array();
-
-        jsout.member( "items" );
-        jsout.start_array();
-        for(int j = 0; j < SEEY; j++) {
-            for(int i = 0; i < SEEX; i++) {
-                if( sm->itm[i][j].empty() ) {
-                    continue;
-                }
-                jsout.write( i );
-                jsout.write( j );
-                jsout.write( sm->itm[i][j] );
-            }
+        snapshot.emplace_back( submap_addr, submap_io::snapshot( *sm ) );
+        sm->dirty = false;
+        if( delete_after_save ) {
+            submaps_to_delete.push_back( submap_addr );
         }
-        jsout.end_array();
-
-        jsout.member( "traps" );
-        jsout.start_array();
-        for(int j = 0; j < SEEY; j++) {
-            for(int i = 0; i < SEEX; i++) {
-                // Save traps
-                if (sm->get_trap( i, j ) != tr_null) {
-                    jsout.start_array();
-                    jsout.write( i );
-                    jsout.write( j );
-                    // TODO: jsout should support writting an id like jsout.write( trap_id )
-                    jsout.write( sm->get_trap( i, j ).id().str() );
-                    jsout.end_array();
-                }
+    }
+}
+
+void mapbuffer::save_segment( const std::string &pack_path, std::shared_ptr<segment_batch> batch )
+{
+    // Opened again when it is read after the write
+    packs.erase( pack_path );
+    save_worker::instance().update( pack_path, [batch]( const std::string &path ) {
+        map_pack::quad_list quads;
+        for( auto &quad : batch->quads ) {
+            submap_io::quad_out submaps;
+            for( auto &elem : quad.second ) {
+                submaps.emplace_back( elem.first, elem.second.get() );
             }
+            std::ostringstream data;
+            submap_io::write_quad( data, submaps );
+            quads.emplace_back( quad.first, data.str() );
         }
-        jsout.end_array();
-
-        jsout.member( "fields" );
-        jsout.start_array();
-        for(int j = 0; j < SEEY; j++) {
-            for(int i = 0; i < SEEX; i++) {
-                // Save fields
-                if (sm->fld[i][j].fieldCount() > 0) {
-                    jsout.write( i );
-                    jsout.write( j );
-                    jsout.start_array();
-                    for( auto &fld : sm->fld[i][j] ) {
-                        const field_entry &cur = fld.second;
-                            // We don't seem to have a string identifier for fields anywhere.
-                            jsout.write( cur.getFieldType() );
-                            jsout.write( cur.getFieldDensity() );
-                            jsout.write( cur.getFieldAge() );
+        return map_pack::write( path, quads );
+    }, [this, batch, pack_path]() {
+        // Try again on the next save. Submaps that were deleted after they were queued only
+        // exist in the snapshots now, those are put back. That isn't growth, evict would queue
+        // the same write every turn while the pack is locked, it waits a while instead.
+        const bool was_grown = grown;
+        for( auto &quad : batch->quads ) {
+            for( auto &elem : quad.second ) {
+                auto iter = submaps.find( elem.first );
+                if( iter != submaps.end() && iter->second != nullptr ) {
+                    iter->second->dirty = true;
+                } else if( elem.second ) {
+                    if( iter != submaps.end() ) {
+                        submaps.erase( iter );
                     }
-                    jsout.end_array();
+                    elem.second->dirty = true;
+                    add_submap( elem.first, elem.second );
                 }
             }
         }
-        jsout.end_array();
-
-        jsout.member("cosmetics");
-        jsout.start_array();
-        for (int j = 0; j < SEEY; j++) {
-            for (int i = 0; i < SEEX; i++) {
-                if (sm->cosmetics[i][j].size() > 0) {
-                    jsout.start_array();
-                    jsout.write(i);
-                    jsout.write(j);
-                    jsout.write(sm->cosmetics[i][j]);
-                    jsout.end_array();
-                }
-            }
-        }
-        jsout.end_array();
-
-        // Output the spawn points
-        jsout.member( "spawns" );
-        jsout.start_array();
-        for( auto &elem : sm->spawns ) {
-            jsout.start_array();
-            jsout.write( elem.type );
-            jsout.write( elem.count );
-            jsout.write( elem.posx );
-            jsout.write( elem.posy );
-            jsout.write( elem.faction_id );
-            jsout.write( elem.mission_id );
-            jsout.write( elem.friendly );
-            jsout.write( elem.name );
-            jsout.end_array();
-        }
-        jsout.end_array();
-
-        jsout.member( "vehicles" );
-        jsout.start_array();
-        for( auto &elem : sm->vehicles ) {
-            // json lib doesn't know how to turn a vehicle * into a vehicle,
-            // so we have to iterate manually.
-            jsout.write( *elem );
-        }
-        jsout.end_array();
-
-        // Output the computer
-        if (sm->comp.name != "") {
-            jsout.member( "computers", sm->comp.save_data() );
-        }
-
-        // Output base camp if any
-        if (sm->camp.is_valid()) {
-            jsout.member( "camp" );
-            jsout.write( sm->camp.save_data() );
-        }
-        if( delete_after_save ) {
-            submaps_to_delete.push_back( submap_addr );
-        }
-        jsout.end_object();
-    }
-
-    jsout.end_array();
-    fclose_exclusive( fout, filename.c_str() );
+        grown = was_grown;
+        failed_packs[pack_path] = int( calendar::turn ) + failed_write_retry_turns;
+    } );
 }
 
-// We're reading in way too many entities here to mess around with creating sub-objects and
-// seeking around in them, so we're using the json streaming API.
 submap *mapbuffer::unserialize_submaps( const tripoint &p )
 {
     // Map the tripoint to the submap quad that stores it.
     const tripoint om_addr = overmapbuffer::sm_to_omt_copy( p );
     const tripoint segment_addr = overmapbuffer::omt_to_seg_copy( om_addr );
-    std::stringstream quad_path;
-    quad_path << world_generator->active_world->world_path << "/maps/" <<
-              segment_addr.x << "." << segment_addr.y << "." << segment_addr.z << "/" <<
-              om_addr.x << "." << om_addr.y << "." << om_addr.z << ".map";
-
-    std::ifstream fin( quad_path.str().c_str() );
-    if( !fin.is_open() ) {
+    const std::string pack_path = map_pack::path( world_generator->active_world->world_path + "/maps",
+                                  segment_addr );
+
+    // The quad may have been saved and unloaded while its pack is still being written,
+    // if that failed it is back in the buffer
+    save_worker::instance().wait_for( pack_path );
+    save_worker::instance().collect();
+    if( submaps.count( p ) != 0 ) {
+        return submaps[p];
+    }
+    const char *data = nullptr;
+    size_t size = 0;
+    if( !get_pack( pack_path ).find( om_addr, data, size ) ) {
         // If it doesn't exist, trigger generating it.
         return NULL;
     }
 
-    JsonIn jsin( fin );
-    jsin.start_array();
-    while( !jsin.end_array() ) {
-        std::unique_ptr<submap> sm(new submap());
-        tripoint submap_coordinates;
-        jsin.start_object();
-        bool rubpow_update = false;
-        while( !jsin.end_object() ) {
-            std::string submap_member_name = jsin.get_member_name();
-            if( submap_member_name == "version" ) {
-                if (jsin.get_int() < 22) {
-                    rubpow_update = true;
-                }
-            } else if( submap_member_name == "coordinates" ) {
-                jsin.start_array();
-                int locx = jsin.get_int();
-                int locy = jsin.get_int();
-                int locz = jsin.get_int();
-                jsin.end_array();
-                submap_coordinates = tripoint( locx, locy, locz );
-            } else if( submap_member_name == "turn_last_touched" ) {
-                sm->turn_last_touched = jsin.get_int();
-            } else if( submap_member_name == "temperature" ) {
-                sm->temperature = jsin.get_int();
-            } else if( submap_member_name == "terrain" ) {
-                // TODO: try block around this to error out if we come up short?
-                jsin.start_array();
-                // Small duplication here so that the update check is only performed once
-                if (rubpow_update) {
-                    std::string ter_string;
-                    item rock = item("rock", 0);
-                    item chunk = item("steel_chunk", 0);
-                    for( int j = 0; j < SEEY; j++ ) {
-                        for( int i = 0; i < SEEX; i++ ) {
-                            ter_string = jsin.get_string();
-                            if (ter_string == "t_rubble") {
-                                sm->ter[i][j] = termap[ "t_dirt" ].loadid;
-                                sm->frn[i][j] = furnmap[ "f_rubble" ].loadid;
-                                sm->itm[i][j].push_back( rock );
-                                sm->itm[i][j].push_back( rock );
-                            } else if (ter_string == "t_wreckage"){
-                                sm->ter[i][j] = termap[ "t_dirt" ].loadid;
-                                sm->frn[i][j] = furnmap[ "f_wreckage" ].loadid;
-                                sm->itm[i][j].push_back( chunk );
-                                sm->itm[i][j].push_back( chunk );
-                            } else if (ter_string == "t_ash"){
-                                sm->ter[i][j] = termap[ "t_dirt" ].loadid;
-                                sm->frn[i][j] = furnmap[ "f_ash" ].loadid;
-                            } else if (ter_string == "t_pwr_sb_support_l"){
-                                sm->ter[i][j] = termap[ "t_support_l" ].loadid;
-                            } else if (ter_string == "t_pwr_sb_switchgear_l"){
-                                sm->ter[i][j] = termap[ "t_switchgear_l" ].loadid;
-                            } else if (ter_string == "t_pwr_sb_switchgear_s"){
-                                sm->ter[i][j] = termap[ "t_switchgear_s" ].loadid;
-                            } else {
-                                sm->ter[i][j] = terfind( ter_string );
-                            }
-                        }
-                    }
-                } else {
-                    for( int j = 0; j < SEEY; j++ ) {
-                        for( int i = 0; i < SEEX; i++ ) {
-                            sm->ter[i][j] = terfind( jsin.get_string() );
-                        }
-                    }
-                }
-                jsin.end_array();
-            } else if( submap_member_name == "radiation" ) {
-                int rad_cell = 0;
-                jsin.start_array();
-                while( !jsin.end_array() ) {
-                    int rad_strength = jsin.get_int();
-                    int rad_num = jsin.get_int();
-                    for( int i = 0; i < rad_num; ++i ) {
-                        // A little array trick here, assign to it as a 1D array.
-                        // If it's not in bounds we're kinda hosed anyway.
-                        sm->set_radiation(0, rad_cell, rad_strength);
-                        rad_cell++;
-                    }
-                }
-            } else if( submap_member_name == "furniture" ) {
-                jsin.start_array();
-                while( !jsin.end_array() ) {
-                    jsin.start_array();
-                    int i = jsin.get_int();
-                    int j = jsin.get_int();
-                    sm->frn[i][j] = furnmap[ jsin.get_string() ].loadid;
-                    jsin.end_array();
-                }
-            } else if( submap_member_name == "items" ) {
-                jsin.start_array();
-                while( !jsin.end_array() ) {
-                    int i = jsin.get_int();
-                    int j = jsin.get_int();
-                    jsin.start_array();
-                    while( !jsin.end_array() ) {
-                        item tmp;
-                        jsin.read( tmp );
-                        if( tmp.is_emissive() ) {
-                            sm->update_lum_add(tmp, i, j);
-                        }
-
-                        sm->itm[i][j].push_back( tmp );
-                        if( tmp.needs_processing() ) {
-                            sm->active_items.add( std::prev(sm->itm[i][j].end()), point( i, j ) );
-                        }
-                    }
-                }
-            } else if( submap_member_name == "traps" ) {
-                jsin.start_array();
-                while( !jsin.end_array() ) {
-                    jsin.start_array();
-                    int i = jsin.get_int();
-                    int j = jsin.get_int();
-                    // TODO: jsin should support returning an id like jsin.get_id<trap>()
-                    sm->trp[i][j] = trap_str_id( jsin.get_string() );
-                    jsin.end_array();
-                }
-            } else if( submap_member_name == "fields" ) {
-                jsin.start_array();
-                while( !jsin.end_array() ) {
-                    // Coordinates loop
-                    int i = jsin.get_int();
-                    int j = jsin.get_int();
-                    jsin.start_array();
-                    while( !jsin.end_array() ) {
-                        int type = jsin.get_int();
-                        int density = jsin.get_int();
-                        int age = jsin.get_int();
-                        if (sm->fld[i][j].findField(field_id(type)) == NULL) {
-                            sm->field_count++;
-                        }
-                        sm->fld[i][j].addField(field_id(type), density, age);
-                    }
-                }
-            } else if( submap_member_name == "graffiti" ) {
-                jsin.start_array();
-                while( !jsin.end_array() ) {
-                    jsin.start_array();
-                    int i = jsin.get_int();
-                    int j = jsin.get_int();
-                    sm->set_graffiti( i, j, jsin.get_string() );
-                    jsin.end_array();
-                }
-            } else if(submap_member_name == "cosmetics") {
-                jsin.start_array();
-                while (!jsin.end_array()) {
-                    jsin.start_array();
-                    int i = jsin.get_int();
-                    int j = jsin.get_int();
-                    jsin.read(sm->cosmetics[i][j]);
-                    jsin.end_array();
-                }
-            } else if( submap_member_name == "spawns" ) {
-                jsin.start_array();
-                while( !jsin.end_array() ) {
-                    jsin.start_array();
-                    std::string type = jsin.get_string();
-                    int count = jsin.get_int();
-                    int i = jsin.get_int();
-                    int j = jsin.get_int();
-                    int faction_id = jsin.get_int();
-                    int mission_id = jsin.get_int();
-                    bool friendly = jsin.get_bool();
-                    std::string name = jsin.get_string();
-                    jsin.end_array();
-                    spawn_point tmp( type, count, i, j, faction_id, mission_id, friendly, name );
-                    sm->spawns.push_back( tmp );
-                }
-            } else if( submap_member_name == "vehicles" ) {
-                jsin.start_array();
-                while( !jsin.end_array() ) {
-                    vehicle *tmp = new vehicle();
-                    jsin.read( *tmp );
-                    sm->vehicles.push_back( tmp );
-                }
-            } else if( submap_member_name == "computers" ) {
-                std::string computer_data = jsin.get_string();
-                sm->comp.load_data( computer_data );
-            } else if( submap_member_name == "camp" ) {
-                std::string camp_data = jsin.get_string();
-                sm->camp.load_data( camp_data );
-            } else {
-                jsin.skip_value();
-            }
-        }
-        if( !add_submap( submap_coordinates, sm ) ) {
+    // Binary and legacy JSON quads alike
+    submap_io::quad_in quad;
+    submap_io::read_quad( data, size, quad );
+    for( auto &elem : quad ) {
+        const tripoint &submap_coordinates = elem.first;
+        if( !add_submap( submap_coordinates, elem.second ) ) {
             debugmsg( "submap %d,%d,%d was alread loaded", submap_coordinates.x, submap_coordinates.y,
                       submap_coordinates.z );
         }
     }
     if( submaps.count( p ) == 0 ) {
-        debugmsg("file %s did not contain the expected submap %d,%d,%d", quad_path.str().c_str(), p.x, p.y,
-                 p.z);
+        debugmsg("quad %d,%d,%d in %s did not contain the expected submap %d,%d,%d", om_addr.x,
+                 om_addr.y, om_addr.z, pack_path.c_str(), p.x, p.y, p.z);
         return NULL;
     }
     return submaps[ p ];
 }
+
+map_pack &mapbuffer::get_pack( const std::string &path )
+{
+    auto iter = packs.find( path );
+    // Other games write to the packs as well when sharing the map
+    if( iter != packs.end() && MAP_SHARING::isSharing() ) {
+        packs.erase( iter );
+        iter = packs.end();
+    }
+    if( iter == packs.end() ) {
+        // Keeps the memory maps of the last few segments the player was in
+        if( packs.size() >= 16 ) {
+            packs.clear();
+        }
+        iter = packs.emplace( path, std::unique_ptr<map_pack>( new map_pack( path ) ) ).first;
+    }
+    return *iter->second;
+}
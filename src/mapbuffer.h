@@ -9,6 +9,8 @@
 struct point;
 struct tripoint;
 struct submap;
+class map;
+class map_pack;
 
 /**
  * Store, buffer, save and load the entire world map.
@@ -22,6 +24,7 @@ class mapbuffer
         /** Load the entire world from savefiles into submaps in this instance. **/
         void load(std::string worldname);
         /** Store all submaps in this instance into savefiles.
+         * Only quads with a dirty submap are written, the files of the others are up to date.
          * @ref delete_after_save If true, the saved submaps are removed
          * from the mapbuffer (and deleted).
          **/
@@ -57,6 +60,26 @@ class mapbuffer
         submap *lookup_submap(int x, int y, int z);
         submap *lookup_submap( const tripoint &p );
 
+        /** Buffered submaps and a rough estimate of the memory they use. */
+        struct memory_stats {
+            size_t submaps = 0;
+            size_t quads = 0;
+            size_t bytes = 0;
+            // Quads that were written back and deleted by @ref evict so far
+            size_t evicted_quads = 0;
+        };
+        memory_stats get_memory_stats() const;
+
+        /**
+         * Writes back and deletes the least recently used quads until the estimated memory of
+         * the buffer is at most 3/4 of `budget` bytes, but only once it exceeds `budget`.
+         * Quads near the grid of `m` (the reality bubble) are kept, and so are quads with
+         * vehicles that are still processed off the map, those that move or run their engines.
+         * Must be called between turns: submaps outside of `m` may be in use while vehicles
+         * move or maps are generated.
+         */
+        void evict( const map &m, size_t budget );
+
     private:
         typedef std::map<tripoint, submap *> submap_map_t;
 
@@ -69,10 +92,24 @@ class mapbuffer
         // if not handled carefully, this can erase in-use submaps and crash the game.
         void remove_submap( tripoint addr );
         submap *unserialize_submaps( const tripoint &p );
-        void save_quad( const std::string &dirname, const std::string &filename, 
-                        const tripoint &om_addr, std::list<tripoint> &submaps_to_delete, 
-                        bool delete_after_save );
+        // The quads of one segment that are written to its pack together
+        struct segment_batch;
+        void save_quad( const tripoint &om_addr, segment_batch &batch,
+                        std::list<tripoint> &submaps_to_delete, bool delete_after_save );
+        void save_segment( const std::string &pack_path, std::shared_ptr<segment_batch> batch );
+        map_pack &get_pack( const std::string &path );
         submap_map_t submaps;
+        // Counts the calls of evict, submaps are stamped with it when they are used and older
+        // quads are evicted first
+        int use_clock = 0;
+        // Whether the buffer may have grown since the last evict
+        bool grown = false;
+        // Packs whose last write failed, with the turn until which evict leaves their quads alone
+        std::map<std::string, int> failed_packs;
+        size_t last_budget = 0;
+        size_t evicted_quads = 0;
+        // Packs that were read from, until they are written
+        std::map<std::string, std::unique_ptr<map_pack>> packs;
 };
 
 extern mapbuffer MAPBUFFER;
@@ -980,6 +980,7 @@ submap::submap()
     std::uninitialized_fill_n(&rad[0][0], elements, 0);
 
     is_uniform = false;
+    dirty = true;
 }
 
 submap::~submap()
@@ -1015,11 +1016,13 @@ const std::string &submap::get_graffiti( int x, int y ) const
 void submap::set_graffiti( int x, int y, const std::string &new_graffiti )
 {
     is_uniform = false;
+    dirty = true;
     cosmetics[x][y][COSMETICS_GRAFFITI] = new_graffiti;
 }
 
 void submap::delete_graffiti( int x, int y )
 {
     is_uniform = false;
+    dirty = true;
     cosmetics[x][y].erase( COSMETICS_GRAFFITI );
 }
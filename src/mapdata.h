@@ -342,6 +342,7 @@ struct submap {
 
     inline void set_trap( const int x, const int y, trap_id trap ) {
         is_uniform = false;
+        dirty = true;
         trp[x][y] = trap;
     }
 
@@ -351,6 +352,7 @@ struct submap {
 
     inline void set_furn( const int x, const int y, furn_id furn ) {
         is_uniform = false;
+        dirty = true;
         frn[x][y] = furn;
     }
 
@@ -360,6 +362,7 @@ struct submap {
 
     inline void set_ter( const int x, const int y, ter_id terr ) {
         is_uniform = false;
+        dirty = true;
         ter[x][y] = terr;
     }
 
@@ -369,11 +372,13 @@ struct submap {
 
     void set_radiation( const int x, const int y, const int radiation ) {
         is_uniform = false;
+        dirty = true;
         rad[x][y] = radiation;
     }
 
     void update_lum_add( item const &i, int const x, int const y ) {
         is_uniform = false;
+        dirty = true;
         if (i.is_emissive() && lum[x][y] < 255) {
             lum[x][y]++;
         }
@@ -381,6 +386,7 @@ struct submap {
 
     void update_lum_rem( item const &i, int const x, int const y ) {
         is_uniform = false;
+        dirty = true;
         if (!i.is_emissive()) {
             return;
         } else if (lum[x][y] && lum[x][y] < 255) {
@@ -402,6 +408,18 @@ struct submap {
         }
     }
 
+    inline bool has_field_tile( const int x, const int y ) const {
+        return ( field_tiles[x] >> y ) & 1;
+    }
+
+    inline void set_field_tile( const int x, const int y ) {
+        field_tiles[x] |= 1 << y;
+    }
+
+    inline void clear_field_tile( const int x, const int y ) {
+        field_tiles[x] &= ~( 1 << y );
+    }
+
     bool has_graffiti( int x, int y ) const;
     const std::string &get_graffiti( int x, int y ) const;
     void set_graffiti( int x, int y, const std::string &new_graffiti );
@@ -433,11 +451,13 @@ struct submap {
     // Can be used anytime (prevents code from needing to place sign first.)
     inline void set_signage( const int x, const int y, std::string s) {
         is_uniform = false;
+        dirty = true;
         cosmetics[x][y]["SIGNAGE"] = s;
     }
     // Can be used anytime (prevents code from needing to place sign first.)
     inline void delete_signage( const int x, const int y) {
         is_uniform = false;
+        dirty = true;
         cosmetics[x][y].erase("SIGNAGE");
     }
 
@@ -454,12 +474,25 @@ struct submap {
     // Uniform submaps aren't saved/loaded, because regenerating them is faster
     bool is_uniform;
 
+    // Set when anything that is saved changes, cleared when the submap is loaded or handed to the
+    // save worker. mapbuffer::save skips quads without a dirty submap, their file is up to date.
+    // Items are changed in place through map_stack, so getting mutable access to them counts.
+    // Updating turn_last_touched alone doesn't, it only decides how much map::actualize
+    // catches up on when the submap is loaded again.
+    bool dirty;
+
     std::map<std::string, std::string> cosmetics[SEEX][SEEY]; // Textual "visuals" for each square.
 
     active_item_cache active_items;
 
     int field_count = 0;
+    // Bit y of field_tiles[x] is set when the square (x, y) has a field. Kept up to date
+    // along with field_count, map::process_fields only visits these squares.
+    std::uint16_t field_tiles[SEEX] = {};
+    static_assert( SEEY <= 16, "field_tiles needs a bit per square of a column" );
     int turn_last_touched = 0;
+    // The use clock of the mapbuffer when the submap was last looked up, see mapbuffer::evict
+    int last_used = 0;
     int temperature = 0;
     std::vector<spawn_point> spawns;
     /**
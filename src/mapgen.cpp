@@ -11559,6 +11559,7 @@ void map::add_spawn(std::string type, int count, int x, int y, bool friendly,
     }
     spawn_point tmp(type, count, offset_x, offset_y, faction_id, mission_id, friendly, name);
     place_on_submap->spawns.push_back(tmp);
+    place_on_submap->dirty = true;
 }
 
 vehicle *map::add_vehicle(const vgroup_id & type, const point &p, const int dir,
@@ -11598,6 +11599,7 @@ vehicle *map::add_vehicle(const vproto_id & type, const int x, const int y, cons
     if(placed_vehicle != NULL) {
         submap *place_on_submap = get_submap_at_grid( placed_vehicle->smx, placed_vehicle->smy, placed_vehicle->smz );
         place_on_submap->vehicles.push_back(placed_vehicle);
+        place_on_submap->dirty = true;
 
         auto &ch = get_cache( placed_vehicle->smz );
         ch.vehicle_list.insert(placed_vehicle);
@@ -11724,6 +11726,7 @@ computer *map::add_computer( const tripoint &p, std::string name, int security )
     ter_set( p, t_console ); // TODO: Turn this off?
     submap *place_on_submap = get_submap_at( p );
     place_on_submap->comp = computer(name, security);
+    place_on_submap->dirty = true;
     return &(place_on_submap->comp);
 }
 
@@ -11814,6 +11817,7 @@ void map::rotate(int turns)
             int new_lx, new_ly;
             const auto new_sm = get_submap_at( new_x, new_y, new_lx, new_ly );
             new_sm->is_uniform = false;
+            new_sm->dirty = true;
             std::swap( rotated[old_x][old_y], new_sm->ter[new_lx][new_ly] );
             std::swap( furnrot[old_x][old_y], new_sm->frn[new_lx][new_ly] );
             std::swap( traprot[old_x][old_y], new_sm->trp[new_lx][new_ly] );
@@ -11943,10 +11947,16 @@ void map::rotate(int turns)
             int lx, ly;
             const auto sm = get_submap_at( i, j, lx, ly );
             sm->is_uniform = false;
+            sm->dirty = true;
             std::swap( rotated[i][j], sm->ter[lx][ly] );
             std::swap( furnrot[i][j], sm->frn[lx][ly] );
             std::swap( traprot[i][j], sm->trp[lx][ly] );
             std::swap( fldrot[i][j], sm->fld[lx][ly] );
+            if( sm->fld[lx][ly].fieldCount() > 0 ) {
+                sm->set_field_tile( lx, ly );
+            } else {
+                sm->clear_field_tile( lx, ly );
+            }
             std::swap( radrot[i][j], sm->rad[lx][ly] );
             std::swap( cosmetics_rot[i][j], sm->cosmetics[lx][ly] );
             for( auto &itm : itrot[i][j] ) {
@@ -1,5 +1,7 @@
 #include "mapsharing.h"
 
+#include <mutex>
+
 bool MAP_SHARING::sharing;
 bool MAP_SHARING::competitive;
 bool MAP_SHARING::worldmenu;
@@ -108,6 +110,9 @@ void releaseLock( int, char const *)
 
 int getLock( char const *lockName )
 {
+    // The umask is shared by all threads, the save worker takes locks as well
+    static std::mutex umask_mutex;
+    std::lock_guard<std::mutex> guard( umask_mutex );
     mode_t m = umask( 0 );
     int fd = open( lockName, O_RDWR | O_CREAT, 0666 );
     umask( m );
@@ -221,7 +221,7 @@ void mdeath::fungus(monster *z)
             if (g->m.move_cost(sporep) > 0) {
                 if (mondex != -1) {
                     // Spores hit a monster
-                    fungal = g->zombie(mondex).type->in_species("FUNGUS");
+                    fungal = g->zombie(mondex).type->in_species(species_fungus);
                     if (g->u.sees(sporep) && !fungal) {
                         add_msg(_("The %s is covered in tiny spores!"),
                                 g->zombie(mondex).name().c_str());
@@ -371,7 +371,7 @@ void mdeath::guilt(monster *z)
     int maxMalus = -250 * (1.0 - ((float) kill_count / maxKills));
     int duration = 300 * (1.0 - ((float) kill_count / maxKills));
     int decayDelay = 30 * (1.0 - ((float) kill_count / maxKills));
-    if (z->type->in_species("ZOMBIE")) {
+    if (z->type->in_species(species_zombie)) {
         moraleMalus /= 10;
         if (g->u.has_trait("PACIFIST")) {
             moraleMalus *= 5;
@@ -433,7 +433,7 @@ void mdeath::blobsplit(monster *z)
 void mdeath::brainblob(monster *z) {
     for( size_t i = 0; i < g->num_zombies(); i++ ) {
         monster *candidate = &g->zombie( i );
-        if(candidate->type->in_species("BLOB") && candidate->type->id != "mon_blob_brain" ) {
+        if(candidate->type->in_species(species_blob) && candidate->type->id != "mon_blob_brain" ) {
             candidate->remove_effect("controlled");
         }
     }
@@ -778,7 +778,7 @@ void make_mon_corpse(monster *z, int damageLvl)
     item corpse;
     corpse.make_corpse(z->type, calendar::turn);
     corpse.damage = damageLvl > MAX_DAM ? MAX_DAM : damageLvl;
-    if( z->has_effect("pacified") && z->type->in_species("ZOMBIE") ) {
+    if( z->has_effect("pacified") && z->type->in_species(species_zombie) ) {
         // Pacified corpses have a chance of becoming un-pacified when regenerating.
         corpse.set_var( "zlave", one_in(2) ? "zlave" : "mutilated" );
     }
@@ -15,6 +15,8 @@
 #include "monfaction.h"
 #include "translations.h"
 #include "npc.h"
+#include "creature_tracker.h"
+#include "options.h"
 
 #include <stdlib.h>
 //Used for e^(x) functions
@@ -89,6 +91,39 @@ void monster::set_dest( const tripoint &p, int &t )
     plans = line_to( pos3(), p, t, 0 );
 }
 
+// The field only knows about walking around obstacles, bashers go through them
+static bool walks_flow_field( const monster &critter )
+{
+    return critter.posz() == g->u.posz() && !critter.has_flag( MF_FLIES ) &&
+           !critter.has_flag( MF_DIGS ) && !critter.has_flag( MF_AQUATIC ) &&
+           !critter.has_flag( MF_BASHES ) && !critter.has_flag( MF_BORES );
+}
+
+bool monster::can_follow_flow_field() const
+{
+    return prepared_plan.ready && prepared_plan.target == &g->u && !prepared_plan.fleeing &&
+           walks_flow_field( *this );
+}
+
+bool monster::set_dest_flow_field()
+{
+    if( !g->player_flow_field_active() || !walks_flow_field( *this ) ) {
+        return false;
+    }
+
+    const tripoint next = g->player_flow_field().next_step( pos3() );
+    if( next == tripoint_min ) {
+        return false;
+    }
+
+    // The next step is looked up again next turn, the rest only has to end at the player
+    plans.clear();
+    plans.push_back( next );
+    const std::vector<tripoint> rest = line_to( next, g->u.pos3(), 0, 0 );
+    plans.insert( plans.end(), rest.begin(), rest.end() );
+    return true;
+}
+
 // Move towards (x,y) for f more turns--generally if we hear a sound there
 // "Stupid" movement; "if (wander_pos.x < posx) posx--;" etc.
 void monster::wander_to( const tripoint &p, int f )
@@ -131,8 +166,10 @@ float monster::rate_target( Creature &c, int &bresen1, int &bresen2, float best,
     return INT_MAX;
 }
 
-void monster::plan( const mfactions &factions )
+monster_plan monster::choose_target() const
 {
+    monster_plan result;
+    result.from = pos3();
     // Bots are more intelligent than most living stuff
     bool electronic = has_flag( MF_ELECTRONIC );
     Creature *target = nullptr;
@@ -143,12 +180,17 @@ void monster::plan( const mfactions &factions )
     int selected_slope = 0;
     bool fleeing = false;
     bool docile = has_flag( MF_VERMIN ) || ( friendly != 0 && has_effect( "docile" ) );
-    bool angers_hostile_weak = type->anger.find( MTRIG_HOSTILE_WEAK ) != type->anger.end();
-    int angers_hostile_near = ( type->anger.find( MTRIG_HOSTILE_CLOSE ) != type->anger.end() ) ? 5 : 0;
-    int fears_hostile_near = ( type->fear.find( MTRIG_HOSTILE_CLOSE ) != type->fear.end() ) ? 5 : 0;
+    int angers_hostile_near = type->has_anger_trigger( MTRIG_HOSTILE_CLOSE ) ? 5 : 0;
+    int fears_hostile_near = type->has_fear_trigger( MTRIG_HOSTILE_CLOSE ) ? 5 : 0;
     bool group_morale = has_flag( MF_GROUP_MORALE ) && morale < type->morale;
     bool swarms = has_flag( MF_SWARMS );
     auto mood = attitude();
+    // Being crowded makes the monster wander for a bit
+    int wander_turns = wandf;
+    // Creature::sees never reaches farther than the daylight range, creatures farther away
+    // can't be seen (and get rated INT_MAX)
+    const int sight_radius = std::max( 1, sight_range( DAYLIGHT_LEVEL ) );
+    const Creature_tracker &tracker = *g->critter_tracker;
 
     // If we can see the player, move toward them or flee.
     if( friendly == 0 && sees( g->u, bresenham_slope ) ) {
@@ -157,12 +199,12 @@ void monster::plan( const mfactions &factions )
         target = &g->u;
         selected_slope = bresenham_slope;
         if( dist <= 5 ) {
-            anger += angers_hostile_near;
-            morale -= fears_hostile_near;
+            result.anger_change += angers_hostile_near;
+            result.morale_change -= fears_hostile_near;
         }
     } else if( friendly != 0 && !docile ) {
         // Target unfriendly monsters, only if we aren't interacting with the player.
-        for( int i = 0, numz = g->num_zombies(); i < numz; i++ ) {
+        for( const int i : tracker.monsters_within_radius( pos3(), sight_radius ) ) {
             monster &tmp = g->zombie( i );
             if( tmp.friendly == 0 ) {
                 float rating = rate_target( tmp, bresenham_slope, bresen2, dist, electronic );
@@ -190,21 +232,21 @@ void monster::plan( const mfactions &factions )
             }
             fleeing = fleeing || fleeing_from;
             if( rating <= 5 ) {
-                anger += angers_hostile_near;
-                morale -= fears_hostile_near;
+                result.anger_change += angers_hostile_near;
+                result.morale_change -= fears_hostile_near;
             }
         }
     }
 
     fleeing = fleeing || ( mood == MATT_FLEE );
     if( friendly == 0 && !docile ) {
-        for( const auto &fac : factions ) {
-            auto faction_att = faction.obj().attitude( fac.first );
+        for( const mfaction_id &fac : tracker.factions() ) {
+            auto faction_att = faction.obj().attitude( fac );
             if( faction_att == MFA_NEUTRAL || faction_att == MFA_FRIENDLY ) {
                 continue;
             }
 
-            for( int i : fac.second ) { // mon indices
+            for( int i : tracker.faction_members_within_radius( fac, pos3(), sight_radius ) ) { // mon indices
                 monster &mon = g->zombie( i );
                 float rating = rate_target( mon, bresenham_slope, bresen2, dist, electronic );
                 if( rating < dist ) {
@@ -213,39 +255,31 @@ void monster::plan( const mfactions &factions )
                     selected_slope = bresenham_slope;
                 }
                 if( rating <= 5 ) {
-                    anger += angers_hostile_near;
-                    morale -= fears_hostile_near;
+                    result.anger_change += angers_hostile_near;
+                    result.morale_change -= fears_hostile_near;
                 }
             }
         }
     }
 
     // Friendly monsters here
-    // Avoid for hordes of same-faction stuff or it could get expensive
-    const auto actual_faction = friendly == 0 ? faction : mfaction_str_id( "player" );
-    auto const &myfaction_iter = factions.find( actual_faction );
-    if( myfaction_iter == factions.end() ) {
-        DebugLog( D_ERROR, D_GAME ) << disp_name() << " tried to find faction "
-                                    << actual_faction.id().str() << " which wasn't loaded in game::monmove";
-        swarms = false;
-        group_morale = false;
-    }
     swarms = swarms && target == nullptr; // Only swarm if we have no target
     if( group_morale || swarms ) {
-        for( const int i : myfaction_iter->second ) {
+        const mfaction_id actual_faction = Creature_tracker::planning_faction( *this );
+        for( const int i : tracker.faction_members_within_radius( actual_faction, pos3(), sight_radius ) ) {
             monster &mon = g->zombie( i );
             float rating = rate_target( mon, bresenham_slope, bresen2, dist, electronic );
             if( group_morale && rating <= 10 ) {
-                morale += 10 - rating;
+                result.morale_change += 10 - rating;
             }
             if( swarms ) {
                 if( rating < 5 ) { // Too crowded here
-                    wander_pos.x = posx() * rng( 1, 3 ) - mon.posx();
-                    wander_pos.y = posy() * rng( 1, 3 ) - mon.posy();
-                    wandf = 2;
+                    result.crowded = true;
+                    result.crowded_by = mon.pos3();
+                    wander_turns = 2;
                     target = nullptr;
                     // Swarm to the furthest ally you can see
-                } else if( rating < INT_MAX && rating > dist && wandf <= 0 ) {
+                } else if( rating < INT_MAX && rating > dist && wander_turns <= 0 ) {
                     target = &mon;
                     dist = rating;
                     selected_slope = bresenham_slope;
@@ -254,6 +288,78 @@ void monster::plan( const mfactions &factions )
         }
     }
 
+    result.target = target;
+    if( target != nullptr ) {
+        result.target_pos = target->pos3();
+    }
+    result.selected_slope = selected_slope;
+    result.fleeing = fleeing;
+    return result;
+}
+
+void monster::prepare_plan()
+{
+    prepared_plan = choose_target();
+    prepared_plan.attitude = attitude();
+    prepared_plan.anger = anger;
+    prepared_plan.morale = morale;
+    prepared_plan.friendly = friendly;
+    prepared_plan.player_pos = g->u.pos3();
+    prepared_plan.creature_changes = g->critter_tracker->change_count();
+    prepared_plan.ready = true;
+}
+
+bool monster::plan_still_valid( const monster_plan &p ) const
+{
+    if( p.from != pos3() || p.anger != anger || p.morale != morale || p.friendly != friendly ||
+        p.attitude != attitude() ) {
+        return false;
+    } else if( p.target == nullptr ) {
+        // Creatures that came into view might have been chosen
+        return p.player_pos == g->u.pos3() &&
+               !g->critter_tracker->changed_within( pos3(), std::max( 1, sight_range( DAYLIGHT_LEVEL ) ),
+                       p.creature_changes );
+    }
+    // The target may be gone, so look it up by its old position instead of using the pointer
+    if( p.target == &g->u ) {
+        return g->u.pos3() == p.target_pos;
+    }
+    const int mondex = g->mon_at( p.target_pos );
+    if( mondex != -1 ) {
+        return &g->zombie( mondex ) == p.target;
+    }
+    const int npcdex = g->npc_at( p.target_pos );
+    return npcdex != -1 && g->active_npc[npcdex] == p.target;
+}
+
+void monster::plan()
+{
+    // The prepared plan saw the world before the other monsters moved, that's fine as long
+    // as nothing it depends on changed
+    if( prepared_plan.ready && plan_still_valid( prepared_plan ) ) {
+        follow_plan( prepared_plan );
+    } else {
+        follow_plan( choose_target() );
+    }
+    prepared_plan.ready = false;
+}
+
+void monster::follow_plan( const monster_plan &p )
+{
+    Creature *target = p.target;
+    int selected_slope = p.selected_slope;
+    const bool fleeing = p.fleeing;
+    int bresenham_slope = 0;
+    bool angers_hostile_weak = type->has_anger_trigger( MTRIG_HOSTILE_WEAK );
+
+    anger += p.anger_change;
+    morale += p.morale_change;
+    if( p.crowded ) {
+        wander_pos.x = posx() * rng( 1, 3 ) - p.crowded_by.x;
+        wander_pos.y = posy() * rng( 1, 3 ) - p.crowded_by.y;
+        wandf = 2;
+    }
+
     if( target != nullptr ) {
         if( one_in( 2 ) ) { // Random for the diversity of the trajectory
             ++selected_slope;
@@ -264,7 +370,9 @@ void monster::plan( const mfactions &factions )
         tripoint dest = target->pos3();
         auto att_to_target = attitude_to( *target );
         if( att_to_target == Attitude::A_HOSTILE && !fleeing ) {
-            set_dest( dest, selected_slope );
+            if( target != &g->u || !set_dest_flow_field() ) {
+                set_dest( dest, selected_slope );
+            }
         } else if( fleeing ) {
             set_dest( tripoint( posx() * 2 - dest.x, posy() * 2 - dest.y, posz() ), selected_slope );
         }
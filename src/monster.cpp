@@ -246,7 +246,7 @@ std::string monster::name(unsigned int quantity) const
 std::string monster::name_with_armor() const
 {
  std::string ret;
- if (type->in_species("INSECT")) {
+ if (type->in_species(species_insect)) {
      ret = string_format(_("carapace"));
  }
  else {
@@ -612,7 +612,7 @@ monster_attitude monster::attitude(player *u) const
         }
         // Zombies don't understand not attacking NPCs, but dogs and bots should.
         npc *np = dynamic_cast< npc* >( u );
-        if( np != nullptr && np->attitude != NPCATT_KILL && !type->in_species( "ZOMBIE" ) ) {
+        if( np != nullptr && np->attitude != NPCATT_KILL && !type->in_species( species_zombie ) ) {
             return MATT_FRIEND;
         }
     }
@@ -627,8 +627,8 @@ monster_attitude monster::attitude(player *u) const
     int effective_morale = morale;
 
     if (u != NULL) {
-        if (((type->in_species("MAMMAL") && u->has_trait("PHEROMONE_MAMMAL")) ||
-             (type->in_species("INSECT") && u->has_trait("PHEROMONE_INSECT"))) &&
+        if (((type->in_species(species_mammal) && u->has_trait("PHEROMONE_MAMMAL")) ||
+             (type->in_species(species_insect) && u->has_trait("PHEROMONE_INSECT"))) &&
             effective_anger >= 10) {
             effective_anger -= 20;
         }
@@ -684,13 +684,13 @@ int monster::hp_percentage() const
 
 void monster::process_triggers()
 {
- anger += trigger_sum(&(type->anger));
- anger -= trigger_sum(&(type->placate));
+ anger += trigger_sum(type->bitanger);
+ anger -= trigger_sum(type->bitplacate);
  if (morale < 0) {
   if (morale < type->morale && one_in(20))
   morale++;
  } else
-  morale -= trigger_sum(&(type->fear));
+  morale -= trigger_sum(type->bitfear);
 }
 
 // This Adjustes anger/morale levels given a single trigger.
@@ -708,32 +708,16 @@ void monster::process_trigger(monster_trigger trig, int amount)
 }
 
 
-int monster::trigger_sum(std::set<monster_trigger> *triggers) const
+int monster::trigger_sum( const std::bitset<N_MONSTER_TRIGGERS> &triggers ) const
 {
     int ret = 0;
-    bool check_terrain = false, check_meat = false, check_fire = false;
-    for( const auto &trigger : *triggers ) {
-        switch( trigger ) {
-            case MTRIG_STALK:
-                if (anger > 0 && one_in(20)) {
-                    ret++;
-                }
-                break;
-
-            case MTRIG_MEAT:
-                check_terrain = true;
-                check_meat = true;
-                break;
-
-            case MTRIG_FIRE:
-                check_terrain = true;
-                check_fire = true;
-                break;
-
-            default:
-                break; // The rest are handled when the impetus occurs
-        }
+    // The rest are handled when the impetus occurs
+    if( triggers[MTRIG_STALK] && anger > 0 && one_in( 20 ) ) {
+        ret++;
     }
+    bool check_meat = triggers[MTRIG_MEAT];
+    const bool check_fire = triggers[MTRIG_FIRE];
+    const bool check_terrain = check_meat || check_fire;
 
     if (check_terrain) {
         for (int x = posx() - 3; x <= posx() + 3; x++) {
@@ -1686,7 +1670,7 @@ bool monster::make_fungus()
     }
     char polypick = 0;
     std::string tid = type->id;
-    if (type->in_species("FUNGUS")) { // No friendly-fungalizing ;-)
+    if (type->in_species(species_fungus)) { // No friendly-fungalizing ;-)
         return true;
     }
     if (tid == "mon_ant" || tid == "mon_ant_soldier" || tid == "mon_ant_queen" || tid == "mon_fly" ||
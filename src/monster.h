@@ -13,8 +13,6 @@ class monfaction;
 
 using mfaction_id = int_id<monfaction>;
 
-typedef std::map< mfaction_id, std::set< int > > mfactions;
-
 enum monster_attitude {
     MATT_NULL = 0,
     MATT_FRIEND,
@@ -27,6 +25,33 @@ enum monster_attitude {
     NUM_MONSTER_ATTITUDES
 };
 
+/**
+ * Target chosen by @ref monster::choose_target and acted upon by @ref monster::plan.
+ * Changes to the monster itself are kept here, so choosing doesn't change anything.
+ */
+struct monster_plan {
+    // Set by monster::prepare_plan
+    bool ready = false;
+    // Where the monster and the target were when the plan was made
+    tripoint from;
+    Creature *target = nullptr;
+    tripoint target_pos;
+    int selected_slope = 0;
+    bool fleeing = false;
+    int anger_change = 0;
+    int morale_change = 0;
+    // A swarming monster got too close to an ally and wanders away from it
+    bool crowded = false;
+    tripoint crowded_by;
+    // The rest of what the plan depends on, see monster::plan_still_valid
+    monster_attitude attitude = MATT_NULL;
+    int anger = 0;
+    int morale = 0;
+    int friendly = 0;
+    tripoint player_pos;
+    int creature_changes = 0;
+};
+
 class monster : public Creature, public JsonSerializer, public JsonDeserializer
 {
         friend class editmap;
@@ -136,6 +161,14 @@ class monster : public Creature, public JsonSerializer, public JsonDeserializer
 
         void set_dest( const tripoint &p, int &t ); // Go in a straight line to (x, y)
         // t determines WHICH Bresenham line
+        /**
+         * Sets plans to the next step toward the player from @ref game::player_flow_field,
+         * followed by a line to the player. Returns false (and leaves plans alone) if the
+         * flow field isn't active this turn or can't be used by this monster, bashers included.
+         */
+        bool set_dest_flow_field();
+        /** Whether the prepared plan chases the player and could follow the flow field. */
+        bool can_follow_flow_field() const;
 
         /**
          * Set (x, y) as wander destination.
@@ -151,9 +184,23 @@ class monster : public Creature, public JsonSerializer, public JsonDeserializer
 
         // How good of a target is given creature (checks for visibility)
         float rate_target( Creature &c, int &bresen1, int &bresen2, float best, bool smart = false ) const;
-        // Pass all factions to mon, so that hordes of same-faction mons
-        // do not iterate over each other
-        void plan(const mfactions &factions);
+        /**
+         * Rates the creatures this monster sees and picks a target among them. Only reads the
+         * monster and the world (no random numbers either), so it can run for many monsters at
+         * once, see @ref prepare_plan.
+         * Only looks at the monsters within sight range, see Creature_tracker::faction_members_within_radius.
+         */
+        monster_plan choose_target() const;
+        /**
+         * Chooses the target for the next @ref plan in advance. game::monmove does this for
+         * all monsters on the thread pool before any of them moves.
+         */
+        void prepare_plan();
+        /**
+         * Sets the destination toward (or away from) a target. Uses the prepared plan if neither
+         * the monster nor its target moved since it was made, chooses a new target otherwise.
+         */
+        void plan();
         void move(); // Actual movement
         void footsteps( const tripoint &p ); // noise made by movement
         void friendly_move();
@@ -209,7 +256,7 @@ class monster : public Creature, public JsonSerializer, public JsonDeserializer
         Attitude attitude_to( const Creature &other ) const override;
         void process_triggers(); // Process things that anger/scare us
         void process_trigger(monster_trigger trig, int amount); // Single trigger
-        int trigger_sum(std::set<monster_trigger> *triggers) const;
+        int trigger_sum( const std::bitset<N_MONSTER_TRIGGERS> &triggers ) const;
 
         bool is_underwater() const override;
         bool is_on_ground() const override;
@@ -374,9 +421,18 @@ class monster : public Creature, public JsonSerializer, public JsonDeserializer
         std::vector <tripoint> plans;
         tripoint position;
         int last_loaded; //time the monster was last loaded
+        monster_plan prepared_plan;
         bool dead;
         /** Attack another monster */
         void hit_monster(monster &other);
+        /**
+         * Whether the monster and the target of the plan are still where they were, and the mood
+         * of the monster didn't change. Plans without a target also need the creatures around
+         * to be where they were.
+         */
+        bool plan_still_valid( const monster_plan &p ) const;
+        /** Applies the plan, this is where the random parts of planning happen. */
+        void follow_plan( const monster_plan &p );
         /** Legacy loading logic for monsters that are packing ammo. **/
         void normalize_ammo( const int old_ammo );
 
@@ -13,6 +13,20 @@
 #include "monfaction.h"
 #include "mongroup.h"
 
+// convenient int-lookup names for hard-coded species checks
+int
+species_bird = -1,
+species_blob = -1,
+species_fish = -1,
+species_fungus = -1,
+species_hallucination = -1,
+species_insect = -1,
+species_mammal = -1,
+species_mollusk = -1,
+species_plant = -1,
+species_robot = -1,
+species_zombie = -1;
+
 MonsterGenerator::MonsterGenerator()
 {
     mon_templates["mon_null"] = new mtype();
@@ -48,6 +62,17 @@ void MonsterGenerator::reset()
 
 void MonsterGenerator::finalize_mtypes()
 {
+    species_bird = species_short_id( "BIRD" );
+    species_blob = species_short_id( "BLOB" );
+    species_fish = species_short_id( "FISH" );
+    species_fungus = species_short_id( "FUNGUS" );
+    species_hallucination = species_short_id( "HALLUCINATION" );
+    species_insect = species_short_id( "INSECT" );
+    species_mammal = species_short_id( "MAMMAL" );
+    species_mollusk = species_short_id( "MOLLUSK" );
+    species_plant = species_short_id( "PLANT" );
+    species_robot = species_short_id( "ROBOT" );
+    species_zombie = species_short_id( "ZOMBIE" );
     for( auto &elem : mon_templates ) {
         mtype *mon = elem.second;
         apply_species_attributes(mon);
@@ -357,11 +382,15 @@ void MonsterGenerator::init_flags()
 void MonsterGenerator::set_species_ids( mtype *mon )
 {
     const std::set< std::string > &specs = mon->species;
-    std::set< int > ret;
+    mon->bitspecies.assign( mon_species.size(), false );
     for( const auto &s : specs ) {
         auto iter = mon_species.find( s );
         if( iter != mon_species.end() ) {
-            mon->species_id.insert( iter->second->short_id );
+            const size_t short_id = iter->second->short_id;
+            if( short_id >= mon->bitspecies.size() ) {
+                mon->bitspecies.resize( short_id + 1, false );
+            }
+            mon->bitspecies[short_id] = true;
         } else {
             debugmsg( "Tried to assign species %s to monster %s, but no entry for the species exists", s.c_str(), mon->id.c_str() );
         }
@@ -502,6 +531,12 @@ void MonsterGenerator::load_species(JsonObject &jo)
     }
 }
 
+int MonsterGenerator::species_short_id( const std::string &species ) const
+{
+    const auto iter = mon_species.find( species );
+    return iter != mon_species.end() ? iter->second->short_id : -1;
+}
+
 mtype *MonsterGenerator::get_mtype(std::string mon)
 {
     mtype *default_montype = mon_templates["mon_null"];
@@ -66,6 +66,8 @@ class MonsterGenerator
         mtype *get_mtype(int mon);
         bool has_mtype(const std::string &mon) const;
         bool has_species(const std::string &species) const;
+        /** The short_id of the species, or -1 if there is no such species. */
+        int species_short_id( const std::string &species ) const;
         std::map<std::string, mtype *> get_all_mtypes() const;
         std::vector<std::string> get_all_mtype_ids() const;
         mtype *get_valid_hallucination();
@@ -3,6 +3,8 @@
 #include "monstergenerator.h"
 #include "mondeath.h"
 
+#include <algorithm>
+
 mtype::mtype ()
 {
     id = "mon_null";
@@ -45,11 +47,6 @@ std::string mtype::nname(unsigned int quantity) const
     return ngettext(name.c_str(), name_plural.c_str(), quantity);
 }
 
-bool mtype::has_flag(m_flag flag) const
-{
-    return bitflags[flag];
-}
-
 bool mtype::has_flag(std::string flag) const
 {
     return has_flag( MonsterGenerator::generator().m_flag_from_string( flag ) );
@@ -57,26 +54,13 @@ bool mtype::has_flag(std::string flag) const
 
 void mtype::set_flag(std::string flag, bool state)
 {
+    const m_flag nflag = MonsterGenerator::generator().m_flag_from_string( flag );
     if( state ) {
-        flags.insert( MonsterGenerator::generator().m_flag_from_string( flag ) );
+        flags.insert( nflag );
     } else {
-        flags.erase( MonsterGenerator::generator().m_flag_from_string( flag ) );
+        flags.erase( nflag );
     }
-}
-
-bool mtype::has_anger_trigger(monster_trigger trig) const
-{
-    return bitanger[trig];
-}
-
-bool mtype::has_fear_trigger(monster_trigger trig) const
-{
-    return bitfear[trig];
-}
-
-bool mtype::has_placate_trigger(monster_trigger trig) const
-{
-    return bitplacate[trig];
+    bitflags[nflag] = state;
 }
 
 bool mtype::in_category(std::string category) const
@@ -86,18 +70,14 @@ bool mtype::in_category(std::string category) const
 
 bool mtype::in_species(std::string spec) const
 {
-    return (species.find(spec) != species.end());
-}
-
-bool mtype::in_species( int spec_id ) const
-{
-    return ( species_id.find(spec_id) != species_id.end() );
+    return in_species( MonsterGenerator::generator().species_short_id( spec ) );
 }
 
 bool mtype::same_species( const mtype &other ) const
 {
-    for( int s : species_id ) {
-        if( other.in_species( s ) ) {
+    const size_t common = std::min( bitspecies.size(), other.bitspecies.size() );
+    for( size_t i = 0; i < common; i++ ) {
+        if( bitspecies[i] && other.bitspecies[i] ) {
             return true;
         }
     }
@@ -131,7 +111,7 @@ field_id mtype::bloodType() const
 
 field_id mtype::gibType() const
 {
-    if (has_flag(MF_LARVA) || in_species("MOLLUSK")) {
+    if (has_flag(MF_LARVA) || in_species(species_mollusk)) {
         return fd_gibs_invertebrate;
     }
     if (mat == "veggy") {
@@ -168,7 +168,8 @@ struct mtype {
         std::string id;
         std::string description;
         std::set<std::string> species, categories;
-        std::set< int > species_id;
+        /** Indexed by species_type::short_id, set by MonsterGenerator::finalize_mtypes like the bitsets below */
+        std::vector<bool> bitspecies;
         mfaction_id default_faction;
         /** UTF-8 encoded symbol, should be exactyle one cell wide. */
         std::string sym;
@@ -240,15 +241,33 @@ struct mtype {
 
         // Used to fetch the properly pluralized monster type name
         std::string nname(unsigned int quantity = 1) const;
-        bool has_flag(m_flag flag) const;
+        // Called for every monster in the hottest loops, so these are inline
+        bool has_flag( m_flag flag ) const
+        {
+            return bitflags[flag];
+        }
+        bool has_anger_trigger( monster_trigger trigger ) const
+        {
+            return bitanger[trigger];
+        }
+        bool has_fear_trigger( monster_trigger trigger ) const
+        {
+            return bitfear[trigger];
+        }
+        bool has_placate_trigger( monster_trigger trigger ) const
+        {
+            return bitplacate[trigger];
+        }
+        bool in_species( int spec_id ) const
+        {
+            return spec_id >= 0 && static_cast<size_t>( spec_id ) < bitspecies.size() && bitspecies[spec_id];
+        }
+        // The string versions look up the id and call the ones above, the species one is for Lua,
+        // the code uses the species_* ids below
         bool has_flag(std::string flag) const;
         void set_flag(std::string flag, bool state);
-        bool has_anger_trigger(monster_trigger trigger) const;
-        bool has_fear_trigger(monster_trigger trigger) const;
-        bool has_placate_trigger(monster_trigger trigger) const;
         bool in_category(std::string category) const;
         bool in_species(std::string _species) const;
-        bool in_species( int spec_id ) const;
         //Used for corpses.
         field_id bloodType () const;
         field_id gibType () const;
@@ -257,4 +276,19 @@ struct mtype {
         itype_id get_meat_itype() const;
 };
 
+// Short ids of the species that are checked in the code, see mtype::in_species( int ).
+// Set by MonsterGenerator::finalize_mtypes, -1 if the species isn't loaded.
+extern int
+species_bird,
+species_blob,
+species_fish,
+species_fungus,
+species_hallucination,
+species_insect,
+species_mammal,
+species_mollusk,
+species_plant,
+species_robot,
+species_zombie;
+
 #endif
@@ -1455,7 +1455,8 @@ void npc::find_item()
     for( const tripoint &p : g->m.points_in_radius( pos(), range ) ) {
         // TODO: Make this sight check not overdraw nearby tiles
         if( g->m.sees_some_items( p, *this ) && sees( p ) ) {
-            for( auto &elem : g->m.i_at( p ) ) {
+            const map_stack items = g->m.i_at( p );
+            for( const item &elem : items ) {
                 if( elem.made_of( LIQUID ) ) {
                     // Don't even consider liquids.
                     continue;
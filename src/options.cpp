@@ -553,6 +553,11 @@ void initOptions()
                                        0, 127, 5
                                       );
 
+    OPTIONS["MAP_MEMORY_BUDGET"] = cOpt("general", _("Map memory budget"),
+                                        _("Megabytes of memory for the parts of the map that were visited. Beyond that, the parts visited longest ago are saved and unloaded until they are visited again. 0 = No limit."),
+                                        0, 4096, 256
+                                       );
+
     mOptionsSort["general"]++;
 
     OPTIONS["CIRCLEDIST"] = cOpt("general", _("Circular distances"),
@@ -869,6 +874,14 @@ void initOptions()
                                  "vanilla,capped,int,intcap,off", "int"
                                 );
 
+    mOptionsSort["debug"]++;
+
+    optionNames["groups"] = _("Groups");
+    OPTIONS["MONSTER_FLOW_FIELD"] = cOpt("debug", _("Monster flow field"),
+                                         _("When hostile monsters chasing you follow a distance map shared by all of them instead of a straight line, which lets them walk around obstacles. Groups: When many monsters chase you at once."),
+                                         "always,groups,never", "groups"
+                                        );
+
     ////////////////////////////WORLD DEFAULT////////////////////
     optionNames["no"] = _("No");
     optionNames["yes"] = _("Yes");
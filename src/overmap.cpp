@@ -27,6 +27,7 @@
 #include "mongroup.h"
 #include "name.h"
 #include "translations.h"
+#include "save_worker.h"
 #define dbg(x) DebugLog((DebugLevel)(x),D_MAP_GEN) << __FILE__ << ":" << __LINE__ << ": "
 
 #define STREETCHANCE 2
@@ -3811,6 +3812,8 @@ void overmap::open()
     std::string const terfilename = overmapbuffer::terrain_filename(loc.x, loc.y);
     std::ifstream fin;
 
+    save_worker::instance().wait_for( plrfilename );
+    save_worker::instance().wait_for( terfilename );
     fin.open(terfilename.c_str());
     if (fin.is_open()) {
         unserialize(fin, plrfilename, terfilename);
@@ -328,6 +328,9 @@ public:
   void init_layers();
   // open existing overmap, or generate a new one
   void open();
+  // Write the files of @ref save, on the save worker
+  void save_player_data( std::ostream &fout ) const;
+  void save_terrain( std::ostream &fout, const std::vector<std::string> &npc_data ) const;
   // parse data in an opened overmap file
   void unserialize(std::ifstream & fin, std::string const & plrfilename, std::string const & terfilename);
   // parse data in an old overmap file
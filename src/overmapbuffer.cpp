@@ -109,7 +109,7 @@ void overmapbuffer::fix_mongroups(overmap &new_overmap)
 void overmapbuffer::save()
 {
     for( auto &omp : overmaps ) {
-        // Note: this may throw io errors from std::ofstream
+        // Note: the files are written in the background, see save_worker
         omp.second->save();
     }
 }
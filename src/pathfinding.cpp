@@ -2,12 +2,19 @@
 #include "debug.h"
 #include "enums.h"
 #include "game.h"
+#include "line.h"
 #include "map.h"
 #include "map_iterator.h"
+#include "turn_profiler.h"
 #include "vehicle.h"
 
 #include <algorithm>
+#include <array>
+#include <climits>
+#include <functional>
+#include <memory>
 #include <queue>
+#include <vector>
 
 #include "messages.h"
 
@@ -17,6 +24,9 @@ enum astar_state {
  ASL_CLOSED
 };
 
+// Routes at least this long (in tiles) are first planned on the portal graph
+constexpr int PORTAL_ROUTE_MIN_DIST = SEEX * 2;
+
 // Turns two indexed to a 2D array into an index to equivalent 1D array
 constexpr int flat_index( const int x, const int y ) {
     return (x * MAPSIZE * SEEY) + y;
@@ -38,38 +48,67 @@ struct path_data_layer
     std::array< int, SEEX * MAPSIZE * SEEY * MAPSIZE > score;
     std::array< int, SEEX * MAPSIZE * SEEY * MAPSIZE > gscore;
     std::array< tripoint, SEEX * MAPSIZE * SEEY * MAPSIZE > parent;
+    // Search in which each entry was last written. Entries stamped with an older
+    // search count as ASL_NONE, so the layer never has to be cleared between routes.
+    std::array< unsigned int, SEEX * MAPSIZE * SEEY * MAPSIZE > stamp;
 
-    void init( const int minx, const int miny, const int maxx, const int maxy ) {
-        for( int x = minx; x <= maxx; x++ ) {
-            for( int y = miny; y <= maxy; y++ ) {
-                const int ind = flat_index( x, y );
-                state[ind] = ASL_NONE; // Mark as unvisited
-            }
-        }
-    };
+    unsigned int generation = 0;
+
+    path_data_layer() {
+        stamp.fill( 0 );
+    }
+
+    astar_state get_state( const int index ) const {
+        return stamp[index] == generation ? state[index] : ASL_NONE;
+    }
+
+    void set_state( const int index, const astar_state new_state ) {
+        stamp[index] = generation;
+        state[index] = new_state;
+    }
 };
 
+// Persistent per-thread pathfinding arena. Layers are allocated on first use and
+// kept for the lifetime of the thread, so a route only pays for the nodes it visits.
 struct pathfinder
 {
-    int minx;
-    int miny;
-    int maxx;
-    int maxy;
-    pathfinder( int _minx, int _miny, int _maxx, int _maxy ) :
-        minx( _minx ), miny( _miny ), maxx( _maxx ), maxy( _maxy )
-    {}
+    int minx = 0;
+    int miny = 0;
+    int maxx = 0;
+    int maxy = 0;
 
-    std::priority_queue< std::pair<int, tripoint>, std::vector< std::pair<int, tripoint> >, pair_greater_cmp > open;
+    unsigned int generation = 0;
+
+    // Binary heap managed with std::push_heap/pop_heap, so its storage survives between searches
+    std::vector< std::pair<int, tripoint> > open;
     std::array< std::unique_ptr< path_data_layer >, OVERMAP_LAYERS > path_data;
 
+    void reset( const int _minx, const int _miny, const int _maxx, const int _maxy ) {
+        minx = _minx;
+        miny = _miny;
+        maxx = _maxx;
+        maxy = _maxy;
+        open.clear();
+
+        generation++;
+        if( generation == 0 ) {
+            // Stamps wrapped around, old entries could be mistaken for current ones
+            for( auto &ptr : path_data ) {
+                if( ptr != nullptr ) {
+                    ptr->stamp.fill( 0 );
+                }
+            }
+            generation = 1;
+        }
+    }
+
     path_data_layer &get_layer( const int z ) {
         auto &ptr = path_data[z + OVERMAP_DEPTH];
-        if( ptr != nullptr ) {
-            return *ptr;
+        if( ptr == nullptr ) {
+            ptr = std::unique_ptr<path_data_layer>( new path_data_layer() );
         }
 
-        ptr = std::unique_ptr<path_data_layer>( new path_data_layer() );
-        ptr->init( minx, miny, maxx, maxy );
+        ptr->generation = generation;
         return *ptr;
     }
 
@@ -78,33 +117,41 @@ struct pathfinder
     }
 
     tripoint get_next() {
-        auto pt = open.top();
-        open.pop();
-        return pt.second;
+        std::pop_heap( open.begin(), open.end(), pair_greater_cmp() );
+        const tripoint pt = open.back().second;
+        open.pop_back();
+        return pt;
     }
 
     void add_point( const int gscore, const int score, const tripoint &from, const tripoint &to ) {
         auto &layer = get_layer( to.z );
         const int index = flat_index( to.x, to.y );
-        if( ( layer.state[index] == ASL_OPEN && gscore >= layer.gscore[index] ) ||
-            layer.state[index] == ASL_CLOSED ) {
+        const astar_state st = layer.get_state( index );
+        if( ( st == ASL_OPEN && gscore >= layer.gscore[index] ) || st == ASL_CLOSED ) {
             return;
         }
 
-        layer.state [index] = ASL_OPEN;
+        layer.set_state( index, ASL_OPEN );
         layer.gscore[index] = gscore;
         layer.parent[index] = from;
         layer.score [index] = score;
-        open.push( std::make_pair( score, to ) );
+        open.push_back( std::make_pair( score, to ) );
+        std::push_heap( open.begin(), open.end(), pair_greater_cmp() );
     }
 
     void close_point( const tripoint &p ) {
         auto &layer = get_layer( p.z );
         const int index = flat_index( p.x, p.y );
-        layer.state[index] = ASL_CLOSED;
+        layer.set_state( index, ASL_CLOSED );
     }
 };
 
+static pathfinder &get_pathfinder()
+{
+    static thread_local pathfinder pf;
+    return pf;
+}
+
 // Returns a tile with `flag` in the overmap tile that `t` is on
 template<ter_bitflags flag>
 tripoint vertical_move_destination( const map &m, const tripoint &t )
@@ -176,7 +223,35 @@ std::vector<tripoint> map::route( const tripoint &f, const tripoint &t,
     clip_to_bounds( minx, miny, minz );
     clip_to_bounds( maxx, maxy, maxz );
 
-    pathfinder pf( minx, miny, maxx, maxy );
+    const tripoint min( minx, miny, minz );
+    const tripoint max( maxx, maxy, maxz );
+    // The graph has the costs of creatures that can't bash, bashers would rather
+    // go through a wall than around it
+    if( bash == 0 && f.z == t.z && square_dist( f, t ) >= PORTAL_ROUTE_MIN_DIST ) {
+        build_portal_graph( f.z );
+        std::vector<tripoint> ret = route_portals( f, t, bash, maxdist, min, max );
+        if( !ret.empty() ) {
+            return ret;
+        }
+    }
+
+    return route_tiles( f, t, bash, maxdist, min, max );
+}
+
+std::vector<tripoint> map::route_tiles( const tripoint &f, const tripoint &t,
+                                        const int bash, const int maxdist,
+                                        const tripoint &min, const tripoint &max ) const
+{
+    const int minx = min.x;
+    const int miny = min.y;
+    const int minz = min.z;
+    const int maxx = max.x;
+    const int maxy = max.y;
+    const int maxz = max.z;
+
+    const tripoint &pl_pos = g->u.pos();
+    pathfinder &pf = get_pathfinder();
+    pf.reset( minx, miny, maxx, maxy );
     pf.add_point( 0, 0, f, f );
     // Make NPCs not want to path through player
     // But don't make player pathing stop working
@@ -185,19 +260,20 @@ std::vector<tripoint> map::route( const tripoint &f, const tripoint &t,
     }
 
     bool done = false;
+    int expanded = 0;
 
     do {
         auto cur = pf.get_next();
 
         const int parent_index = flat_index( cur.x, cur.y );
         auto &layer = pf.get_layer( cur.z );
-        auto &cur_state = layer.state[parent_index];
-        if( cur_state == ASL_CLOSED ) {
+        if( layer.get_state( parent_index ) == ASL_CLOSED ) {
             continue;
         }
 
         if( layer.gscore[parent_index] > maxdist ) {
             // Shortest path would be too long, return empty vector
+            turn_profiler::count( turn_profiler::COUNTER_ROUTE_EXPANSIONS, expanded );
             return std::vector<tripoint>();
         }
 
@@ -206,70 +282,37 @@ std::vector<tripoint> map::route( const tripoint &f, const tripoint &t,
             break;
         }
 
-        cur_state = ASL_CLOSED;
+        layer.set_state( parent_index, ASL_CLOSED );
+        expanded++;
         std::vector<tripoint> neighbors = closest_tripoints_first( 1, cur );
 
         for( const auto &p : neighbors ) {
             const int index = flat_index( p.x, p.y );
 
             // TODO: Remove this and instead have sentinels at the edges
-            if( p.x < minx || p.x >= maxx || p.y < miny || p.y >= maxy ) {
+            // The bounds are inclusive, like those of clip_to_bounds
+            if( p.x < minx || p.x > maxx || p.y < miny || p.y > maxy ) {
                 continue;
             }
 
-            if( layer.state[index] == ASL_CLOSED ) {
+            const astar_state p_state = layer.get_state( index );
+            if( p_state == ASL_CLOSED ) {
                 continue;
             }
 
-            int part = -1;
-            const maptile &tile = maptile_at_internal( p );
-            const auto &terrain = terlist[tile.get_ter()];
-            const auto &furniture = furnlist[tile.get_furn()];
-            const vehicle *veh = veh_at_internal( p, part );
-
-            const int cost = move_cost_internal( furniture, terrain, veh, part );
-            // Don't calculate bash rating unless we intend to actually use it
-            const int rating = ( bash == 0 || cost != 0 ) ? -1 :
-                                 bash_rating_internal( bash, furniture, terrain, false, veh, part );
-
-            if( cost == 0 && rating <= 0 && terrain.open.empty() ) {
-                layer.state[index] = ASL_CLOSED; // Close it so that next time we won't try to calc costs
+            const int step = route_step_cost( cur, p, bash );
+            if( step < 0 ) {
+                layer.set_state( index, ASL_CLOSED ); // Close it so that next time we won't try to calc costs
                 continue;
+            } else if( step == 0 ) {
+                continue; // Unbashable and unopenable from here
             }
 
-            int newg = layer.gscore[parent_index] + cost + ( (cur.x != p.x && cur.y != p.y ) ? 1 : 0);
-            if( cost == 0 ) {
-                // Handle all kinds of doors
-                // Only try to open INSIDE doors from the inside
-
-                if( !terrain.open.empty() &&
-                    ( !terrain.has_flag( "OPENCLOSE_INSIDE" ) || !is_outside( cur ) ) ) {
-                    newg += 4; // To open and then move onto the tile
-                } else if( veh != nullptr ) {
-                    part = veh->obstacle_at_part( part );
-                    int dummy = -1;
-                    if( !veh->part_flag( part, "OPENCLOSE_INSIDE" ) || veh_at_internal( cur, dummy ) == veh ) {
-                        // Handle car doors, but don't try to path through curtains
-                        newg += 10; // One turn to open, 4 to move there
-                    } else {
-                        // Car obstacle that isn't a door
-                        newg += veh->parts[part].hp / bash + 8 + 4;
-                    }
-                } else if( rating > 1 ) {
-                    // Expected number of turns to bash it down, 1 turn to move there
-                    // and 2 turns of penalty not to trash everything just because we can
-                    newg += ( 20 / rating ) + 2 + 4;
-                } else if( rating == 1 ) {
-                    // Desperate measures, avoid whenever possible
-                    newg += 500;
-                } else {
-                    continue; // Unbashable and unopenable from here
-                }
-            }
+            const int newg = layer.gscore[parent_index] + step;
 
             // If not visited, add as open
             // If visited, add it only if we can do so with better score
-            if( layer.state[index] == ASL_NONE || newg < layer.gscore[index] ) {
+            if( p_state == ASL_NONE || newg < layer.gscore[index] ) {
                 pf.add_point( newg, newg + 2 * rl_dist( p, t ), cur, p );
             }
         }
@@ -285,7 +328,6 @@ std::vector<tripoint> map::route( const tripoint &f, const tripoint &t,
             tripoint dest( cur.x, cur.y, cur.z - 1 );
             dest = vertical_move_destination<TFLAG_GOES_UP>( *this, dest );
             if( inbounds( dest ) ) {
-                auto &layer = pf.get_layer( dest.z );
                 pf.add_point( layer.gscore[parent_index] + 2,
                               layer.score[parent_index] + 2 * rl_dist( dest, t ),
                               cur, dest );
@@ -295,13 +337,13 @@ std::vector<tripoint> map::route( const tripoint &f, const tripoint &t,
             tripoint dest( cur.x, cur.y, cur.z + 1 );
             dest = vertical_move_destination<TFLAG_GOES_DOWN>( *this, dest );
             if( inbounds( dest ) ) {
-                auto &layer = pf.get_layer( dest.z );
                 pf.add_point( layer.gscore[parent_index] + 2,
                               layer.score[parent_index] + 2 * rl_dist( dest, t ),
                               cur, dest );
             }
         }
     } while( !done && !pf.empty() );
+    turn_profiler::count( turn_profiler::COUNTER_ROUTE_EXPANSIONS, expanded );
 
     std::vector<tripoint> ret;
     ret.reserve( rl_dist( f, t ) * 2 );
@@ -333,3 +375,448 @@ std::vector<tripoint> map::route( const tripoint &f, const tripoint &t,
 
     return ret;
 }
+
+int map::route_step_cost( const tripoint &cur, const tripoint &p, const int bash ) const
+{
+    // Plain passable tiles only need the cached move cost
+    const auto &ch = get_cache( p.z );
+    if( !ch.move_cost_cache_dirty ) {
+        const int cached = ch.move_cost_cache[p.x][p.y];
+        if( cached != 0 && cached != MOVE_COST_CACHE_OVERFLOW ) {
+            return cached + ( ( cur.x != p.x && cur.y != p.y ) ? 1 : 0 );
+        }
+    }
+
+    int part = -1;
+    const maptile &tile = maptile_at_internal( p );
+    const auto &terrain = terlist[tile.get_ter()];
+    const auto &furniture = furnlist[tile.get_furn()];
+    const vehicle *veh = veh_at_internal( p, part );
+
+    const int cost = move_cost_internal( furniture, terrain, veh, part );
+    // Don't calculate bash rating unless we intend to actually use it
+    const int rating = ( bash == 0 || cost != 0 ) ? -1 :
+                         bash_rating_internal( bash, furniture, terrain, false, veh, part );
+
+    if( cost == 0 && rating <= 0 && terrain.open.empty() ) {
+        return -1;
+    }
+
+    int step = cost + ( ( cur.x != p.x && cur.y != p.y ) ? 1 : 0 );
+    if( cost != 0 ) {
+        return step;
+    }
+
+    // Handle all kinds of doors
+    // Only try to open INSIDE doors from the inside
+    if( !terrain.open.empty() &&
+        ( !terrain.has_flag( "OPENCLOSE_INSIDE" ) || !is_outside( cur ) ) ) {
+        step += 4; // To open and then move onto the tile
+    } else if( veh != nullptr ) {
+        part = veh->obstacle_at_part( part );
+        int dummy = -1;
+        if( !veh->part_flag( part, "OPENCLOSE_INSIDE" ) || veh_at_internal( cur, dummy ) == veh ) {
+            // Handle car doors, but don't try to path through curtains
+            step += 10; // One turn to open, 4 to move there
+        } else if( bash > 0 ) {
+            // Car obstacle that isn't a door
+            step += veh->parts[part].hp / bash + 8 + 4;
+        } else {
+            return 0;
+        }
+    } else if( rating > 1 ) {
+        // Expected number of turns to bash it down, 1 turn to move there
+        // and 2 turns of penalty not to trash everything just because we can
+        step += ( 20 / rating ) + 2 + 4;
+    } else if( rating == 1 ) {
+        // Desperate measures, avoid whenever possible
+        step += 500;
+    } else {
+        return 0; // Unbashable and unopenable from here
+    }
+
+    return step;
+}
+
+// Index of the submap containing p in portal_graph::submap_nodes
+static int portal_submap_index( const tripoint &p )
+{
+    return ( p.x / SEEX ) * MAPSIZE + ( p.y / SEEY );
+}
+
+// Dijkstra search limited to the submap containing `from`, using the orthogonal entry
+// costs of the portal graph. `dist` receives the cost of every tile of the submap,
+// indexed by local x * SEEY + local y, INT_MAX if unreachable.
+// With `reverse` set the costs are those of going from the tile to `from` instead.
+static void submap_dijkstra( const portal_graph &graph, const tripoint &from,
+                             const tripoint &blocked, const bool reverse,
+                             std::array<int, SEEX * SEEY> &dist )
+{
+    const int origin_x = ( from.x / SEEX ) * SEEX;
+    const int origin_y = ( from.y / SEEY ) * SEEY;
+
+    dist.fill( INT_MAX );
+    std::priority_queue< std::pair<int, tripoint>, std::vector< std::pair<int, tripoint> >, pair_greater_cmp > open;
+    dist[( from.x - origin_x ) * SEEY + from.y - origin_y] = 0;
+    open.push( std::make_pair( 0, from ) );
+    while( !open.empty() ) {
+        const auto cur = open.top();
+        open.pop();
+        const tripoint &cp = cur.second;
+        if( cur.first > dist[( cp.x - origin_x ) * SEEY + cp.y - origin_y] ) {
+            continue;
+        }
+
+        const int cur_enter = graph.enter_cost[flat_index( cp.x, cp.y )];
+        if( reverse && cur_enter <= 0 ) {
+            continue;
+        }
+        for( int dx = -1; dx <= 1; dx++ ) {
+            for( int dy = -1; dy <= 1; dy++ ) {
+                const int lx = cp.x + dx - origin_x;
+                const int ly = cp.y + dy - origin_y;
+                if( ( dx == 0 && dy == 0 ) || lx < 0 || lx >= SEEX || ly < 0 || ly >= SEEY ) {
+                    continue;
+                }
+
+                const tripoint p( cp.x + dx, cp.y + dy, cp.z );
+                const int enter = graph.enter_cost[flat_index( p.x, p.y )];
+                if( enter <= 0 || p == blocked ) {
+                    continue;
+                }
+
+                const int newd = cur.first + ( reverse ? cur_enter : enter ) +
+                                 ( ( dx != 0 && dy != 0 ) ? 1 : 0 );
+                int &old = dist[lx * SEEY + ly];
+                if( newd < old ) {
+                    old = newd;
+                    open.push( std::make_pair( newd, p ) );
+                }
+            }
+        }
+    }
+}
+
+uint8_t map::move_cost_cache_value( const tripoint &p ) const
+{
+    int part = -1;
+    const maptile &tile = maptile_at_internal( p );
+    const vehicle *veh = veh_at_internal( p, part );
+    const int cost = move_cost_internal( furnlist[tile.get_furn()], terlist[tile.get_ter()], veh, part );
+    return std::min( cost, MOVE_COST_CACHE_OVERFLOW );
+}
+
+void map::set_pathfinding_cache_dirty( const tripoint &p )
+{
+    if( !inbounds( p ) ) {
+        return;
+    }
+
+    auto &ch = get_cache( p.z );
+    ch.portals.dirty = true;
+    if( !ch.move_cost_cache_dirty ) {
+        ch.move_cost_cache[p.x][p.y] = move_cost_cache_value( p );
+    }
+}
+
+void map::build_move_cost_cache( const int zlev )
+{
+    auto &ch = get_cache( zlev );
+    if( !ch.move_cost_cache_dirty ) {
+        return;
+    }
+
+    for( int x = 0; x < my_MAPSIZE * SEEX; x++ ) {
+        for( int y = 0; y < my_MAPSIZE * SEEY; y++ ) {
+            ch.move_cost_cache[x][y] = move_cost_cache_value( tripoint( x, y, zlev ) );
+        }
+    }
+    ch.move_cost_cache_dirty = false;
+}
+
+void map::build_portal_graph( const int zlev ) const
+{
+    auto &graph = get_cache( zlev ).portals;
+    if( !graph.dirty ) {
+        return;
+    }
+
+    graph.clear();
+    graph.enter_cost.assign( SEEX * MAPSIZE * SEEY * MAPSIZE, -1 );
+    for( int x = 0; x < my_MAPSIZE * SEEX; x++ ) {
+        for( int y = 0; y < my_MAPSIZE * SEEY; y++ ) {
+            const tripoint p( x, y, zlev );
+            graph.enter_cost[flat_index( x, y )] = route_step_cost( p, p, 0 );
+        }
+    }
+
+    const auto passable = [&graph]( const tripoint &p ) {
+        return graph.enter_cost[flat_index( p.x, p.y )] > 0;
+    };
+    const auto add_node = [&graph]( const tripoint &p ) {
+        const int index = graph.nodes.size();
+        graph.nodes.push_back( portal_graph::node{ p, {} } );
+        graph.submap_nodes[portal_submap_index( p )].push_back( index );
+        return index;
+    };
+    // Puts a portal in the middle of every passable gap in a border. `near` walks
+    // `length` tiles along the inner side of the border, `dir` is the direction of the walk
+    // and `across` points over the border.
+    const auto add_border = [&]( const tripoint &near, const tripoint &dir,
+                                 const tripoint &across, const int length ) {
+        int gap_start = -1;
+        for( int i = 0; i <= length; i++ ) {
+            const tripoint a = near + tripoint( dir.x * i, dir.y * i, 0 );
+            const tripoint b = a + across;
+            if( i < length && passable( a ) && passable( b ) ) {
+                if( gap_start < 0 ) {
+                    gap_start = i;
+                }
+                continue;
+            }
+
+            if( gap_start >= 0 ) {
+                const int mid = ( gap_start + i - 1 ) / 2;
+                const tripoint pa = near + tripoint( dir.x * mid, dir.y * mid, 0 );
+                const tripoint pb = pa + across;
+                const int ia = add_node( pa );
+                const int ib = add_node( pb );
+                graph.nodes[ia].edges.push_back( { ib, graph.enter_cost[flat_index( pb.x, pb.y )] } );
+                graph.nodes[ib].edges.push_back( { ia, graph.enter_cost[flat_index( pa.x, pa.y )] } );
+                gap_start = -1;
+            }
+        }
+    };
+
+    for( int gridx = 0; gridx < my_MAPSIZE; gridx++ ) {
+        for( int gridy = 0; gridy < my_MAPSIZE; gridy++ ) {
+            const tripoint corner( gridx * SEEX, gridy * SEEY, zlev );
+            if( gridx + 1 < my_MAPSIZE ) {
+                add_border( corner + tripoint( SEEX - 1, 0, 0 ), tripoint( 0, 1, 0 ),
+                            tripoint( 1, 0, 0 ), SEEY );
+            }
+            if( gridy + 1 < my_MAPSIZE ) {
+                add_border( corner + tripoint( 0, SEEY - 1, 0 ), tripoint( 1, 0, 0 ),
+                            tripoint( 0, 1, 0 ), SEEX );
+            }
+        }
+    }
+
+    // Connect the portals of each submap with each other
+    std::array<int, SEEX * SEEY> dist;
+    for( auto &sm_nodes : graph.submap_nodes ) {
+        for( const int from : sm_nodes ) {
+            const tripoint &from_pos = graph.nodes[from].pos;
+            submap_dijkstra( graph, from_pos, tripoint_min, false, dist );
+            for( const int to : sm_nodes ) {
+                const tripoint &to_pos = graph.nodes[to].pos;
+                const int d = dist[( to_pos.x % SEEX ) * SEEY + to_pos.y % SEEY];
+                if( to != from && d != INT_MAX ) {
+                    graph.nodes[from].edges.push_back( { to, d } );
+                }
+            }
+        }
+    }
+
+    graph.dirty = false;
+}
+
+std::vector<tripoint> map::route_portals( const tripoint &f, const tripoint &t,
+                                          const int bash, const int maxdist,
+                                          const tripoint &min, const tripoint &max ) const
+{
+    const auto &graph = get_cache( f.z ).portals;
+    const int from_sm = portal_submap_index( f );
+    const int to_sm = portal_submap_index( t );
+    if( graph.dirty || graph.enter_cost.empty() || from_sm == to_sm ) {
+        return std::vector<tripoint>();
+    }
+
+    // Same as in route_tiles, don't path through the player unless that's where we're going
+    const tripoint &pl_pos = g->u.pos();
+    const tripoint blocked = ( f != pl_pos && t != pl_pos ) ? pl_pos : tripoint_min;
+    const auto usable = [&]( const tripoint &p ) {
+        return p != blocked &&
+               p.x >= min.x && p.x <= max.x && p.y >= min.y && p.y <= max.y;
+    };
+
+    std::array<int, SEEX * SEEY> from_dist;
+    std::array<int, SEEX * SEEY> to_dist;
+    submap_dijkstra( graph, f, blocked, false, from_dist );
+    submap_dijkstra( graph, t, blocked, true, to_dist );
+
+    // A* on the portals, with two extra nodes for the endpoints
+    const int start = graph.nodes.size();
+    const int goal = start + 1;
+    const auto node_pos = [&]( const int n ) -> const tripoint & {
+        return n == start ? f : ( n == goal ? t : graph.nodes[n].pos );
+    };
+
+    std::vector<int> gscore( goal + 1, INT_MAX );
+    std::vector<int> parent( goal + 1, -1 );
+    std::vector<bool> closed( goal + 1, false );
+    std::priority_queue< std::pair<int, int>, std::vector< std::pair<int, int> >, std::greater< std::pair<int, int> > > open;
+    const auto relax = [&]( const int from, const int to, const int cost ) {
+        const int newg = gscore[from] + cost;
+        if( !closed[to] && newg < gscore[to] ) {
+            gscore[to] = newg;
+            parent[to] = from;
+            open.push( std::make_pair( newg + 2 * rl_dist( node_pos( to ), t ), to ) );
+        }
+    };
+
+    gscore[start] = 0;
+    open.push( std::make_pair( 0, start ) );
+    int expanded = 0;
+    while( !open.empty() ) {
+        const int cur = open.top().second;
+        open.pop();
+        if( closed[cur] ) {
+            continue;
+        }
+        closed[cur] = true;
+        expanded++;
+        if( cur == goal || gscore[cur] > maxdist ) {
+            break;
+        }
+
+        if( cur == start ) {
+            for( const int n : graph.submap_nodes[from_sm] ) {
+                const tripoint &p = graph.nodes[n].pos;
+                const int d = from_dist[( p.x % SEEX ) * SEEY + p.y % SEEY];
+                if( d != INT_MAX && usable( p ) ) {
+                    relax( start, n, d );
+                }
+            }
+            continue;
+        }
+
+        const tripoint &cur_pos = graph.nodes[cur].pos;
+        for( const auto &e : graph.nodes[cur].edges ) {
+            if( usable( graph.nodes[e.to].pos ) ) {
+                relax( cur, e.to, e.cost );
+            }
+        }
+
+        if( portal_submap_index( cur_pos ) == to_sm ) {
+            const int d = to_dist[( cur_pos.x % SEEX ) * SEEY + cur_pos.y % SEEY];
+            if( d != INT_MAX ) {
+                relax( cur, goal, d );
+            }
+        }
+    }
+
+    turn_profiler::count( turn_profiler::COUNTER_ROUTE_EXPANSIONS, expanded );
+    if( !closed[goal] || gscore[goal] > maxdist ) {
+        return std::vector<tripoint>();
+    }
+
+    std::vector<tripoint> waypoints;
+    for( int n = goal; n != start; n = parent[n] ) {
+        waypoints.push_back( node_pos( n ) );
+    }
+    std::reverse( waypoints.begin(), waypoints.end() );
+
+    // Refine the abstract route: border crossings are single steps, everything
+    // else is a path inside one submap
+    std::vector<tripoint> ret;
+    tripoint prev = f;
+    for( const tripoint &w : waypoints ) {
+        if( w == prev ) {
+            continue;
+        }
+
+        if( portal_submap_index( w ) != portal_submap_index( prev ) ) {
+            if( route_step_cost( prev, w, bash ) <= 0 ) {
+                return std::vector<tripoint>();
+            }
+            ret.push_back( w );
+        } else {
+            const tripoint sm_min( ( w.x / SEEX ) * SEEX, ( w.y / SEEY ) * SEEY, w.z );
+            const tripoint sm_max( sm_min.x + SEEX - 1, sm_min.y + SEEY - 1, w.z );
+            const std::vector<tripoint> segment = route_tiles( prev, w, bash, maxdist, sm_min, sm_max );
+            if( segment.empty() ) {
+                return std::vector<tripoint>();
+            }
+            ret.insert( ret.end(), segment.begin(), segment.end() );
+        }
+        prev = w;
+    }
+
+    turn_profiler::count( turn_profiler::COUNTER_PORTAL_ROUTES );
+    return ret;
+}
+
+// Tiles further than this from the target (in route cost) are left out of flow fields
+constexpr int FLOW_FIELD_MAX_COST = 250;
+
+void flow_field::update( const map &m, const tripoint &new_target, const int new_turn )
+{
+    if( new_target == target && new_turn == turn ) {
+        return;
+    }
+
+    target = new_target;
+    turn = new_turn;
+    dist.assign( SEEX * MAPSIZE * SEEY * MAPSIZE, INT_MAX );
+    step.assign( SEEX * MAPSIZE * SEEY * MAPSIZE, -1 );
+    if( !m.inbounds( target ) ) {
+        return;
+    }
+
+    // Dijkstra outward from the target, so every step is costed in the direction it will be walked
+    std::priority_queue< std::pair<int, tripoint>, std::vector< std::pair<int, tripoint> >, pair_greater_cmp > open;
+    dist[flat_index( target.x, target.y )] = 0;
+    open.push( std::make_pair( 0, target ) );
+    while( !open.empty() ) {
+        const auto cur = open.top();
+        open.pop();
+        const tripoint &cp = cur.second;
+        if( cur.first > dist[flat_index( cp.x, cp.y )] ) {
+            continue;
+        }
+
+        for( int dx = -1; dx <= 1; dx++ ) {
+            for( int dy = -1; dy <= 1; dy++ ) {
+                const tripoint p( cp.x + dx, cp.y + dy, cp.z );
+                if( ( dx == 0 && dy == 0 ) || !m.inbounds( p ) ) {
+                    continue;
+                }
+
+                const int cost = m.route_step_cost( p, cp, 0 );
+                if( cost <= 0 || cur.first + cost > FLOW_FIELD_MAX_COST ) {
+                    continue;
+                }
+
+                int &old = dist[flat_index( p.x, p.y )];
+                // Tiles nothing can stand on don't need a distance
+                if( cur.first + cost < old && m.route_step_cost( p, p, 0 ) >= 0 ) {
+                    old = cur.first + cost;
+                    // Back toward the tile it was reached from
+                    step[flat_index( p.x, p.y )] = ( 1 - dx ) * 3 + 1 - dy;
+                    open.push( std::make_pair( old, p ) );
+                }
+            }
+        }
+    }
+}
+
+int flow_field::distance( const tripoint &p ) const
+{
+    if( dist.empty() || p.z != target.z || p.x < 0 || p.x >= SEEX * MAPSIZE ||
+        p.y < 0 || p.y >= SEEY * MAPSIZE ) {
+        return INT_MAX;
+    }
+
+    return dist[flat_index( p.x, p.y )];
+}
+
+tripoint flow_field::next_step( const tripoint &p ) const
+{
+    if( distance( p ) == INT_MAX || p == target ) {
+        return tripoint_min;
+    }
+
+    const int dir = step[flat_index( p.x, p.y )];
+    return tripoint( p.x + dir / 3 - 1, p.y + dir % 3 - 1, p.z );
+}
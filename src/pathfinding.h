@@ -0,0 +1,89 @@
+#ifndef PATHFINDING_H
+#define PATHFINDING_H
+
+#include "enums.h"
+#include "game_constants.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class map;
+
+/**
+ * Abstract graph over the submaps of one z-level, used by @ref map::route to plan
+ * long routes (hierarchical A*).
+ *
+ * Nodes are portals: the two tiles on either side of a passable gap in a border between
+ * two submaps. Edges connect the halves of each portal (the step across the border) and
+ * the portals of a single submap with each other (the cheapest path inside that submap).
+ * All costs are those of a creature that can't bash.
+ */
+struct portal_graph {
+    struct edge {
+        int to;
+        int cost;
+    };
+
+    struct node {
+        tripoint pos;
+        std::vector<edge> edges;
+    };
+
+    std::vector<node> nodes;
+    // Indices into @ref nodes of the portals inside each submap, indexed by gridx * MAPSIZE + gridy
+    std::array< std::vector<int>, MAPSIZE * MAPSIZE > submap_nodes;
+    // Cost of entering each tile of the level orthogonally (see @ref map::route_step_cost),
+    // indexed by x * MAPSIZE * SEEY + y, 0 or less if impassable
+    std::vector<int> enter_cost;
+
+    // Set by @ref map::set_pathfinding_cache_dirty, the next route that uses the graph rebuilds it
+    bool dirty = true;
+
+    void clear() {
+        nodes.clear();
+        for( auto &sm_nodes : submap_nodes ) {
+            sm_nodes.clear();
+        }
+    }
+};
+
+/**
+ * Distance map ("Dijkstra map") toward one tile of the reality bubble, shared by every
+ * creature chasing that tile. It is computed once for all of them, along with the next
+ * step of a cheapest path from every tile, so following it is a lookup per step.
+ * Costs are those of @ref map::route for a creature that can't bash.
+ */
+class flow_field
+{
+    public:
+        /**
+         * Recomputes the field toward `target` (on its z-level), unless it was already
+         * computed for the same target on the same turn.
+         */
+        void update( const map &m, const tripoint &target, int turn );
+        /** Cost of the cheapest path from `p` to the target, INT_MAX if unreachable or too far. */
+        int distance( const tripoint &p ) const;
+        /**
+         * The neighbor of `p` to step to on a cheapest path to the target, tripoint_min if
+         * `p` isn't covered by the field or is the target.
+         */
+        tripoint next_step( const tripoint &p ) const;
+
+    private:
+        tripoint target = tripoint_min;
+        int turn = -1;
+        std::vector<int> dist;
+        // Direction of the next step from each tile, ( dx + 1 ) * 3 + dy + 1, -1 if none
+        std::vector<std::int8_t> step;
+};
+
+/**
+ * Fewest monsters chasing the player for which the flow field is worth computing, with the
+ * "groups" setting of MONSTER_FLOW_FIELD. Computing the field takes about as long as that
+ * many routes, see the flow field benchmark in tests/pathfinding_test.cpp.
+ */
+constexpr size_t FLOW_FIELD_MIN_CHASERS = 32;
+
+#endif
@@ -36,6 +36,7 @@
 #include "ui.h"
 #include "trap.h"
 #include "map_iterator.h"
+#include "creature_tracker.h"
 #include <map>
 
 #ifdef SDLTILES
@@ -6167,7 +6168,7 @@ void player::hardcoded_effects(effect &it)
                             const int zid = g->mon_at( sporep );
                             if (zid >= 0) {  // Spores hit a monster
                                 if (g->u.sees(sporex, sporey) &&
-                                      !g->zombie(zid).type->in_species("FUNGUS")) {
+                                      !g->zombie(zid).type->in_species(species_fungus)) {
                                     add_msg(_("The %s is covered in tiny spores!"),
                                                g->zombie(zid).name().c_str());
                                 }
@@ -13724,20 +13725,13 @@ bool player::is_visible_in_range( const Creature &critter, const int range ) con
 std::vector<Creature *> player::get_visible_creatures( const int range ) const
 {
     std::vector<Creature *> result;
-    for( size_t i = 0; i < g->num_zombies(); i++ ) {
-        auto &critter = g->zombie( i );
-        if( !critter.is_dead() && is_visible_in_range( critter, range ) ) {
-            result.push_back( &critter );
+    for( Creature *critter : g->critter_tracker->within_radius( pos3(), range ) ) {
+        // Dead monsters are only removed at the end of the turn
+        const monster *mon = dynamic_cast<const monster *>( critter );
+        if( critter != this && ( mon == nullptr || !mon->is_dead() ) && sees( *critter ) ) {
+            result.push_back( critter );
         }
     }
-    for( auto & n : g->active_npc ) {
-        if( n != this && is_visible_in_range( *n, range ) ) {
-            result.push_back( n );
-        }
-    }
-    if( this != &g->u && is_visible_in_range( g->u, range ) ) {
-        result.push_back( &g->u );
-    }
     return result;
 }
 
@@ -13824,7 +13818,7 @@ void player::spores()
             if (g->m.move_cost(sporex, sporey) > 0) {
                 if (mondex != -1) { // Spores hit a monster
                     if (g->u.sees(sporex, sporey) &&
-                        !g->zombie(mondex).type->in_species("FUNGUS")) {
+                        !g->zombie(mondex).type->in_species(species_fungus)) {
                         add_msg(_("The %s is covered in tiny spores!"),
                                 g->zombie(mondex).name().c_str());
                     }
@@ -0,0 +1,171 @@
+#include "save_worker.h"
+#include "debug.h"
+#include "filesystem.h"
+#include "mapsharing.h"
+
+#include <fstream>
+
+#define dbg(x) DebugLog((DebugLevel)(x),D_MAIN) << __FILE__ << ":" << __LINE__ << ": "
+
+save_worker::save_worker( const bool background )
+{
+    if( background ) {
+        thread = std::thread( &save_worker::work, this );
+    }
+}
+
+save_worker::~save_worker()
+{
+    {
+        std::lock_guard<std::mutex> lock( mutex );
+        stopping = true;
+    }
+    wake.notify_one();
+    if( thread.joinable() ) {
+        thread.join();
+    }
+}
+
+save_worker &save_worker::instance()
+{
+    static save_worker worker( true );
+    return worker;
+}
+
+void save_worker::write( const std::string &path, writer write, failure_handler on_failure )
+{
+    queue( job{ path, std::move( write ), nullptr, std::move( on_failure ) } );
+}
+
+void save_worker::update( const std::string &path, updater update, failure_handler on_failure )
+{
+    queue( job{ path, nullptr, std::move( update ), std::move( on_failure ) } );
+}
+
+void save_worker::queue( job j )
+{
+    if( !thread.joinable() ) {
+        finish( j, write_file( j ) );
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock( mutex );
+        pending.insert( j.path );
+        jobs.push_back( std::move( j ) );
+    }
+    wake.notify_one();
+}
+
+void save_worker::wait_for( const std::string &path )
+{
+    std::unique_lock<std::mutex> lock( mutex );
+    done.wait( lock, [this, &path]() {
+        return pending.count( path ) == 0;
+    } );
+}
+
+bool save_worker::collect()
+{
+    std::vector<job> failures;
+    {
+        std::lock_guard<std::mutex> lock( mutex );
+        failures.swap( failed );
+    }
+    for( auto &j : failures ) {
+        dbg( D_ERROR ) << "failed to write " << j.path;
+        if( j.on_failure ) {
+            j.on_failure();
+        }
+    }
+    return failures.empty();
+}
+
+bool save_worker::wait()
+{
+    {
+        std::unique_lock<std::mutex> lock( mutex );
+        done.wait( lock, [this]() {
+            return pending.empty();
+        } );
+    }
+    return collect();
+}
+
+void save_worker::finish( job &j, const bool success )
+{
+    {
+        std::lock_guard<std::mutex> lock( mutex );
+        auto iter = pending.find( j.path );
+        if( iter != pending.end() ) {
+            pending.erase( iter );
+        }
+        if( !success ) {
+            // Frees the data it was going to write
+            j.write = nullptr;
+            j.update = nullptr;
+            failed.push_back( std::move( j ) );
+        }
+    }
+    done.notify_all();
+}
+
+bool save_worker::write_file( const job &j )
+{
+    const std::string lock_path = j.path + ".lock";
+    const int lock = getLock( lock_path.c_str() );
+    if( lock == -1 ) {
+        // Another game is writing it, the data wasn't saved
+        return false;
+    }
+
+    if( j.update ) {
+        bool success = false;
+        try {
+            success = j.update( j.path );
+        } catch( const std::ios::failure & ) {
+        } catch( const std::string & ) {
+        } catch( const std::exception & ) {
+        }
+        releaseLock( lock, lock_path.c_str() );
+        return success;
+    }
+
+    const std::string temp_path = j.path + ".temp";
+    bool success = false;
+    try {
+        std::ofstream fout;
+        fout.exceptions( std::ios::badbit | std::ios::failbit );
+        fout.open( temp_path.c_str(), std::ios_base::out | std::ios_base::trunc | std::ios_base::binary );
+        j.write( fout );
+        fout.close();
+        success = rename_file( temp_path, j.path );
+    } catch( const std::ios::failure & ) {
+    } catch( const std::string & ) {
+    } catch( const std::exception & ) {
+    }
+    if( !success ) {
+        remove_file( temp_path );
+    }
+    releaseLock( lock, lock_path.c_str() );
+    return success;
+}
+
+void save_worker::work()
+{
+    while( true ) {
+        job j;
+        {
+            std::unique_lock<std::mutex> lock( mutex );
+            wake.wait( lock, [this]() {
+                return stopping || !jobs.empty();
+            } );
+            // Queued files are written before stopping
+            if( jobs.empty() ) {
+                return;
+            }
+            j = std::move( jobs.front() );
+            jobs.pop_front();
+        }
+        finish( j, write_file( j ) );
+    }
+}
@@ -0,0 +1,90 @@
+#ifndef SAVE_WORKER_H
+#define SAVE_WORKER_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <iosfwd>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Writes save files on a background thread, so the game does not wait for the disk.
+ *
+ * Whoever queues a file hands over a copy of the data to save, the worker serializes it into
+ * a temporary file next to the target and renames that over the target once it is complete,
+ * so the target always holds either the old or the new data. Files that are changed in place
+ * instead take care of that themselves, see @ref update. While writing, the worker holds
+ * the same lock file as @ref fopen_exclusive, files locked by someone else fail to write.
+ * Writes of the same file happen in the order they were queued.
+ */
+class save_worker
+{
+    public:
+        typedef std::function<void( std::ostream & )> writer;
+        typedef std::function<bool( const std::string & )> updater;
+        typedef std::function<void()> failure_handler;
+
+        /** Starts the thread if `background`, otherwise files are written as they are queued. */
+        save_worker( bool background );
+        /** Writes the remaining files before returning. */
+        ~save_worker();
+
+        save_worker( const save_worker & ) = delete;
+        save_worker &operator=( const save_worker & ) = delete;
+
+        /**
+         * Queues writing the file at `path`. `write` is called on the worker thread, so it must
+         * only use data that it owns. If the file can not be written, `on_failure` is called by
+         * the next @ref collect on the thread that calls it.
+         */
+        void write( const std::string &path, writer write, failure_handler on_failure = nullptr );
+        /**
+         * Like @ref write, but `update` changes the file at the path it is given itself and
+         * returns false if it could not.
+         */
+        void update( const std::string &path, updater update, failure_handler on_failure = nullptr );
+        /** Blocks until the queued writes of `path` are done, call it before reading the file. */
+        void wait_for( const std::string &path );
+        /**
+         * Handles the files that could not be written since the last call, without waiting for
+         * the queued ones.
+         * @return false if there were any.
+         */
+        bool collect();
+        /** Blocks until all queued files are written, then does @ref collect. */
+        bool wait();
+
+        /** The worker of the game. */
+        static save_worker &instance();
+
+    private:
+        struct job {
+            std::string path;
+            writer write;
+            updater update;
+            failure_handler on_failure;
+        };
+
+        void queue( job j );
+        void work();
+        // Returns false if the file could not be written
+        static bool write_file( const job &j );
+        void finish( job &j, bool success );
+
+        std::thread thread;
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::condition_variable done;
+        std::deque<job> jobs;
+        // Paths of the queued jobs and of the one that is being written
+        std::multiset<std::string> pending;
+        // The jobs whose file could not be written, without their writer
+        std::vector<job> failed;
+        bool stopping = false;
+};
+
+#endif
@@ -30,6 +30,7 @@
 #include "debug.h"
 #include "weather.h"
 #include "mapsharing.h"
+#include "save_worker.h"
 #include "monster.h"
 #include "overmap.h"
 
@@ -570,17 +571,31 @@ void overmap::unserialize(std::ifstream & fin, std::string const & plrfilename,
     }
 }
 
-// Note: this may throw io errors from std::ofstream
+// The files are written in the background by the save_worker
 void overmap::save() const
 {
-    std::ofstream fout;
-    fout.exceptions(std::ios::badbit | std::ios::failbit);
     std::string const plrfilename = overmapbuffer::player_filename(loc.x, loc.y);
     std::string const terfilename = overmapbuffer::terrain_filename(loc.x, loc.y);
 
-    // Player specific data
-    fout.open(plrfilename.c_str());
+    // The worker writes a copy, the npcs are saved right away as they are not part of it.
+    std::shared_ptr<overmap> snapshot = std::make_shared<overmap>( *this );
+    snapshot->npcs.clear();
+    std::shared_ptr<std::vector<std::string>> npc_data = std::make_shared<std::vector<std::string>>();
+    for( auto &i : npcs ) {
+        npc_data->push_back( i->save_info() );
+    }
+
+    save_worker::instance().write( plrfilename, [snapshot]( std::ostream &fout ) {
+        snapshot->save_player_data( fout );
+    } );
+    save_worker::instance().write( terfilename, [snapshot, npc_data]( std::ostream &fout ) {
+        snapshot->save_terrain( fout, *npc_data );
+    } );
+}
 
+void overmap::save_player_data( std::ostream &fout ) const
+{
+    // Player specific data
     fout << "# version " << savegame_version << std::endl;
 
     for (int z = 0; z < OVERMAP_LAYERS; ++z) {
@@ -632,13 +647,11 @@ void overmap::save() const
             fout << "N " << i.x << " " << i.y << " " << std::endl << i.text << std::endl;
         }
     }
-    fout.close();
+}
 
+void overmap::save_terrain( std::ostream &fout, const std::vector<std::string> &npc_data ) const
+{
     // World terrain data
-    fopen_exclusive(fout, terfilename.c_str(), std::ios_base::trunc);
-    if(!fout.is_open()) {
-        return;
-    }
     fout << "# version " << savegame_version << std::endl;
     for (int z = 0; z < OVERMAP_LAYERS; ++z) {
         fout << "L " << z << std::endl;
@@ -702,10 +715,9 @@ void overmap::save() const
     }
 
     //saving the npcs
-    for (auto &i : npcs)
-        fout << "n " << i->save_info() << std::endl;
-
-    fclose_exclusive(fout, terfilename.c_str());
+    for( auto &i : npc_data ) {
+        fout << "n " << i << std::endl;
+    }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////
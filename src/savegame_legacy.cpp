@@ -6,6 +6,7 @@
 #include "options.h"
 #include "auto_pickup.h"
 #include "mapbuffer.h"
+#include "map_pack.h"
 #include "debug.h"
 #include "map.h"
 #include "output.h"
@@ -35,6 +36,7 @@
 #include "savegame.h"
 #include "morale.h"
 #include "worldfactory.h"
+#include "save_worker.h"
 #include "crafting.h"
 #include "veh_type.h"
 #include "mutation.h"
@@ -1152,6 +1154,7 @@ static bool unserialize_legacy(std::ifstream & fin ) {
             if(!sm->fld[itx][ity].findField(field_id(t)))
              sm->field_count++;
             sm->fld[itx][ity].addField(field_id(t), d, a);
+            sm->set_field_tile(itx, ity);
            } else if (string_identifier == "S") {
             char tmpfriend;
             int tmpfac = -1, tmpmis = -1;
@@ -1415,6 +1418,7 @@ static void unserialize_legacy_submaps( std::ifstream &fin, const int num_submap
                     sm->field_count++;
                 }
                 sm->fld[itx][ity].addField(field_id(t), d, a);
+                sm->set_field_tile(itx, ity);
             } else if (string_identifier == "S") {
                 char tmpfriend;
                 int tmpfac = -1, tmpmis = -1;
@@ -1492,6 +1496,16 @@ void mapbuffer::load( std::string worldname )
             save( true );
         }
     }
+
+    // Move the files of single quads into the packs of their segments. The packs written
+    // above have the converted quads already, so their legacy files are just removed.
+    save_worker::instance().wait();
+    const int moved_quads = map_pack::migrate( world_map_path.str() );
+    if( moved_quads < 0 ) {
+        debugmsg( "Failed to move the map files of %s into map packs", worldname.c_str() );
+    } else if( moved_quads > 0 ) {
+        DebugLog( D_INFO, D_MAP ) << "moved " << moved_quads << " map files into map packs";
+    }
 }
 
 
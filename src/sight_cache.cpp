@@ -0,0 +1,81 @@
+#include "sight_cache.h"
+
+#include "creature.h"
+#include "turn_profiler.h"
+
+#include <atomic>
+#include <functional>
+#include <unordered_map>
+
+namespace {
+
+struct sight_key {
+    const Creature *observer;
+    const Creature *target;
+    tripoint observer_pos;
+    tripoint target_pos;
+
+    bool operator==( const sight_key &other ) const
+    {
+        return observer == other.observer && target == other.target &&
+               observer_pos == other.observer_pos && target_pos == other.target_pos;
+    }
+};
+
+struct sight_key_hash {
+    size_t operator()( const sight_key &k ) const
+    {
+        std::hash<const Creature *> ptr_hash;
+        size_t h = ptr_hash( k.observer ) * 31 + ptr_hash( k.target );
+        h = h * 31 + ( k.observer_pos.x * 977 + k.observer_pos.y ) * 31 + k.observer_pos.z;
+        return h * 31 + ( k.target_pos.x * 977 + k.target_pos.y ) * 31 + k.target_pos.z;
+    }
+};
+
+// Bumped by invalidate, each thread drops its entries once it notices
+std::atomic<unsigned> generation( 1 );
+
+struct thread_entries {
+    unsigned generation = 0;
+    std::unordered_map<sight_key, sight_cache::result, sight_key_hash> results;
+};
+
+thread_entries &current_entries()
+{
+    static thread_local thread_entries entries;
+    const unsigned current = generation;
+    if( entries.generation != current ) {
+        entries.results.clear();
+        entries.generation = current;
+    }
+    return entries;
+}
+
+} // namespace
+
+namespace sight_cache {
+
+bool lookup( const Creature &observer, const Creature &target, result &r )
+{
+    const auto &results = current_entries().results;
+    const auto it = results.find( { &observer, &target, observer.pos3(), target.pos3() } );
+    if( it == results.end() ) {
+        turn_profiler::count( turn_profiler::COUNTER_SIGHT_CACHE_MISSES );
+        return false;
+    }
+    turn_profiler::count( turn_profiler::COUNTER_SIGHT_CACHE_HITS );
+    r = it->second;
+    return true;
+}
+
+void store( const Creature &observer, const Creature &target, const result &r )
+{
+    current_entries().results[ { &observer, &target, observer.pos3(), target.pos3() } ] = r;
+}
+
+void invalidate()
+{
+    generation++;
+}
+
+} // namespace sight_cache
@@ -0,0 +1,29 @@
+#ifndef SIGHT_CACHE_H
+#define SIGHT_CACHE_H
+
+class Creature;
+
+/**
+ * Results of Creature::sees( Creature ) remembered for pairs of creatures, as the same pairs
+ * are checked again and again during a turn (monster plans and triggers, NPC targeting, the sidebar).
+ *
+ * The positions of both creatures are part of the key, so moving either of them misses.
+ * @ref invalidate forgets everything, it is called when the map caches behind the checks are
+ * rebuilt (at least once per turn), when creatures are removed and when effects change.
+ * Each thread has its own entries, the hits and misses are counted by the turn profiler.
+ */
+namespace sight_cache {
+    struct result {
+        bool seen = false;
+        int bresen1 = 0;
+        int bresen2 = 0;
+    };
+
+    /** Gets the result for `observer` and `target` at their current positions. */
+    bool lookup( const Creature &observer, const Creature &target, result &r );
+    void store( const Creature &observer, const Creature &target, const result &r );
+    /** Forgets the results of all threads. */
+    void invalidate();
+}
+
+#endif
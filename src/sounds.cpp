@@ -9,6 +9,8 @@
 #include "messages.h"
 #include "monster.h"
 #include "line.h"
+#include "creature_tracker.h"
+#include "turn_profiler.h"
 
 struct sound_event {
     int volume;
@@ -145,9 +147,15 @@ void sounds::process_sounds()
             overmap_buffer.signal_hordes( target, sig_power );
         }
         // Alert all monsters (that can hear) to the sound.
-        for (int i = 0, numz = g->num_zombies(); i < numz; i++) {
+        // Even with good hearing only those closer than twice the volume can hear it, so only
+        // the monsters within that radius are looked at.
+        if( vol <= 0 ) {
+            continue;
+        }
+        const std::vector<int> listeners = g->critter_tracker->monsters_within_radius( source, vol * 2 - 1 );
+        int notified = 0;
+        for( const int i : listeners ) {
             monster &critter = g->zombie(i);
-            // rl_dist() is faster than critter.has_flag() or critter.can_hear(), so we'll check it first.
             int dist = rl_dist( source, critter.pos3() );
             int vol_goodhearing = vol * 2 - dist;
             if (vol_goodhearing > 0 && critter.can_hear()) {
@@ -173,9 +181,12 @@ void sounds::process_sounds()
                     int wander_turns = volume * (goodhearing ? 6 : 1);
                     critter.wander_to( tripoint( target_x, target_y, source.z ), wander_turns);
                     critter.process_trigger(MTRIG_SOUND, volume);
+                    notified++;
                 }
             }
         }
+        turn_profiler::count( turn_profiler::COUNTER_SOUND_LISTENERS_TESTED, listeners.size() );
+        turn_profiler::count( turn_profiler::COUNTER_SOUND_LISTENERS_NOTIFIED, notified );
     }
     recent_sounds.clear();
 }
@@ -0,0 +1,738 @@
+#include "submap_io.h"
+#include "mapdata.h"
+#include "json.h"
+#include "item.h"
+#include "output.h"
+#include "savegame.h"
+#include "trap.h"
+#include "vehicle.h"
+
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <sstream>
+
+const int submap_io::binary_version = 1;
+
+namespace
+{
+
+const char binary_magic[4] = { 'C', 'S', 'M', 'B' };
+const int cells = SEEX * SEEY;
+
+// Numbers are written as base 128 varints, signed ones zigzag encoded first,
+// so the small values that make up most of a submap take a single byte.
+class binary_writer
+{
+    public:
+        std::string data;
+
+        void byte( int value ) {
+            data.push_back( static_cast<char>( value ) );
+        }
+        void uint( unsigned value ) {
+            while( value >= 0x80 ) {
+                byte( ( value & 0x7f ) | 0x80 );
+                value >>= 7;
+            }
+            byte( value );
+        }
+        void sint( int value ) {
+            uint( ( static_cast<unsigned>( value ) << 1 ) ^ static_cast<unsigned>( value >> 31 ) );
+        }
+        void string( const std::string &value ) {
+            uint( value.size() );
+            data.append( value );
+        }
+};
+
+class binary_reader
+{
+    public:
+        binary_reader( const char *d, size_t s, size_t start ) : data( d ), size( s ), pos( start ) { }
+
+        bool at_end() const {
+            return pos == size;
+        }
+        int byte() {
+            if( pos >= size ) {
+                error( "unexpected end of data" );
+            }
+            return static_cast<unsigned char>( data[pos++] );
+        }
+        unsigned uint() {
+            unsigned value = 0;
+            for( int shift = 0; shift < 35; shift += 7 ) {
+                const int b = byte();
+                value |= static_cast<unsigned>( b & 0x7f ) << shift;
+                if( ( b & 0x80 ) == 0 ) {
+                    return value;
+                }
+            }
+            error( "number too long" );
+            return 0;
+        }
+        int sint() {
+            const unsigned value = uint();
+            return static_cast<int>( value >> 1 ) ^ -static_cast<int>( value & 1 );
+        }
+        std::string string() {
+            const size_t length = uint();
+            if( length > size - pos ) {
+                error( "string exceeds the data" );
+            }
+            const size_t start = pos;
+            pos += length;
+            return std::string( data + start, length );
+        }
+        /** Reads the number of the entries that follow, each of which takes at least a byte. */
+        size_t count() {
+            const size_t value = uint();
+            if( value > size - pos ) {
+                error( string_format( "%u entries exceed the data", unsigned( value ) ) );
+            }
+            return value;
+        }
+        /** Reads an index below `limit`. */
+        int index( size_t limit, const char *what ) {
+            const unsigned value = uint();
+            if( value >= limit ) {
+                error( string_format( "invalid %s %u", what, value ) );
+            }
+            return value;
+        }
+        void error( const std::string &message ) const {
+            throw string_format( "binary map data, offset %d: %s", int( pos ), message.c_str() );
+        }
+
+    private:
+        const char *data;
+        size_t size;
+        size_t pos;
+};
+
+// Maps the ids of one kind that appear in a file to consecutive numbers.
+class palette_builder
+{
+    public:
+        std::vector<int> ids;
+
+        int get( int id ) {
+            if( id >= static_cast<int>( index.size() ) ) {
+                index.resize( id + 1, -1 );
+            }
+            if( index[id] < 0 ) {
+                index[id] = ids.size();
+                ids.push_back( id );
+            }
+            return index[id];
+        }
+
+    private:
+        std::vector<int> index;
+};
+
+// Cells are numbered row by row, like the arrays of the JSON format.
+template<typename F>
+void write_runs( binary_writer &out, F value_at )
+{
+    int last = value_at( 0, 0 );
+    int run = 0;
+    for( int j = 0; j < SEEY; j++ ) {
+        for( int i = 0; i < SEEX; i++ ) {
+            const int value = value_at( i, j );
+            if( value != last ) {
+                out.uint( run );
+                out.sint( last );
+                last = value;
+                run = 0;
+            }
+            run++;
+        }
+    }
+    out.uint( run );
+    out.sint( last );
+}
+
+template<typename F>
+void read_runs( binary_reader &in, F set_cell )
+{
+    int cell = 0;
+    while( cell < cells ) {
+        const unsigned run = in.uint();
+        const int value = in.sint();
+        if( run == 0 || run > static_cast<unsigned>( cells - cell ) ) {
+            in.error( "invalid run length" );
+        }
+        for( const int end = cell + run; cell < end; cell++ ) {
+            if( !set_cell( cell % SEEX, cell / SEEX, value ) ) {
+                in.error( string_format( "invalid value %d", value ) );
+            }
+        }
+    }
+}
+
+void add_loaded_item( submap &sm, int i, int j, const item &tmp )
+{
+    if( tmp.is_emissive() ) {
+        sm.update_lum_add( tmp, i, j );
+    }
+
+    sm.itm[i][j].push_back( tmp );
+    if( tmp.needs_processing() ) {
+        sm.active_items.add( std::prev( sm.itm[i][j].end() ), point( i, j ) );
+    }
+}
+
+void add_loaded_field( submap &sm, int i, int j, int type, int density, int age )
+{
+    if( sm.fld[i][j].findField( field_id( type ) ) == NULL ) {
+        sm.field_count++;
+    }
+    sm.fld[i][j].addField( field_id( type ), density, age );
+    sm.set_field_tile( i, j );
+}
+
+void write_submap( binary_writer &out, const tripoint &p, submap &sm, palette_builder &terrain,
+                   palette_builder &furniture, palette_builder &traps )
+{
+    out.sint( p.x );
+    out.sint( p.y );
+    out.sint( p.z );
+    out.sint( sm.turn_last_touched );
+    out.sint( sm.temperature );
+
+    write_runs( out, [&]( int i, int j ) {
+        return terrain.get( sm.ter[i][j] );
+    } );
+    write_runs( out, [&]( int i, int j ) {
+        return furniture.get( sm.frn[i][j] );
+    } );
+    write_runs( out, [&]( int i, int j ) {
+        return traps.get( sm.trp[i][j].to_i() );
+    } );
+    write_runs( out, [&]( int i, int j ) {
+        return sm.rad[i][j];
+    } );
+
+    // The sparse data of a tile starts with the number of its cell.
+    // Items are kept in their JSON form, all of those of a submap in one array after their counts.
+    int tiles = 0;
+    for( int j = 0; j < SEEY; j++ ) {
+        for( int i = 0; i < SEEX; i++ ) {
+            tiles += !sm.itm[i][j].empty();
+        }
+    }
+    out.uint( tiles );
+    if( tiles > 0 ) {
+        std::ostringstream items;
+        JsonOut jsout( items );
+        jsout.start_array();
+        for( int j = 0; j < SEEY; j++ ) {
+            for( int i = 0; i < SEEX; i++ ) {
+                if( sm.itm[i][j].empty() ) {
+                    continue;
+                }
+                out.uint( j * SEEX + i );
+                out.uint( sm.itm[i][j].size() );
+                for( auto &it : sm.itm[i][j] ) {
+                    jsout.write( it );
+                }
+            }
+        }
+        jsout.end_array();
+        out.string( items.str() );
+    }
+
+    tiles = 0;
+    for( int j = 0; j < SEEY; j++ ) {
+        for( int i = 0; i < SEEX; i++ ) {
+            tiles += sm.fld[i][j].fieldCount() > 0;
+        }
+    }
+    out.uint( tiles );
+    for( int j = 0; j < SEEY; j++ ) {
+        for( int i = 0; i < SEEX; i++ ) {
+            if( sm.fld[i][j].fieldCount() == 0 ) {
+                continue;
+            }
+            out.uint( j * SEEX + i );
+            out.uint( sm.fld[i][j].fieldCount() );
+            for( auto &fld : sm.fld[i][j] ) {
+                const field_entry &cur = fld.second;
+                out.uint( cur.getFieldType() );
+                out.sint( cur.getFieldDensity() );
+                out.sint( cur.getFieldAge() );
+            }
+        }
+    }
+
+    tiles = 0;
+    for( int j = 0; j < SEEY; j++ ) {
+        for( int i = 0; i < SEEX; i++ ) {
+            tiles += !sm.cosmetics[i][j].empty();
+        }
+    }
+    out.uint( tiles );
+    for( int j = 0; j < SEEY; j++ ) {
+        for( int i = 0; i < SEEX; i++ ) {
+            if( sm.cosmetics[i][j].empty() ) {
+                continue;
+            }
+            out.uint( j * SEEX + i );
+            out.uint( sm.cosmetics[i][j].size() );
+            for( auto &cosmetic : sm.cosmetics[i][j] ) {
+                out.string( cosmetic.first );
+                out.string( cosmetic.second );
+            }
+        }
+    }
+
+    out.uint( sm.spawns.size() );
+    for( auto &elem : sm.spawns ) {
+        out.string( elem.type );
+        out.sint( elem.count );
+        out.sint( elem.posx );
+        out.sint( elem.posy );
+        out.sint( elem.faction_id );
+        out.sint( elem.mission_id );
+        out.byte( elem.friendly );
+        out.string( elem.name );
+    }
+
+    out.uint( sm.vehicles.size() );
+    for( auto &elem : sm.vehicles ) {
+        std::ostringstream veh;
+        JsonOut jsout( veh );
+        jsout.write( *elem );
+        out.string( veh.str() );
+    }
+
+    out.string( sm.comp.name != "" ? sm.comp.save_data() : std::string() );
+    out.string( sm.camp.is_valid() ? sm.camp.save_data() : std::string() );
+}
+
+std::unique_ptr<submap> read_submap( binary_reader &in, tripoint &p,
+                                     const std::vector<ter_id> &terrain,
+                                     const std::vector<furn_id> &furniture,
+                                     const std::vector<trap_id> &traps )
+{
+    std::unique_ptr<submap> sm( new submap() );
+    p.x = in.sint();
+    p.y = in.sint();
+    p.z = in.sint();
+    sm->turn_last_touched = in.sint();
+    sm->temperature = in.sint();
+
+    read_runs( in, [&]( int i, int j, int value ) {
+        if( value < 0 || value >= static_cast<int>( terrain.size() ) ) {
+            return false;
+        }
+        sm->ter[i][j] = terrain[value];
+        return true;
+    } );
+    read_runs( in, [&]( int i, int j, int value ) {
+        if( value < 0 || value >= static_cast<int>( furniture.size() ) ) {
+            return false;
+        }
+        sm->frn[i][j] = furniture[value];
+        return true;
+    } );
+    read_runs( in, [&]( int i, int j, int value ) {
+        if( value < 0 || value >= static_cast<int>( traps.size() ) ) {
+            return false;
+        }
+        sm->trp[i][j] = traps[value];
+        return true;
+    } );
+    read_runs( in, [&]( int i, int j, int value ) {
+        sm->rad[i][j] = value;
+        return true;
+    } );
+
+    const int item_tiles = in.uint();
+    if( item_tiles > 0 ) {
+        std::vector<std::pair<int, int>> item_counts;
+        for( int tiles = item_tiles; tiles > 0; tiles-- ) {
+            const int cell = in.index( cells, "cell" );
+            item_counts.emplace_back( cell, in.uint() );
+        }
+        std::istringstream items( in.string() );
+        JsonIn jsin( items );
+        jsin.start_array();
+        for( auto &elem : item_counts ) {
+            for( int count = elem.second; count > 0; count-- ) {
+                if( jsin.end_array() ) {
+                    in.error( "missing items" );
+                }
+                item tmp;
+                jsin.read( tmp );
+                add_loaded_item( *sm, elem.first % SEEX, elem.first / SEEX, tmp );
+            }
+        }
+        if( !jsin.end_array() ) {
+            in.error( "unexpected items" );
+        }
+    }
+
+    for( int tiles = in.uint(); tiles > 0; tiles-- ) {
+        const int cell = in.index( cells, "cell" );
+        for( int count = in.uint(); count > 0; count-- ) {
+            const int type = in.index( num_fields, "field type" );
+            const int density = in.sint();
+            const int age = in.sint();
+            add_loaded_field( *sm, cell % SEEX, cell / SEEX, type, density, age );
+        }
+    }
+
+    for( int tiles = in.uint(); tiles > 0; tiles-- ) {
+        const int cell = in.index( cells, "cell" );
+        auto &cosmetics = sm->cosmetics[cell % SEEX][cell / SEEX];
+        for( int count = in.uint(); count > 0; count-- ) {
+            const std::string key = in.string();
+            cosmetics[key] = in.string();
+        }
+    }
+
+    for( int count = in.uint(); count > 0; count-- ) {
+        spawn_point tmp;
+        tmp.type = in.string();
+        tmp.count = in.sint();
+        tmp.posx = in.sint();
+        tmp.posy = in.sint();
+        tmp.faction_id = in.sint();
+        tmp.mission_id = in.sint();
+        tmp.friendly = in.byte() != 0;
+        tmp.name = in.string();
+        sm->spawns.push_back( tmp );
+    }
+
+    for( int count = in.uint(); count > 0; count-- ) {
+        std::istringstream veh( in.string() );
+        JsonIn jsin( veh );
+        vehicle *tmp = new vehicle();
+        sm->vehicles.push_back( tmp );
+        jsin.read( *tmp );
+    }
+
+    const std::string computer_data = in.string();
+    if( !computer_data.empty() ) {
+        sm->comp.load_data( computer_data );
+    }
+    const std::string camp_data = in.string();
+    if( !camp_data.empty() ) {
+        sm->camp.load_data( camp_data );
+    }
+    // Same as the file, quads loaded from JSON stay dirty so the next save converts them
+    sm->dirty = false;
+    return sm;
+}
+
+void read_quad_binary( const char *data, size_t size, submap_io::quad_in &submaps )
+{
+    binary_reader in( data, size, sizeof( binary_magic ) );
+    const int version = in.uint();
+    if( version > submap_io::binary_version ) {
+        in.error( string_format( "unknown format version %d", version ) );
+    }
+    // The version of the game data, for future migrations like those of the JSON format
+    in.uint();
+
+    std::vector<ter_id> terrain( in.count() );
+    for( auto &elem : terrain ) {
+        elem = terfind( in.string() );
+    }
+    std::vector<furn_id> furniture( in.count() );
+    for( auto &elem : furniture ) {
+        elem = furnfind( in.string() );
+    }
+    std::vector<trap_id> traps( in.count() );
+    for( auto &elem : traps ) {
+        elem = trap_str_id( in.string() );
+    }
+
+    for( int count = in.uint(); count > 0; count-- ) {
+        tripoint p;
+        std::unique_ptr<submap> sm = read_submap( in, p, terrain, furniture, traps );
+        submaps.emplace_back( p, std::move( sm ) );
+    }
+    if( !in.at_end() ) {
+        in.error( "unexpected data after the last submap" );
+    }
+}
+
+void read_quad_json( JsonIn &jsin, submap_io::quad_in &submaps )
+{
+    jsin.start_array();
+    while( !jsin.end_array() ) {
+        std::unique_ptr<submap> sm(new submap());
+        tripoint submap_coordinates;
+        jsin.start_object();
+        bool rubpow_update = false;
+        while( !jsin.end_object() ) {
+            std::string submap_member_name = jsin.get_member_name();
+            if( submap_member_name == "version" ) {
+                if (jsin.get_int() < 22) {
+                    rubpow_update = true;
+                }
+            } else if( submap_member_name == "coordinates" ) {
+                jsin.start_array();
+                int locx = jsin.get_int();
+                int locy = jsin.get_int();
+                int locz = jsin.get_int();
+                jsin.end_array();
+                submap_coordinates = tripoint( locx, locy, locz );
+            } else if( submap_member_name == "turn_last_touched" ) {
+                sm->turn_last_touched = jsin.get_int();
+            } else if( submap_member_name == "temperature" ) {
+                sm->temperature = jsin.get_int();
+            } else if( submap_member_name == "terrain" ) {
+                // TODO: try block around this to error out if we come up short?
+                jsin.start_array();
+                // Small duplication here so that the update check is only performed once
+                if (rubpow_update) {
+                    std::string ter_string;
+                    item rock = item("rock", 0);
+                    item chunk = item("steel_chunk", 0);
+                    for( int j = 0; j < SEEY; j++ ) {
+                        for( int i = 0; i < SEEX; i++ ) {
+                            ter_string = jsin.get_string();
+                            if (ter_string == "t_rubble") {
+                                sm->ter[i][j] = termap[ "t_dirt" ].loadid;
+                                sm->frn[i][j] = furnmap[ "f_rubble" ].loadid;
+                                sm->itm[i][j].push_back( rock );
+                                sm->itm[i][j].push_back( rock );
+                            } else if (ter_string == "t_wreckage"){
+                                sm->ter[i][j] = termap[ "t_dirt" ].loadid;
+                                sm->frn[i][j] = furnmap[ "f_wreckage" ].loadid;
+                                sm->itm[i][j].push_back( chunk );
+                                sm->itm[i][j].push_back( chunk );
+                            } else if (ter_string == "t_ash"){
+                                sm->ter[i][j] = termap[ "t_dirt" ].loadid;
+                                sm->frn[i][j] = furnmap[ "f_ash" ].loadid;
+                            } else if (ter_string == "t_pwr_sb_support_l"){
+                                sm->ter[i][j] = termap[ "t_support_l" ].loadid;
+                            } else if (ter_string == "t_pwr_sb_switchgear_l"){
+                                sm->ter[i][j] = termap[ "t_switchgear_l" ].loadid;
+                            } else if (ter_string == "t_pwr_sb_switchgear_s"){
+                                sm->ter[i][j] = termap[ "t_switchgear_s" ].loadid;
+                            } else {
+                                sm->ter[i][j] = terfind( ter_string );
+                            }
+                        }
+                    }
+                } else {
+                    for( int j = 0; j < SEEY; j++ ) {
+                        for( int i = 0; i < SEEX; i++ ) {
+                            sm->ter[i][j] = terfind( jsin.get_string() );
+                        }
+                    }
+                }
+                jsin.end_array();
+            } else if( submap_member_name == "radiation" ) {
+                int rad_cell = 0;
+                jsin.start_array();
+                while( !jsin.end_array() ) {
+                    int rad_strength = jsin.get_int();
+                    int rad_num = jsin.get_int();
+                    for( int i = 0; i < rad_num && rad_cell < cells; ++i ) {
+                        // Cells are written row by row
+                        sm->set_radiation( rad_cell % SEEX, rad_cell / SEEX, rad_strength );
+                        rad_cell++;
+                    }
+                }
+            } else if( submap_member_name == "furniture" ) {
+                jsin.start_array();
+                while( !jsin.end_array() ) {
+                    jsin.start_array();
+                    int i = jsin.get_int();
+                    int j = jsin.get_int();
+                    sm->frn[i][j] = furnmap[ jsin.get_string() ].loadid;
+                    jsin.end_array();
+                }
+            } else if( submap_member_name == "items" ) {
+                jsin.start_array();
+                while( !jsin.end_array() ) {
+                    int i = jsin.get_int();
+                    int j = jsin.get_int();
+                    jsin.start_array();
+                    while( !jsin.end_array() ) {
+                        item tmp;
+                        jsin.read( tmp );
+                        add_loaded_item( *sm, i, j, tmp );
+                    }
+                }
+            } else if( submap_member_name == "traps" ) {
+                jsin.start_array();
+                while( !jsin.end_array() ) {
+                    jsin.start_array();
+                    int i = jsin.get_int();
+                    int j = jsin.get_int();
+                    // TODO: jsin should support returning an id like jsin.get_id<trap>()
+                    sm->trp[i][j] = trap_str_id( jsin.get_string() );
+                    jsin.end_array();
+                }
+            } else if( submap_member_name == "fields" ) {
+                jsin.start_array();
+                while( !jsin.end_array() ) {
+                    // Coordinates loop
+                    int i = jsin.get_int();
+                    int j = jsin.get_int();
+                    jsin.start_array();
+                    while( !jsin.end_array() ) {
+                        int type = jsin.get_int();
+                        int density = jsin.get_int();
+                        int age = jsin.get_int();
+                        add_loaded_field( *sm, i, j, type, density, age );
+                    }
+                }
+            } else if( submap_member_name == "graffiti" ) {
+                jsin.start_array();
+                while( !jsin.end_array() ) {
+                    jsin.start_array();
+                    int i = jsin.get_int();
+                    int j = jsin.get_int();
+                    sm->set_graffiti( i, j, jsin.get_string() );
+                    jsin.end_array();
+                }
+            } else if(submap_member_name == "cosmetics") {
+                jsin.start_array();
+                while (!jsin.end_array()) {
+                    jsin.start_array();
+                    int i = jsin.get_int();
+                    int j = jsin.get_int();
+                    jsin.read(sm->cosmetics[i][j]);
+                    jsin.end_array();
+                }
+            } else if( submap_member_name == "spawns" ) {
+                jsin.start_array();
+                while( !jsin.end_array() ) {
+                    jsin.start_array();
+                    std::string type = jsin.get_string();
+                    int count = jsin.get_int();
+                    int i = jsin.get_int();
+                    int j = jsin.get_int();
+                    int faction_id = jsin.get_int();
+                    int mission_id = jsin.get_int();
+                    bool friendly = jsin.get_bool();
+                    std::string name = jsin.get_string();
+                    jsin.end_array();
+                    spawn_point tmp( type, count, i, j, faction_id, mission_id, friendly, name );
+                    sm->spawns.push_back( tmp );
+                }
+            } else if( submap_member_name == "vehicles" ) {
+                jsin.start_array();
+                while( !jsin.end_array() ) {
+                    vehicle *tmp = new vehicle();
+                    jsin.read( *tmp );
+                    sm->vehicles.push_back( tmp );
+                }
+            } else if( submap_member_name == "computers" ) {
+                std::string computer_data = jsin.get_string();
+                sm->comp.load_data( computer_data );
+            } else if( submap_member_name == "camp" ) {
+                std::string camp_data = jsin.get_string();
+                sm->camp.load_data( camp_data );
+            } else {
+                jsin.skip_value();
+            }
+        }
+        submaps.emplace_back( submap_coordinates, std::move( sm ) );
+    }
+}
+
+}
+
+void submap_io::write_quad( std::ostream &fout, const quad_out &submaps )
+{
+    palette_builder terrain;
+    palette_builder furniture;
+    palette_builder traps;
+    binary_writer body;
+    body.uint( submaps.size() );
+    for( auto &elem : submaps ) {
+        write_submap( body, elem.first, *elem.second, terrain, furniture, traps );
+    }
+
+    binary_writer out;
+    out.data.append( binary_magic, sizeof( binary_magic ) );
+    out.uint( binary_version );
+    out.uint( savegame_version );
+    out.uint( terrain.ids.size() );
+    for( const int id : terrain.ids ) {
+        out.string( terlist[id].id );
+    }
+    out.uint( furniture.ids.size() );
+    for( const int id : furniture.ids ) {
+        out.string( furnlist[id].id );
+    }
+    out.uint( traps.ids.size() );
+    for( const int id : traps.ids ) {
+        out.string( trap_id( id ).id().str() );
+    }
+    fout.write( out.data.data(), out.data.size() );
+    fout.write( body.data.data(), body.data.size() );
+}
+
+std::unique_ptr<submap> submap_io::snapshot( const submap &sm )
+{
+    std::unique_ptr<submap> copy( new submap() );
+    for( int i = 0; i < SEEX; i++ ) {
+        for( int j = 0; j < SEEY; j++ ) {
+            copy->ter[i][j] = sm.ter[i][j];
+            copy->frn[i][j] = sm.frn[i][j];
+            copy->lum[i][j] = sm.lum[i][j];
+            copy->itm[i][j] = sm.itm[i][j];
+            copy->fld[i][j] = sm.fld[i][j];
+            copy->trp[i][j] = sm.trp[i][j];
+            copy->rad[i][j] = sm.rad[i][j];
+            copy->cosmetics[i][j] = sm.cosmetics[i][j];
+        }
+        copy->field_tiles[i] = sm.field_tiles[i];
+    }
+    copy->is_uniform = sm.is_uniform;
+    copy->dirty = sm.dirty;
+    copy->field_count = sm.field_count;
+    copy->turn_last_touched = sm.turn_last_touched;
+    copy->temperature = sm.temperature;
+    copy->spawns = sm.spawns;
+    for( auto &elem : sm.vehicles ) {
+        copy->vehicles.push_back( new vehicle( *elem ) );
+    }
+    copy->comp = sm.comp;
+    copy->camp = sm.camp;
+    return copy;
+}
+
+bool submap_io::is_binary( const std::string &data )
+{
+    return is_binary( data.data(), data.size() );
+}
+
+bool submap_io::is_binary( const char *data, size_t size )
+{
+    return size >= sizeof( binary_magic ) && memcmp( data, binary_magic, sizeof( binary_magic ) ) == 0;
+}
+
+void submap_io::read_quad( const std::string &data, quad_in &submaps )
+{
+    read_quad( data.data(), data.size(), submaps );
+}
+
+void submap_io::read_quad( const char *data, size_t size, quad_in &submaps )
+{
+    if( is_binary( data, size ) ) {
+        read_quad_binary( data, size, submaps );
+    } else {
+        std::istringstream fin( std::string( data, size ) );
+        JsonIn jsin( fin );
+        read_quad_json( jsin, submaps );
+    }
+}
+
+void submap_io::read_quad( std::istream &fin, quad_in &submaps )
+{
+    std::ostringstream data;
+    data << fin.rdbuf();
+    read_quad( data.str(), submaps );
+}
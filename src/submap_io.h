@@ -0,0 +1,57 @@
+#ifndef SUBMAP_IO_H
+#define SUBMAP_IO_H
+
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "enums.h"
+
+struct submap;
+
+/**
+ * Encoding and decoding of the saved quads, see @ref map_pack for the files they are stored in.
+ *
+ * Quads are written in a binary format: a header with a magic number and the format version,
+ * a palette that maps the terrain, furniture and trap ids used in the file to small numbers,
+ * and for each submap the run length encoded terrain, furniture, trap and radiation planes
+ * followed by the sparse data (items, fields, cosmetics, spawns, vehicles, computer and camp).
+ * Quads in the older JSON format are still read, they are replaced on the next save.
+ *
+ * Errors in the data are thrown as std::string, like the errors of @ref JsonIn.
+ */
+namespace submap_io
+{
+
+/** Version of the binary format, written into the header of each file. */
+extern const int binary_version;
+
+typedef std::vector<std::pair<tripoint, submap *>> quad_out;
+typedef std::vector<std::pair<tripoint, std::unique_ptr<submap>>> quad_in;
+
+/** Writes the submaps in the binary format. */
+void write_quad( std::ostream &fout, const quad_out &submaps );
+
+/**
+ * Reads the submaps of a file in either format and appends them to `submaps`.
+ * Submaps from binary files are not dirty, those from JSON files are.
+ */
+void read_quad( std::istream &fin, quad_in &submaps );
+/** Same as @ref read_quad for a file that is already in memory. */
+void read_quad( const std::string &data, quad_in &submaps );
+void read_quad( const char *data, size_t size, quad_in &submaps );
+
+/**
+ * Copies everything of a submap that is saved, so it can be written on another thread.
+ * The copy has its own vehicles but no active item cache.
+ */
+std::unique_ptr<submap> snapshot( const submap &sm );
+
+/** Whether the data starts with the header of the binary format. */
+bool is_binary( const std::string &data );
+bool is_binary( const char *data, size_t size );
+
+}
+
+#endif
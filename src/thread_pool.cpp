@@ -0,0 +1,98 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+
+thread_pool::thread_pool( const int workers ) : next_index( 0 )
+{
+    for( int i = 0; i < workers; i++ ) {
+        threads.emplace_back( &thread_pool::work, this );
+    }
+}
+
+thread_pool::~thread_pool()
+{
+    {
+        std::lock_guard<std::mutex> lock( mutex );
+        stopping = true;
+    }
+    wake.notify_all();
+    for( auto &t : threads ) {
+        t.join();
+    }
+}
+
+int thread_pool::size() const
+{
+    return threads.size() + 1;
+}
+
+thread_pool &thread_pool::instance()
+{
+    // hardware_concurrency may report 0 if it does not know
+    static thread_pool pool( std::min( 7, std::max( 1, int( std::thread::hardware_concurrency() ) ) - 1 ) );
+    return pool;
+}
+
+void thread_pool::run( const int count, const std::function<void( int )> &task )
+{
+    if( threads.empty() || count <= 1 ) {
+        for( int i = 0; i < count; i++ ) {
+            task( i );
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock( mutex );
+        this->task = &task;
+        this->count = count;
+        next_index = 0;
+        busy_workers = threads.size();
+        batch++;
+    }
+    wake.notify_all();
+
+    take_tasks();
+
+    // Workers still hold a pointer to `task` until they are done with the batch
+    std::unique_lock<std::mutex> lock( mutex );
+    done.wait( lock, [this]() {
+        return busy_workers == 0;
+    } );
+    this->task = nullptr;
+}
+
+void thread_pool::take_tasks()
+{
+    for( int i = next_index++; i < count; i = next_index++ ) {
+        ( *task )( i );
+    }
+}
+
+void thread_pool::work()
+{
+    unsigned seen_batch = 0;
+    while( true ) {
+        {
+            std::unique_lock<std::mutex> lock( mutex );
+            wake.wait( lock, [this, seen_batch]() {
+                return stopping || batch != seen_batch;
+            } );
+            if( stopping ) {
+                return;
+            }
+            seen_batch = batch;
+        }
+
+        take_tasks();
+
+        bool last;
+        {
+            std::lock_guard<std::mutex> lock( mutex );
+            last = --busy_workers == 0;
+        }
+        if( last ) {
+            done.notify_one();
+        }
+    }
+}
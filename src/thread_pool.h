@@ -0,0 +1,58 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * A fixed set of worker threads for splitting up short, independent pieces of work.
+ *
+ * @ref run hands out the indices of a batch to the workers and the calling thread and
+ * returns once all of them are done, so the batch can use data owned by the caller.
+ * Tasks of the same batch must not write to the same memory and must not call @ref run.
+ * Only one thread may call @ref run at a time.
+ */
+class thread_pool
+{
+    public:
+        /** Starts `workers` threads, none means everything runs on the calling thread. */
+        thread_pool( int workers );
+        ~thread_pool();
+
+        thread_pool( const thread_pool & ) = delete;
+        thread_pool &operator=( const thread_pool & ) = delete;
+
+        /** Number of threads working on a batch, including the calling one. */
+        int size() const;
+        /** Calls `task( i )` for each i in [0, count) and waits for all of the calls to return. */
+        void run( int count, const std::function<void( int )> &task );
+
+        /** The pool of the game, with a worker for each additional hardware thread (at most 7). */
+        static thread_pool &instance();
+
+    private:
+        void work();
+        // Runs tasks of the current batch until there are none left.
+        void take_tasks();
+
+        std::vector<std::thread> threads;
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::condition_variable done;
+
+        // Current batch, only changed under `mutex` while no worker is busy with it
+        const std::function<void( int )> *task = nullptr;
+        int count = 0;
+        std::atomic<int> next_index;
+        // Incremented for each batch, so the workers know when to start
+        unsigned batch = 0;
+        // Workers that have not finished with the current batch
+        int busy_workers = 0;
+        bool stopping = false;
+};
+
+#endif
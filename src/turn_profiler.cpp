@@ -0,0 +1,350 @@
+#include "turn_profiler.h"
+
+#include "output.h"
+#include "translations.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+struct phase_record {
+    // Ring buffer of the durations of the last turns, in milliseconds
+    std::array<double, turn_profiler::WINDOW_TURNS> samples;
+    // Number of samples in the window falling into each bucket
+    std::array<int, turn_profiler::NUM_BUCKETS> histogram;
+    // Accumulated during the current turn
+    double current = 0.0;
+    double total = 0.0;
+};
+
+struct counter_record {
+    std::array<int, turn_profiler::WINDOW_TURNS> samples;
+    // Counted during the current turn, possibly by several threads
+    std::atomic<int> current;
+    long long total = 0;
+};
+
+// Read without synchronization by count, only changed between turns
+bool profiling = false;
+bool show_overlay = false;
+std::array<phase_record, turn_profiler::NUM_PHASES> records;
+std::array<counter_record, turn_profiler::NUM_COUNTERS> counters;
+// Turns recorded since enabling, the window holds the last min(turns, WINDOW_TURNS) of them
+int turns = 0;
+std::ofstream trace_file;
+
+int bucket_of( const double ms )
+{
+    return std::upper_bound( std::begin( turn_profiler::bucket_limits ),
+                             std::end( turn_profiler::bucket_limits ), ms ) -
+           std::begin( turn_profiler::bucket_limits );
+}
+
+int window_size()
+{
+    return std::min( turns, turn_profiler::WINDOW_TURNS );
+}
+
+} // namespace
+
+namespace turn_profiler {
+
+scoped_timer::scoped_timer( const phase p ) : p( p ), running( profiling )
+{
+    if( running ) {
+        start = std::chrono::steady_clock::now();
+    }
+}
+
+scoped_timer::~scoped_timer()
+{
+    if( running ) {
+        const auto end = std::chrono::steady_clock::now();
+        records[p].current += std::chrono::duration<double, std::milli>( end - start ).count();
+    }
+}
+
+const char *phase_name( const phase p )
+{
+    switch( p ) {
+        case PHASE_EVENTS:
+            return "events";
+        case PHASE_SCENT:
+            return "scent";
+        case PHASE_VEHMOVE:
+            return "vehmove";
+        case PHASE_VEHICLE_POWER:
+            return "vehicle_power";
+        case PHASE_FIELDS:
+            return "fields";
+        case PHASE_ACTIVE_ITEMS:
+            return "active_items";
+        case PHASE_SOUNDS:
+            return "sounds";
+        case PHASE_MAP_CACHE:
+            return "map_cache";
+        case PHASE_MONMOVE:
+            return "monmove";
+        case PHASE_STAIR_MONSTERS:
+            return "stair_monsters";
+        case PHASE_MAP_EVICTION:
+            return "map_eviction";
+        case NUM_PHASES:
+            break;
+    }
+    return "unknown";
+}
+
+const char *counter_name( const counter c )
+{
+    switch( c ) {
+        case COUNTER_SIGHT_CACHE_HITS:
+            return "sight_hits";
+        case COUNTER_SIGHT_CACHE_MISSES:
+            return "sight_misses";
+        case COUNTER_SOUND_LISTENERS_TESTED:
+            return "sound_tested";
+        case COUNTER_SOUND_LISTENERS_NOTIFIED:
+            return "sound_notified";
+        case COUNTER_ROUTE_EXPANSIONS:
+            return "route_expanded";
+        case COUNTER_PORTAL_ROUTES:
+            return "portal_routes";
+        case NUM_COUNTERS:
+            break;
+    }
+    return "unknown";
+}
+
+void count( const counter c, const int n )
+{
+    if( profiling ) {
+        counters[c].current += n;
+    }
+}
+
+void set_enabled( const bool enable )
+{
+    if( enable && !profiling ) {
+        reset();
+    }
+    profiling = enable;
+    if( !profiling ) {
+        show_overlay = false;
+        stop_trace();
+    }
+}
+
+bool is_enabled()
+{
+    return profiling;
+}
+
+void reset()
+{
+    for( auto &rec : records ) {
+        rec.histogram.fill( 0 );
+        rec.current = 0.0;
+        rec.total = 0.0;
+    }
+    for( auto &rec : counters ) {
+        rec.current = 0;
+        rec.total = 0;
+    }
+    turns = 0;
+}
+
+void end_turn( const int turn )
+{
+    if( !profiling ) {
+        return;
+    }
+
+    const int slot = turns % WINDOW_TURNS;
+    double turn_total = 0.0;
+    if( trace_file.is_open() ) {
+        trace_file << turn;
+    }
+    for( auto &rec : records ) {
+        if( turns >= WINDOW_TURNS ) {
+            // The oldest sample leaves the window
+            rec.histogram[bucket_of( rec.samples[slot] )]--;
+        }
+        rec.samples[slot] = rec.current;
+        rec.histogram[bucket_of( rec.current )]++;
+        rec.total += rec.current;
+        turn_total += rec.current;
+        if( trace_file.is_open() ) {
+            trace_file << ',' << rec.current;
+        }
+        rec.current = 0.0;
+    }
+    if( trace_file.is_open() ) {
+        trace_file << ',' << turn_total;
+    }
+    for( auto &rec : counters ) {
+        const int current = rec.current.exchange( 0 );
+        rec.samples[slot] = current;
+        rec.total += current;
+        if( trace_file.is_open() ) {
+            trace_file << ',' << current;
+        }
+    }
+    if( trace_file.is_open() ) {
+        trace_file << '\n';
+    }
+    turns++;
+}
+
+int recorded_turns()
+{
+    return turns;
+}
+
+phase_stats get_stats( const phase p )
+{
+    phase_stats stats;
+    const auto &rec = records[p];
+    const int size = window_size();
+    stats.total = rec.total;
+    std::copy( rec.histogram.begin(), rec.histogram.end(), stats.histogram );
+    if( size == 0 ) {
+        return stats;
+    }
+
+    stats.last = rec.samples[( turns - 1 ) % WINDOW_TURNS];
+    std::array<double, WINDOW_TURNS> sorted;
+    std::copy( rec.samples.begin(), rec.samples.begin() + size, sorted.begin() );
+    std::sort( sorted.begin(), sorted.begin() + size );
+    for( int i = 0; i < size; i++ ) {
+        stats.mean += sorted[i];
+    }
+    stats.mean /= size;
+    stats.p95 = sorted[std::min( size - 1, size * 95 / 100 )];
+    stats.max = sorted[size - 1];
+    return stats;
+}
+
+counter_stats get_stats( const counter c )
+{
+    counter_stats stats;
+    const auto &rec = counters[c];
+    const int size = window_size();
+    stats.total = rec.total;
+    if( size == 0 ) {
+        return stats;
+    }
+
+    stats.last = rec.samples[( turns - 1 ) % WINDOW_TURNS];
+    for( int i = 0; i < size; i++ ) {
+        stats.mean += rec.samples[i];
+        stats.max = std::max( stats.max, rec.samples[i] );
+    }
+    stats.mean /= size;
+    return stats;
+}
+
+bool start_trace( const std::string &path )
+{
+    stop_trace();
+    trace_file.open( path.c_str(), std::ios::out | std::ios::trunc );
+    if( !trace_file.is_open() ) {
+        return false;
+    }
+    set_enabled( true );
+
+    trace_file << "turn";
+    for( int i = 0; i < NUM_PHASES; i++ ) {
+        trace_file << ',' << phase_name( static_cast<phase>( i ) );
+    }
+    trace_file << ",total";
+    for( int i = 0; i < NUM_COUNTERS; i++ ) {
+        trace_file << ',' << counter_name( static_cast<counter>( i ) );
+    }
+    trace_file << '\n';
+    return true;
+}
+
+void stop_trace()
+{
+    if( trace_file.is_open() ) {
+        trace_file.close();
+    }
+}
+
+bool is_tracing()
+{
+    return trace_file.is_open();
+}
+
+void set_overlay( const bool show )
+{
+    if( show ) {
+        set_enabled( true );
+    }
+    show_overlay = show;
+}
+
+bool overlay_enabled()
+{
+    return show_overlay;
+}
+
+void draw_overlay( WINDOW *w )
+{
+    mvwprintz( w, 0, 0, c_white, "%-14s %7s %7s %7s", "phase (ms)", "last", "mean", "95%" );
+    double last_total = 0.0;
+    double mean_total = 0.0;
+    for( int i = 0; i < NUM_PHASES; i++ ) {
+        const phase_stats stats = get_stats( static_cast<phase>( i ) );
+        // Highlight the phases that take a large part of the turn
+        const nc_color col = stats.mean >= 5.0 ? c_red : ( stats.mean >= 1.0 ? c_yellow : c_ltgray );
+        mvwprintz( w, i + 1, 0, col, "%-14s %7.2f %7.2f %7.2f", phase_name( static_cast<phase>( i ) ),
+                   stats.last, stats.mean, stats.p95 );
+        last_total += stats.last;
+        mean_total += stats.mean;
+    }
+    mvwprintz( w, NUM_PHASES + 1, 0, c_white, "%-14s %7.2f %7.2f", "total", last_total, mean_total );
+    for( int i = 0; i < NUM_COUNTERS; i++ ) {
+        const counter_stats stats = get_stats( static_cast<counter>( i ) );
+        mvwprintz( w, NUM_PHASES + 2 + i, 0, c_ltgray, "%-14s %7d %7.0f", counter_name( static_cast<counter>( i ) ),
+                   stats.last, stats.mean );
+    }
+}
+
+void show_stats()
+{
+    std::ostringstream text;
+    text << string_format( _( "Last %d turns, durations in milliseconds:" ), window_size() ) << "\n\n";
+    text << string_format( "%-14s %7s %7s %7s %7s  ", "", "last", "mean", "95%", "max" );
+    // Header of the histogram: upper bounds of the buckets
+    for( int b = 0; b < NUM_BUCKETS - 1; b++ ) {
+        text << string_format( "%5g", bucket_limits[b] );
+    }
+    text << string_format( "%5s", "more" ) << "\n";
+
+    for( int i = 0; i < NUM_PHASES; i++ ) {
+        const phase_stats stats = get_stats( static_cast<phase>( i ) );
+        text << string_format( "%-14s %7.2f %7.2f %7.2f %7.2f  ", phase_name( static_cast<phase>( i ) ),
+                               stats.last, stats.mean, stats.p95, stats.max );
+        for( const int count : stats.histogram ) {
+            text << string_format( "%5d", count );
+        }
+        text << "\n";
+    }
+
+    text << "\n" << _( "Counts per turn:" ) << "\n\n";
+    text << string_format( "%-14s %7s %7s %7s %10s", "", "last", "mean", "max", "total" ) << "\n";
+    for( int i = 0; i < NUM_COUNTERS; i++ ) {
+        const counter_stats stats = get_stats( static_cast<counter>( i ) );
+        text << string_format( "%-14s %7d %7.1f %7d %10lld", counter_name( static_cast<counter>( i ) ),
+                               stats.last, stats.mean, stats.max, stats.total ) << "\n";
+    }
+    popup( text.str(), PF_NONE );
+}
+
+} // namespace turn_profiler
@@ -0,0 +1,119 @@
+#ifndef TURN_PROFILER_H
+#define TURN_PROFILER_H
+
+#include "cursesdef.h" // For WINDOW
+
+#include <chrono>
+#include <string>
+
+/**
+ * Timing of the phases of @ref game::do_turn.
+ *
+ * Each phase is wrapped in a @ref scoped_timer, @ref end_turn then records the
+ * durations of the turn into a rolling window (and histogram) of the last turns
+ * and optionally appends them to a CSV trace file.
+ * Nothing is measured unless profiling was enabled, e.g. through the debug menu.
+ */
+namespace turn_profiler {
+    enum phase : int {
+        PHASE_EVENTS,
+        PHASE_SCENT,
+        PHASE_VEHMOVE,
+        PHASE_VEHICLE_POWER,
+        PHASE_FIELDS,
+        PHASE_ACTIVE_ITEMS,
+        PHASE_SOUNDS,
+        PHASE_MAP_CACHE,
+        PHASE_MONMOVE,
+        PHASE_STAIR_MONSTERS,
+        PHASE_MAP_EVICTION,
+        NUM_PHASES
+    };
+
+    /** Events counted per turn next to the phase durations. */
+    enum counter : int {
+        COUNTER_SIGHT_CACHE_HITS,
+        COUNTER_SIGHT_CACHE_MISSES,
+        // Monsters near enough to hear a sound cluster, and those of them that reacted to it
+        COUNTER_SOUND_LISTENERS_TESTED,
+        COUNTER_SOUND_LISTENERS_NOTIFIED,
+        // Tiles and portals closed by the searches of map::route, routes planned on the portal graph
+        COUNTER_ROUTE_EXPANSIONS,
+        COUNTER_PORTAL_ROUTES,
+        NUM_COUNTERS
+    };
+
+    // Number of turns kept for the statistics below
+    constexpr int WINDOW_TURNS = 256;
+    // Upper bounds (in milliseconds) of the histogram buckets, the last one is unbounded
+    constexpr int NUM_BUCKETS = 9;
+    constexpr double bucket_limits[NUM_BUCKETS - 1] = { 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0, 25.0 };
+
+    /** Adds the time between its construction and destruction to a phase of the current turn. */
+    class scoped_timer
+    {
+        public:
+            scoped_timer( phase p );
+            ~scoped_timer();
+
+            scoped_timer( const scoped_timer & ) = delete;
+            scoped_timer &operator=( const scoped_timer & ) = delete;
+
+        private:
+            phase p;
+            bool running;
+            std::chrono::steady_clock::time_point start;
+    };
+
+    /** Durations of a phase in milliseconds, over the window unless noted otherwise. */
+    struct phase_stats {
+        double last = 0.0;
+        double mean = 0.0;
+        double p95 = 0.0;
+        double max = 0.0;
+        // Since profiling was enabled
+        double total = 0.0;
+        int histogram[NUM_BUCKETS] = {};
+    };
+
+    /** Counts of an event per turn, over the window unless noted otherwise. */
+    struct counter_stats {
+        int last = 0;
+        double mean = 0.0;
+        int max = 0;
+        // Since profiling was enabled
+        long long total = 0;
+    };
+
+    const char *phase_name( phase p );
+    const char *counter_name( counter c );
+
+    /** Adds `n` to a counter of the current turn. May be called from any thread. */
+    void count( counter c, int n = 1 );
+
+    void set_enabled( bool enable );
+    bool is_enabled();
+    /** Clears all recorded durations. */
+    void reset();
+
+    /** Records the durations measured since the previous call as those of `turn`. */
+    void end_turn( int turn );
+    /** Number of turns recorded since profiling was enabled. */
+    int recorded_turns();
+    phase_stats get_stats( phase p );
+    counter_stats get_stats( counter c );
+
+    /** Starts appending one line per turn to the CSV file at `path`, enables profiling. */
+    bool start_trace( const std::string &path );
+    void stop_trace();
+    bool is_tracing();
+
+    // Table of the phase durations, drawn over the map by game::draw while enabled.
+    void set_overlay( bool show );
+    bool overlay_enabled();
+    void draw_overlay( WINDOW *w );
+    /** Popup with the statistics and histograms of all phases. */
+    void show_stats();
+}
+
+#endif
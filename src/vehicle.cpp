@@ -1927,6 +1927,8 @@ int vehicle::install_part( int dx, int dy, const vehicle_part &new_part )
     parts.back().mount.x = dx;
     parts.back().mount.y = dy;
     refresh();
+    // New obstacles block movement
+    g->m.set_pathfinding_cache_dirty( global_pos3() + parts.back().precalc[0] );
     return parts.size() - 1;
 }
 
@@ -5012,8 +5014,12 @@ int vehicle::damage_direct (int p, int dmg, int type)
         parts[p].hp -= dmg;
         if (parts[p].hp < 0)
             parts[p].hp = 0;
-        if (!parts[p].hp && last_hp > 0)
+        if (!parts[p].hp && last_hp > 0) {
             insides_dirty = true;
+            // Broken obstacles no longer block movement
+            g->m.set_pathfinding_cache_dirty( global_pos3() + parts[p].precalc[0] );
+            g->m.set_scent_cache_dirty( smz );
+        }
         if (part_flag(p, "FUEL_TANK"))
         {
             const itype_id &ft = part_info(p).fuel_type;
@@ -5805,6 +5811,8 @@ void vehicle::open_or_close(int const part_index, bool const opening)
     parts[part_index].open = opening ? 1 : 0;
     insides_dirty = true;
     g->m.set_transparency_cache_dirty( smz );
+    g->m.set_pathfinding_cache_dirty( global_pos3() + parts[part_index].precalc[0] );
+    g->m.set_scent_cache_dirty( smz );
 
     if (!part_info(part_index).has_flag("MULTISQUARE")) {
         return;
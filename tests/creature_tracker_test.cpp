@@ -0,0 +1,187 @@
+#define CATCH_CONFIG_MAIN
+#include "catch/catch.hpp"
+#include "test_game.h"
+
+#include "game.h"
+#include "map.h"
+#include "player.h"
+#include "monster.h"
+#include "monstergenerator.h"
+#include "monfaction.h"
+#include "creature_tracker.h"
+#include "line.h"
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+#include "stdio.h"
+
+// What Creature_tracker::monsters_within_radius should find, by looking at every monster
+static std::vector<int> brute_force_within_radius( const tripoint &p, const int radius )
+{
+    std::vector<int> result;
+    for( size_t i = 0; i < g->num_zombies(); i++ ) {
+        if( rl_dist( p, g->zombie( i ).pos3() ) <= radius ) {
+            result.push_back( i );
+        }
+    }
+    return result;
+}
+
+TEST_CASE("The grid of the creature tracker finds the same monsters as looking at all of them.") {
+    init_game();
+    g->clear_zombies();
+    g->u.setpos( tripoint( 60, 60, 0 ) );
+    Creature_tracker &tracker = *g->critter_tracker;
+
+    std::default_random_engine generator( 5 );
+    // Some of them outside of the reality bubble and on other z-levels
+    std::uniform_int_distribution<int> xy_distribution( -20, SEEX * MAPSIZE + 20 );
+    std::uniform_int_distribution<int> z_distribution( -2, 2 );
+    const auto random_point = [&]() {
+        return tripoint( xy_distribution( generator ), xy_distribution( generator ),
+                         z_distribution( generator ) );
+    };
+    const auto add_zombie = [&]() {
+        const tripoint p = random_point();
+        if( g->mon_at( p ) == -1 ) {
+            monster zombie( GetMType( "mon_zombie" ), p );
+            g->add_zombie( zombie );
+        }
+    };
+    for( int i = 0; i < 500; i++ ) {
+        add_zombie();
+    }
+
+    for( int step = 0; step < 50; step++ ) {
+        // Move some, remove some and add some
+        for( int i = 0; i < 20; i++ ) {
+            const tripoint p = random_point();
+            monster &zombie = g->zombie( i * 7 % g->num_zombies() );
+            if( g->mon_at( p ) == -1 && g->u.pos3() != p ) {
+                zombie.setpos( p );
+            }
+        }
+        g->remove_zombie( step * 3 % g->num_zombies() );
+        add_zombie();
+
+        const tripoint center = random_point();
+        const int radius = step % 30;
+        INFO( "center " << center.x << "," << center.y << "," << center.z << ", radius " << radius );
+        REQUIRE( tracker.monsters_within_radius( center, radius ) ==
+                 brute_force_within_radius( center, radius ) );
+
+        const tripoint min = center - tripoint( 10, 5, 1 );
+        const tripoint max = center + tripoint( 3, 20, 0 );
+        std::vector<int> expected;
+        for( size_t i = 0; i < g->num_zombies(); i++ ) {
+            const tripoint &p = g->zombie( i ).pos3();
+            if( p.x >= min.x && p.y >= min.y && p.z >= min.z && p.x <= max.x && p.y <= max.y &&
+                p.z <= max.z ) {
+                expected.push_back( i );
+            }
+        }
+        REQUIRE( tracker.monsters_in_rect( min, max ) == expected );
+    }
+
+    // The player (and NPCs) are part of the creature queries
+    const auto near_player = tracker.within_radius( g->u.pos3(), 2 );
+    CHECK( std::count( near_player.begin(), near_player.end(), &g->u ) == 1 );
+    CHECK( near_player.size() == brute_force_within_radius( g->u.pos3(), 2 ).size() + 1 );
+
+    const int iterations = 10000;
+    int found = 0;
+    const auto start1 = std::chrono::steady_clock::now();
+    for( int i = 0; i < iterations; i++ ) {
+        found += brute_force_within_radius( tripoint( 60, 60, 0 ), 12 ).size();
+    }
+    const auto end1 = std::chrono::steady_clock::now();
+    const auto start2 = std::chrono::steady_clock::now();
+    for( int i = 0; i < iterations; i++ ) {
+        found -= tracker.monsters_within_radius( tripoint( 60, 60, 0 ), 12 ).size();
+    }
+    const auto end2 = std::chrono::steady_clock::now();
+    CHECK( found == 0 );
+    printf( "Scanning %d monsters executed %d times in %f seconds.\n", int( g->num_zombies() ),
+            iterations, std::chrono::duration<double>( end1 - start1 ).count() );
+    printf( "Creature_tracker::monsters_within_radius() executed %d times in %f seconds.\n",
+            iterations, std::chrono::duration<double>( end2 - start2 ).count() );
+    g->clear_zombies();
+}
+
+TEST_CASE("The factions of the creature tracker follow added, removed and tamed monsters.") {
+    init_game();
+    g->clear_zombies();
+    Creature_tracker &tracker = *g->critter_tracker;
+
+    std::default_random_engine generator( 7 );
+    std::uniform_int_distribution<int> xy_distribution( 0, SEEX * MAPSIZE - 1 );
+    const char *types[] = { "mon_zombie", "mon_dog", "mon_ant", "mon_zombie_dog" };
+    for( int i = 0; i < 300; i++ ) {
+        const tripoint p( xy_distribution( generator ), xy_distribution( generator ), 0 );
+        if( g->mon_at( p ) == -1 ) {
+            monster critter( GetMType( types[i % 4] ), p );
+            g->add_zombie( critter );
+        }
+    }
+
+    const mfaction_id player_faction = mfaction_str_id( "player" );
+    for( int step = 0; step < 20; step++ ) {
+        g->remove_zombie( step * 11 % g->num_zombies() );
+        // Friendly monsters count as the faction of the player
+        g->zombie( step * 5 % g->num_zombies() ).friendly = step % 2 == 0 ? -1 : 0;
+        tracker.update_factions();
+
+        const tripoint center( xy_distribution( generator ), xy_distribution( generator ), 0 );
+        const int radius = 5 + step * 3;
+        for( const mfaction_id &faction : tracker.factions() ) {
+            std::vector<int> expected;
+            for( size_t i = 0; i < g->num_zombies(); i++ ) {
+                const monster &critter = g->zombie( i );
+                const mfaction_id f = critter.friendly != 0 ? player_faction : critter.faction;
+                if( f == faction && rl_dist( center, critter.pos3() ) <= radius ) {
+                    expected.push_back( i );
+                }
+            }
+            INFO( "faction " << faction.to_i() << ", radius " << radius );
+            REQUIRE( tracker.faction_members_within_radius( faction, center, radius ) == expected );
+        }
+    }
+
+    // Only factions with members are listed
+    for( const mfaction_id &faction : tracker.factions() ) {
+        CHECK( !tracker.faction_members_within_radius( faction, tripoint( 60, 60, 0 ), 200 ).empty() );
+    }
+    g->clear_zombies();
+    CHECK( tracker.factions().empty() );
+}
+
+TEST_CASE("The creature tracker knows where monsters moved since a plan was made.") {
+    init_game();
+    g->clear_zombies();
+    Creature_tracker &tracker = *g->critter_tracker;
+    const tripoint center( 60, 60, 0 );
+    const tripoint far( 10, 10, 0 );
+    monster zombie( GetMType( "mon_zombie" ), center + tripoint( 3, 0, 0 ) );
+    g->add_zombie( zombie );
+    monster dog( GetMType( "mon_dog" ), far );
+    g->add_zombie( dog );
+
+    const int since = tracker.change_count();
+    CHECK_FALSE( tracker.changed_within( center, 10, since ) );
+    // Moving far away doesn't matter
+    g->zombie( 1 ).setpos( far + tripoint( 1, 0, 0 ) );
+    CHECK_FALSE( tracker.changed_within( center, 10, since ) );
+    CHECK( tracker.changed_within( far, 10, since ) );
+    // Moving, arriving and leaving nearby do
+    g->zombie( 0 ).setpos( center + tripoint( 4, 0, 0 ) );
+    CHECK( tracker.changed_within( center, 10, since ) );
+    const int moved = tracker.change_count();
+    g->zombie( 1 ).setpos( center + tripoint( -2, 0, 0 ) );
+    CHECK( tracker.changed_within( center, 10, moved ) );
+    const int arrived = tracker.change_count();
+    g->remove_zombie( 0 );
+    CHECK( tracker.changed_within( center, 10, arrived ) );
+    g->clear_zombies();
+}
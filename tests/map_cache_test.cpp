@@ -0,0 +1,361 @@
+#define CATCH_CONFIG_MAIN
+#include "catch/catch.hpp"
+#include "test_game.h"
+
+#include "game.h"
+#include "map.h"
+#include "mapdata.h"
+#include "player.h"
+#include "field.h"
+#include "monster.h"
+#include "monstergenerator.h"
+#include "turn_profiler.h"
+#include "line.h"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <random>
+#include "stdio.h"
+
+static ter_id random_terrain( std::default_random_engine &generator )
+{
+    std::uniform_int_distribution<int> tile_distribution( 0, 9 );
+    const int roll = tile_distribution( generator );
+    return roll == 0 ? t_wall : ( roll < 4 ? t_floor : t_dirt );
+}
+
+static bool same_caches( const level_cache &a, const level_cache &b )
+{
+    return std::equal( &a.transparency_cache[0][0], &a.transparency_cache[0][0] + SEEX * MAPSIZE * SEEY * MAPSIZE,
+                       &b.transparency_cache[0][0] ) &&
+           std::equal( &a.outside_cache[0][0], &a.outside_cache[0][0] + SEEX * MAPSIZE * SEEY * MAPSIZE,
+                       &b.outside_cache[0][0] );
+}
+
+TEST_CASE("Rebuilding the dirty submaps gives the same caches as rebuilding everything.") {
+    init_game();
+    map &m = g->m;
+    std::default_random_engine generator( 11 );
+    for( int x = 0; x < SEEX * MAPSIZE; x++ ) {
+        for( int y = 0; y < SEEY * MAPSIZE; y++ ) {
+            m.furn_set( tripoint( x, y, 0 ), f_null );
+            m.ter_set( tripoint( x, y, 0 ), random_terrain( generator ) );
+        }
+    }
+    m.build_map_cache( 0 );
+
+    std::uniform_int_distribution<int> position_distribution( 0, SEEX * MAPSIZE - 1 );
+    static level_cache incremental;
+    for( int step = 0; step < 20; step++ ) {
+        // A few changes, some of them at the edges of submaps and the map
+        for( int i = 0; i < 5; i++ ) {
+            const tripoint p( position_distribution( generator ), position_distribution( generator ), 0 );
+            m.ter_set( p, random_terrain( generator ) );
+        }
+        m.ter_set( tripoint( SEEX * ( step % MAPSIZE ), SEEY * 3 - 1, 0 ), random_terrain( generator ) );
+        m.ter_set( tripoint( 0, step, 0 ), random_terrain( generator ) );
+        const tripoint smoke( position_distribution( generator ), position_distribution( generator ), 0 );
+        m.add_field( smoke, fd_smoke, 3, 0 );
+        if( step % 2 == 0 ) {
+            m.remove_field( smoke, fd_smoke );
+        }
+
+        m.build_map_cache( 0 );
+        incremental = m.access_cache( 0 );
+
+        m.set_transparency_cache_dirty( 0 );
+        m.set_outside_cache_dirty( 0 );
+        m.build_map_cache( 0 );
+        REQUIRE( same_caches( incremental, m.access_cache( 0 ) ) );
+    }
+
+    // Only the submaps of the changed squares get dirty
+    m.build_map_cache( 0 );
+    const level_cache &ch = m.access_cache( 0 );
+    REQUIRE( ch.transparency_dirty_submaps.none() );
+    REQUIRE( ch.outside_dirty_submaps.none() );
+    int reader = 0;
+    m.transparency_changes( 0, reader );
+    m.ter_set( tripoint( SEEX * 2 + 3, SEEY * 5 + 4, 0 ), t_wall );
+    CHECK( ch.transparency_dirty_submaps.count() == 1 );
+    CHECK( ch.transparency_dirty_submaps[2 * MAPSIZE + 5] );
+    CHECK( ch.outside_dirty_submaps.count() == 1 );
+    // The neighbors of a square in the corner of a submap are in three other submaps
+    m.ter_set( tripoint( SEEX * 2, SEEY * 5, 0 ), t_wall );
+    CHECK( ch.transparency_dirty_submaps.count() == 1 );
+    CHECK( ch.outside_dirty_submaps.count() == 4 );
+    CHECK( ch.outside_dirty_submaps[1 * MAPSIZE + 4] );
+
+    // The lightmap only looks at the submaps that were rebuilt, reading them leaves them
+    // to the other readers
+    m.build_map_cache( 0 );
+    CHECK( ch.transparency_dirty_submaps.none() );
+    CHECK( ch.light_transparency_generation == ch.transparency_generation );
+    const auto changes = m.transparency_changes( 0, reader );
+    CHECK( changes.count() == 1 );
+    CHECK( changes[2 * MAPSIZE + 5] );
+    CHECK( m.transparency_changes( 0, reader ).none() );
+}
+
+TEST_CASE("Batched line of sight checks match the Bresenham lines.") {
+    init_game();
+    map &m = g->m;
+    std::default_random_engine generator( 13 );
+    for( int x = 0; x < SEEX * MAPSIZE; x++ ) {
+        for( int y = 0; y < SEEY * MAPSIZE; y++ ) {
+            m.furn_set( tripoint( x, y, 0 ), f_null );
+            m.ter_set( tripoint( x, y, 0 ), random_terrain( generator ) );
+        }
+    }
+    // A closed building, the batch doesn't trace lines into it
+    for( int x = 30; x <= 45; x++ ) {
+        for( int y = 55; y <= 70; y++ ) {
+            const bool wall = x == 30 || x == 45 || y == 55 || y == 70;
+            m.ter_set( tripoint( x, y, 0 ), wall ? t_wall : t_floor );
+        }
+    }
+    g->u.setpos( tripoint( 60, 60, 0 ) );
+    m.build_map_cache( 0 );
+
+    const int range = 30;
+    std::vector<tripoint> targets;
+    for( int x = -range - 2; x <= range + 2; x++ ) {
+        for( int y = -range - 2; y <= range + 2; y++ ) {
+            targets.emplace_back( x, y, 0 );
+        }
+    }
+
+    // Inside and outside the building, near the edges of the map
+    const tripoint origins[] = { tripoint( 60, 60, 0 ), tripoint( 40, 60, 0 ), tripoint( 20, 70, 0 ),
+                                 tripoint( 2, 2, 0 ), tripoint( 120, 40, 0 )
+                               };
+    for( const tripoint &origin : origins ) {
+        std::vector<tripoint> shifted;
+        for( const tripoint &t : targets ) {
+            const tripoint p = origin + t;
+            if( m.inbounds( p ) ) {
+                shifted.push_back( p );
+            }
+        }
+        std::vector<bool> seen;
+        std::vector<int> slopes;
+        m.sees( origin, shifted, range, seen, &slopes );
+        REQUIRE( seen.size() == shifted.size() );
+        REQUIRE( slopes.size() == shifted.size() );
+
+        int mismatches = 0;
+        for( size_t i = 0; i < shifted.size(); i++ ) {
+            const tripoint &p = shifted[i];
+            int t1 = 0;
+            int t2 = 0;
+            const bool expected = m.sees( origin, p, range, t1, t2 );
+            if( seen[i] != expected || slopes[i] != t1 ) {
+                INFO( "origin " << origin.x << "," << origin.y << ", target " << p.x << "," << p.y );
+                CHECK( seen[i] == expected );
+                CHECK( slopes[i] == t1 );
+                mismatches++;
+            }
+        }
+        CHECK( mismatches == 0 );
+    }
+
+    const tripoint origin( 50, 70, 0 );
+    std::vector<tripoint> shifted;
+    for( const tripoint &t : targets ) {
+        shifted.push_back( origin + t );
+    }
+    const int iterations = 200;
+    int seen_single = 0;
+    const auto start1 = std::chrono::steady_clock::now();
+    for( int i = 0; i < iterations; i++ ) {
+        for( const tripoint &p : shifted ) {
+            seen_single += m.sees( origin, p, range );
+        }
+    }
+    const auto end1 = std::chrono::steady_clock::now();
+    std::vector<bool> seen;
+    const auto start2 = std::chrono::steady_clock::now();
+    for( int i = 0; i < iterations; i++ ) {
+        m.sees( origin, shifted, range, seen );
+    }
+    const auto end2 = std::chrono::steady_clock::now();
+    printf( "%d single map::sees() calls (%d seen) executed %d times in %f seconds.\n",
+            int( shifted.size() ), seen_single / iterations, iterations,
+            std::chrono::duration<double>( end1 - start1 ).count() );
+    printf( "Batched map::sees() for as many targets executed %d times in %f seconds.\n",
+            iterations, std::chrono::duration<double>( end2 - start2 ).count() );
+}
+
+TEST_CASE("Line of sight checks between creatures are remembered until something changes.") {
+    init_game();
+    map &m = g->m;
+    for( int x = 40; x < 80; x++ ) {
+        for( int y = 40; y < 80; y++ ) {
+            m.furn_set( tripoint( x, y, 0 ), f_null );
+            m.ter_set( tripoint( x, y, 0 ), t_floor );
+        }
+    }
+    g->u.setpos( tripoint( 60, 60, 0 ) );
+    m.build_map_cache( 0 );
+    monster zombie( GetMType( "mon_zombie" ), tripoint( 65, 60, 0 ) );
+    turn_profiler::set_enabled( true );
+
+    const bool seen = zombie.sees( g->u );
+    CHECK( zombie.sees( g->u ) == seen );
+    CHECK( zombie.sees( g->u ) == seen );
+    // The key includes the positions (the zombie isn't tracked by the game, so skip updating that)
+    zombie.setpos( tripoint( 66, 60, 0 ), true );
+    zombie.sees( g->u );
+    // Rebuilding the map caches forgets everything
+    for( int y = 40; y < 80; y++ ) {
+        m.ter_set( tripoint( 63, y, 0 ), t_wall );
+    }
+    m.build_map_cache( 0 );
+    CHECK_FALSE( zombie.sees( g->u ) );
+
+    turn_profiler::end_turn( 0 );
+    CHECK( turn_profiler::get_stats( turn_profiler::COUNTER_SIGHT_CACHE_HITS ).last == 2 );
+    CHECK( turn_profiler::get_stats( turn_profiler::COUNTER_SIGHT_CACHE_MISSES ).last == 3 );
+    turn_profiler::set_enabled( false );
+}
+
+static std::vector<float> lightmap_of( const level_cache &ch )
+{
+    std::vector<float> light( &ch.lm[0][0], &ch.lm[0][0] + SEEX * MAPSIZE * SEEY * MAPSIZE );
+    light.insert( light.end(), &ch.sm[0][0], &ch.sm[0][0] + SEEX * MAPSIZE * SEEY * MAPSIZE );
+    return light;
+}
+
+TEST_CASE("The lightmap from cached light sources matches casting every light again.") {
+    init_game();
+    map &m = g->m;
+    std::default_random_engine generator( 5 );
+    for( int x = 0; x < SEEX * MAPSIZE; x++ ) {
+        for( int y = 0; y < SEEY * MAPSIZE; y++ ) {
+            m.furn_set( tripoint( x, y, 0 ), f_null );
+            m.ter_set( tripoint( x, y, 0 ), random_terrain( generator ) );
+        }
+    }
+    const tripoint lamp( 30, 40, 0 );
+    const tripoint fire( 70, 70, 0 );
+    m.ter_set( lamp, t_utility_light );
+    m.build_map_cache( 0 );
+
+    level_cache &ch = m.access_cache( 0 );
+    const std::function<void()> changes[] = {
+        [&]() { m.add_field( fire, fd_fire, 3, 0 ); },
+        [&]() { m.ter_set( fire + tripoint( 2, 0, 0 ), t_wall ); },
+        [&]() { m.ter_set( lamp, t_floor ); m.ter_set( lamp + tripoint( 5, 3, 0 ), t_utility_light ); },
+        [&]() { m.ter_set( fire + tripoint( 2, 0, 0 ), t_floor ); },
+        [&]() { m.add_field( fire + tripoint( 0, 1, 0 ), fd_fire, 1, 0 ); },
+        [&]() { m.remove_field( fire, fd_fire ); },
+        [&]() { m.ter_set( lamp + tripoint( 5, 3, 0 ), t_floor ); },
+    };
+    for( const auto &change : changes ) {
+        change();
+        m.build_map_cache( 0 );
+        const size_t cached_lights = ch.light_cache.size();
+        const std::vector<float> cached = lightmap_of( ch );
+
+        ch.light_cache.clear();
+        m.build_map_cache( 0 );
+        CHECK( ch.light_cache.size() == cached_lights );
+        CHECK( cached == lightmap_of( ch ) );
+    }
+}
+
+// Traces the first lines, then casts a field of view over the daylight range and only traces
+// the lines of the squares it reaches. Creatures don't check their targets like this, single
+// lines are faster at the target counts of a turn (see the benchmark below).
+static int batched_sees( const map &m, const tripoint &origin, const std::vector<tripoint> &targets,
+                         const int range, const int fov_range )
+{
+    static const int min_lines = 8;
+    int seen = 0;
+    int t1 = 0;
+    int t2 = 0;
+    std::unique_ptr<field_of_view> fov;
+    for( size_t i = 0; i < targets.size(); i++ ) {
+        if( int( i ) < min_lines ) {
+            seen += m.sees( origin, targets[i], range, t1, t2 );
+            continue;
+        }
+        if( fov == nullptr ) {
+            fov.reset( new field_of_view() );
+            m.build_field_of_view( origin, fov_range, *fov );
+        }
+        seen += fov->sees( targets[i], range, t1, t2 );
+    }
+    return seen;
+}
+
+TEST_CASE("Benchmark of batched line of sight checks at the target counts of a turn.") {
+    init_game();
+    map &m = g->m;
+    std::default_random_engine generator( 17 );
+    for( int x = 0; x < SEEX * MAPSIZE; x++ ) {
+        for( int y = 0; y < SEEY * MAPSIZE; y++ ) {
+            m.furn_set( tripoint( x, y, 0 ), f_null );
+            m.ter_set( tripoint( x, y, 0 ), random_terrain( generator ) );
+        }
+    }
+    // A town: closed buildings on a grid of streets
+    for( int bx = 8; bx + 14 < SEEX * MAPSIZE; bx += 24 ) {
+        for( int by = 8; by + 14 < SEEY * MAPSIZE; by += 24 ) {
+            for( int x = bx; x <= bx + 14; x++ ) {
+                for( int y = by; y <= by + 14; y++ ) {
+                    const bool wall = x == bx || x == bx + 14 || y == by || y == by + 14;
+                    m.ter_set( tripoint( x, y, 0 ), wall ? t_wall : t_floor );
+                }
+            }
+        }
+    }
+    g->u.setpos( tripoint( 66, 66, 0 ) );
+    m.build_map_cache( 0 );
+
+    const int range = 30;
+    // The daylight sight range of the player and of most monsters
+    const int fov_range = 60;
+    std::uniform_int_distribution<int> offset( -range, range );
+    std::uniform_int_distribution<int> coordinate( 0, SEEX * MAPSIZE - 1 );
+    const int observers = 200;
+    for( const int count : { 5, 10, 20, 50 } ) {
+        std::vector<tripoint> origins;
+        std::vector<std::vector<tripoint>> targets;
+        while( int( origins.size() ) < observers ) {
+            const tripoint origin( coordinate( generator ), coordinate( generator ), 0 );
+            std::vector<tripoint> these;
+            while( int( these.size() ) < count ) {
+                const tripoint p = origin + tripoint( offset( generator ), offset( generator ), 0 );
+                if( m.inbounds( p ) ) {
+                    these.push_back( p );
+                }
+            }
+            origins.push_back( origin );
+            targets.push_back( these );
+        }
+
+        int seen_single = 0;
+        int t1 = 0;
+        int t2 = 0;
+        const auto start1 = std::chrono::steady_clock::now();
+        for( int i = 0; i < observers; i++ ) {
+            for( const tripoint &p : targets[i] ) {
+                seen_single += m.sees( origins[i], p, range, t1, t2 );
+            }
+        }
+        const auto end1 = std::chrono::steady_clock::now();
+        int seen_batched = 0;
+        const auto start2 = std::chrono::steady_clock::now();
+        for( int i = 0; i < observers; i++ ) {
+            seen_batched += batched_sees( m, origins[i], targets[i], range, fov_range );
+        }
+        const auto end2 = std::chrono::steady_clock::now();
+        CHECK( seen_single == seen_batched );
+        printf( "%d observers checking %d targets each: %f seconds single, %f seconds batched.\n",
+                observers, count, std::chrono::duration<double>( end1 - start1 ).count(),
+                std::chrono::duration<double>( end2 - start2 ).count() );
+    }
+}
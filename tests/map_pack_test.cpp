@@ -0,0 +1,117 @@
+#define CATCH_CONFIG_MAIN
+#include "catch/catch.hpp"
+
+#include "filesystem.h"
+#include "map_pack.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+static std::string read_file( const std::string &path )
+{
+    std::ifstream fin( path.c_str(), std::ios_base::in | std::ios_base::binary );
+    std::ostringstream data;
+    data << fin.rdbuf();
+    return data.str();
+}
+
+static void write_file( const std::string &path, const std::string &data )
+{
+    std::ofstream fout( path.c_str(), std::ios_base::out | std::ios_base::trunc | std::ios_base::binary );
+    fout << data;
+}
+
+static std::string quad_data( const std::string &path, const tripoint &om_addr )
+{
+    const map_pack pack( path );
+    const char *data = nullptr;
+    size_t size = 0;
+    if( !pack.find( om_addr, data, size ) ) {
+        return "missing";
+    }
+    return std::string( data, size );
+}
+
+TEST_CASE("Map packs return the last data written for each quad.") {
+    const std::string dir = "map_pack_test_files";
+    REQUIRE( assure_dir_exist( dir ) );
+    const std::string path = dir + "/0.0.0.pack";
+    remove_file( path );
+
+    CHECK( quad_data( path, tripoint( 1, 2, 0 ) ) == "missing" );
+    REQUIRE( map_pack::write( path, { { tripoint( 1, 2, 0 ), "first" }, { tripoint( -3, 4, -1 ), "second" } } ) );
+    REQUIRE( map_pack::write( path, { { tripoint( 1, 2, 0 ), "third" }, { tripoint( 5, 6, 0 ), "" } } ) );
+    CHECK( quad_data( path, tripoint( 1, 2, 0 ) ) == "third" );
+    CHECK( quad_data( path, tripoint( -3, 4, -1 ) ) == "second" );
+    CHECK( quad_data( path, tripoint( 5, 6, 0 ) ) == "" );
+    CHECK( quad_data( path, tripoint( 1, 2, 1 ) ) == "missing" );
+    CHECK( map_pack( path ).quads().size() == 3 );
+
+    SECTION("garbage is compacted") {
+        const std::string big( 10000, 'x' );
+        for( int i = 0; i < 100; i++ ) {
+            REQUIRE( map_pack::write( path, { { tripoint( 1, 2, 0 ), big + std::to_string( i ) } } ) );
+        }
+        CHECK( quad_data( path, tripoint( 1, 2, 0 ) ) == big + "99" );
+        CHECK( quad_data( path, tripoint( -3, 4, -1 ) ) == "second" );
+        // At most the limit of garbage besides the current data
+        CHECK( read_file( path ).size() < 100000 );
+    }
+    SECTION("a write that was cut short loses only the quads it wrote") {
+        const std::string old_data = read_file( path );
+        REQUIRE( map_pack::write( path, { { tripoint( 1, 2, 0 ), "fourth" }, { tripoint( 7, 7, 0 ), "fifth" } } ) );
+        const std::string new_data = read_file( path );
+        for( size_t cut = old_data.size() + 1; cut < new_data.size(); cut += 7 ) {
+            INFO( "cut at " << cut );
+            write_file( path, new_data.substr( 0, cut ) );
+            CHECK( quad_data( path, tripoint( -3, 4, -1 ) ) == "second" );
+            const std::string quad = quad_data( path, tripoint( 1, 2, 0 ) );
+            CHECK( ( quad == "third" || quad == "fourth" ) );
+        }
+        // The next write repairs the pack
+        REQUIRE( map_pack::write( path, { { tripoint( 8, 8, 0 ), "sixth" } } ) );
+        CHECK( quad_data( path, tripoint( -3, 4, -1 ) ) == "second" );
+        CHECK( quad_data( path, tripoint( 8, 8, 0 ) ) == "sixth" );
+        REQUIRE( map_pack::write( path, { { tripoint( 9, 9, 0 ), "seventh" } } ) );
+        CHECK( quad_data( path, tripoint( 8, 8, 0 ) ) == "sixth" );
+    }
+    SECTION("damaged data is detected") {
+        std::string data = read_file( path );
+        const size_t pos = data.find( "second" );
+        REQUIRE( pos != std::string::npos );
+        data[pos] = 'S';
+        write_file( path, data );
+        CHECK_THROWS_AS( quad_data( path, tripoint( -3, 4, -1 ) ), std::string );
+        CHECK( quad_data( path, tripoint( 1, 2, 0 ) ) == "third" );
+    }
+
+    remove_file( path );
+    remove( dir.c_str() );
+}
+
+TEST_CASE("Quad files of older versions are moved into map packs.") {
+    const std::string dir = "map_pack_test_files";
+    const std::string segment_dir = dir + "/-1.0.0";
+    REQUIRE( assure_dir_exist( dir ) );
+    REQUIRE( assure_dir_exist( segment_dir ) );
+    const std::string path = map_pack::path( dir, tripoint( -1, 0, 0 ) );
+    remove_file( path );
+
+    // The pack has a newer version of one of the quads
+    REQUIRE( map_pack::write( path, { { tripoint( -5, 3, 0 ), "newer" } } ) );
+    write_file( segment_dir + "/-5.3.0.map", "older" );
+    write_file( segment_dir + "/-6.3.0.map", "{ \"json\" }" );
+    write_file( segment_dir + "/-6.4.0.map", std::string( "binary\0data", 11 ) );
+    CHECK( map_pack::migrate( dir ) == 2 );
+    CHECK( quad_data( path, tripoint( -5, 3, 0 ) ) == "newer" );
+    CHECK( quad_data( path, tripoint( -6, 3, 0 ) ) == "{ \"json\" }" );
+    CHECK( quad_data( path, tripoint( -6, 4, 0 ) ) == std::string( "binary\0data", 11 ) );
+    CHECK_FALSE( file_exist( segment_dir + "/-6.3.0.map" ) );
+    CHECK_FALSE( file_exist( segment_dir ) );
+    CHECK( map_pack::migrate( dir ) == 0 );
+
+    remove_file( path );
+    remove( dir.c_str() );
+}
@@ -0,0 +1,202 @@
+#define CATCH_CONFIG_MAIN
+#include "catch/catch.hpp"
+#include "test_game.h"
+
+#include "game.h"
+#include "map.h"
+#include "filesystem.h"
+#include "mapbuffer.h"
+#include "mapdata.h"
+#include "mapsharing.h"
+#include "map_pack.h"
+#include "overmapbuffer.h"
+#include "player.h"
+#include "save_worker.h"
+#include "vehicle.h"
+#include "worldfactory.h"
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+#include "stdio.h"
+
+// Checks the buffer without loading the submap like lookup_submap would
+static bool is_buffered( const tripoint &p )
+{
+    for( auto &elem : MAPBUFFER ) {
+        if( elem.first == p ) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Adds a quad far from the map, with its number as the terrain of a square to recognize it
+static void add_far_quad( const tripoint &sm_addr, int number )
+{
+    for( int i = 0; i < 4; i++ ) {
+        submap *sm = new submap();
+        sm->ter[1][2] = ter_id( number );
+        REQUIRE( MAPBUFFER.add_submap( sm_addr + tripoint( i / 2, i % 2, 0 ), sm ) );
+    }
+}
+
+TEST_CASE("The map buffer evicts the least recently used quads far from the map.") {
+    init_game();
+    const size_t unlimited = std::numeric_limits<size_t>::max() / 2;
+    const tripoint abs_sub = g->m.get_abs_sub();
+    // Quad aligned, beyond the margin around the map
+    const tripoint far( abs_sub.x / 2 * 2 + 2 * MAPSIZE, abs_sub.y / 2 * 2, abs_sub.z );
+    const int group_size = 30;
+    const auto quad_addr = [&far]( int group, int n ) {
+        return far + tripoint( 2 * n, 2 * group, 0 );
+    };
+
+    // Each group is used later than the previous one
+    for( int group = 0; group < 4; group++ ) {
+        for( int n = 0; n < group_size; n++ ) {
+            add_far_quad( quad_addr( group, n ), group * group_size + n );
+        }
+        MAPBUFFER.evict( g->m, unlimited );
+    }
+    // Group 0 is used again, group 1 is the least recently used now
+    for( int n = 0; n < group_size; n++ ) {
+        REQUIRE( MAPBUFFER.lookup_submap( quad_addr( 0, n ) ) != nullptr );
+    }
+    std::vector<tripoint> eviction_order;
+    for( const int group : { 1, 2, 3, 0 } ) {
+        for( int n = 0; n < group_size; n++ ) {
+            eviction_order.push_back( quad_addr( group, n ) );
+        }
+    }
+
+    // A quad with a vehicle that runs its engine off the map
+    const tripoint vehicle_quad = quad_addr( 4, 0 );
+    add_far_quad( vehicle_quad, 0 );
+    vehicle *veh = new vehicle( vproto_id( "bicycle" ) );
+    veh->engine_on = true;
+    MAPBUFFER.lookup_submap( vehicle_quad )->vehicles.push_back( veh );
+    MAPBUFFER.evict( g->m, unlimited );
+
+    const mapbuffer::memory_stats before = MAPBUFFER.get_memory_stats();
+    CHECK( before.submaps >= size_t( MAPSIZE * MAPSIZE + 4 * ( 4 * group_size + 1 ) ) );
+
+    // Down to 3/4 of the budget, oldest first
+    const size_t budget = before.bytes - 1;
+    MAPBUFFER.evict( g->m, budget );
+    const mapbuffer::memory_stats after = MAPBUFFER.get_memory_stats();
+    CHECK( after.bytes <= budget / 4 * 3 );
+    const size_t evicted = after.evicted_quads - before.evicted_quads;
+    CHECK( after.quads == before.quads - evicted );
+    REQUIRE( evicted > 0 );
+    REQUIRE( evicted < eviction_order.size() );
+    for( size_t i = 0; i < eviction_order.size(); i++ ) {
+        INFO( "quad " << i << " in eviction order" );
+        CHECK( is_buffered( eviction_order[i] ) == ( i >= evicted ) );
+    }
+    // Nothing more until the buffer grows
+    MAPBUFFER.evict( g->m, budget );
+    CHECK( MAPBUFFER.get_memory_stats().evicted_quads == after.evicted_quads );
+
+    // Never the map or vehicles that run
+    std::vector<submap *> grid;
+    for( int x = 0; x < MAPSIZE; x++ ) {
+        for( int y = 0; y < MAPSIZE; y++ ) {
+            grid.push_back( MAPBUFFER.lookup_submap( abs_sub + tripoint( x, y, 0 ) ) );
+        }
+    }
+    MAPBUFFER.evict( g->m, 1 );
+    for( auto &p : eviction_order ) {
+        CHECK_FALSE( is_buffered( p ) );
+    }
+    CHECK( is_buffered( vehicle_quad ) );
+    size_t i = 0;
+    for( int x = 0; x < MAPSIZE; x++ ) {
+        for( int y = 0; y < MAPSIZE; y++ ) {
+            CHECK( MAPBUFFER.lookup_submap( abs_sub + tripoint( x, y, 0 ) ) == grid[i++] );
+        }
+    }
+
+    // Evicted quads are loaded again as they were
+    for( int group = 0; group < 4; group++ ) {
+        for( int n = 0; n < group_size; n++ ) {
+            submap *sm = MAPBUFFER.lookup_submap( quad_addr( group, n ) + tripoint( 1, 1, 0 ) );
+            REQUIRE( sm != nullptr );
+            CHECK( sm->ter[1][2] == ter_id( group * group_size + n ) );
+            CHECK_FALSE( sm->dirty );
+        }
+    }
+}
+
+TEST_CASE("Evicted quads that fail to be written are kept in the buffer.") {
+    init_game();
+    const tripoint abs_sub = g->m.get_abs_sub();
+    // In a segment of its own, far from the other quads
+    const tripoint far( abs_sub.x / 2 * 2 + 300, abs_sub.y / 2 * 2, abs_sub.z );
+    add_far_quad( far, 77 );
+    for( int i = 0; i < 4; i++ ) {
+        MAPBUFFER.lookup_submap( far + tripoint( i / 2, i % 2, 0 ) )->dirty = true;
+    }
+    const std::string map_directory = world_generator->active_world->world_path + "/maps";
+    REQUIRE( assure_dir_exist( map_directory ) );
+    const std::string pack_path = map_pack::path( map_directory,
+                                  overmapbuffer::omt_to_seg_copy( overmapbuffer::sm_to_omt_copy( far ) ) );
+
+#ifdef __linux__
+    // Another game writes the pack
+    const std::string lock_path = pack_path + ".lock";
+    const int lock = getLock( lock_path.c_str() );
+    REQUIRE( lock != -1 );
+    MAPBUFFER.evict( g->m, 1 );
+    CHECK_FALSE( is_buffered( far ) );
+    CHECK_FALSE( save_worker::instance().wait() );
+    releaseLock( lock, lock_path.c_str() );
+    for( int i = 0; i < 4; i++ ) {
+        REQUIRE( is_buffered( far + tripoint( i / 2, i % 2, 0 ) ) );
+        submap *sm = MAPBUFFER.lookup_submap( far + tripoint( i / 2, i % 2, 0 ) );
+        CHECK( sm->ter[1][2] == ter_id( 77 ) );
+        CHECK( sm->dirty );
+    }
+    // Not written again right away
+    MAPBUFFER.evict( g->m, 1 );
+    CHECK( is_buffered( far ) );
+    calendar::turn += 100;
+#endif
+
+    // Written by the next eviction
+    MAPBUFFER.evict( g->m, 1 );
+    CHECK_FALSE( is_buffered( far ) );
+    CHECK( save_worker::instance().wait() );
+    submap *sm = MAPBUFFER.lookup_submap( far );
+    REQUIRE( sm != nullptr );
+    CHECK( sm->ter[1][2] == ter_id( 77 ) );
+    CHECK_FALSE( sm->dirty );
+}
+
+TEST_CASE("Reading the items of a square leaves its submap clean.") {
+    init_game();
+    const tripoint p( 5 * SEEX + 3, 5 * SEEY + 4, g->m.get_abs_sub().z );
+    g->m.i_clear( p );
+    g->m.add_item( p, item( "rock", 0 ) );
+    g->m.add_item( p, item( "stick", 0 ) );
+    submap *sm = MAPBUFFER.lookup_submap( g->m.get_abs_sub() + tripoint( 5, 5, 0 ) );
+    REQUIRE( sm != nullptr );
+    REQUIRE( sm->dirty );
+
+    sm->dirty = false;
+    const map_stack items = g->m.i_at( p );
+    int volume = 0;
+    for( const item &it : items ) {
+        volume += it.volume();
+    }
+    CHECK( volume == g->m.stored_volume( p ) );
+    CHECK( items.front().typeId() == "rock" );
+    CHECK( items[1].typeId() == "stick" );
+    CHECK_FALSE( sm->dirty );
+
+    g->m.i_at( p ).front().charges = 3;
+    CHECK( sm->dirty );
+    sm->dirty = false;
+    g->m.i_rem( p, 0 );
+    CHECK( sm->dirty );
+}
@@ -0,0 +1,142 @@
+#define CATCH_CONFIG_MAIN
+#include "catch/catch.hpp"
+#include "test_game.h"
+
+#include "game.h"
+#include "player.h"
+#include "monster.h"
+#include "monstergenerator.h"
+#include "mtype.h"
+
+#include <chrono>
+#include <random>
+#include <set>
+#include <vector>
+#include "stdio.h"
+
+TEST_CASE("The bitsets of monster types match their flags, triggers and species.") {
+    init_game( false );
+    std::set<std::string> all_species;
+    for( const auto &type : MonsterGenerator::generator().get_all_mtypes() ) {
+        all_species.insert( type.second->species.begin(), type.second->species.end() );
+    }
+    all_species.insert( "NOT_A_SPECIES" );
+
+    for( const auto &elem : MonsterGenerator::generator().get_all_mtypes() ) {
+        const mtype &type = *elem.second;
+        INFO( type.id );
+        for( int f = 0; f < MF_MAX; f++ ) {
+            CHECK( type.has_flag( m_flag( f ) ) == ( type.flags.count( m_flag( f ) ) > 0 ) );
+        }
+        for( int t = 0; t < N_MONSTER_TRIGGERS; t++ ) {
+            const monster_trigger trig = monster_trigger( t );
+            CHECK( type.has_anger_trigger( trig ) == ( type.anger.count( trig ) > 0 ) );
+            CHECK( type.has_fear_trigger( trig ) == ( type.fear.count( trig ) > 0 ) );
+            CHECK( type.has_placate_trigger( trig ) == ( type.placate.count( trig ) > 0 ) );
+        }
+        for( const std::string &species : all_species ) {
+            CHECK( type.in_species( species ) == ( type.species.count( species ) > 0 ) );
+        }
+        CHECK( type.in_species( species_zombie ) == ( type.species.count( "ZOMBIE" ) > 0 ) );
+        const mtype &zombie = *GetMType( "mon_zombie" );
+        bool shared = false;
+        for( const std::string &species : type.species ) {
+            shared = shared || zombie.species.count( species ) > 0;
+        }
+        CHECK( type.same_species( zombie ) == shared );
+    }
+}
+
+TEST_CASE("Benchmark of the flag, trigger and species checks of a horde.") {
+    init_game( false );
+    // A synthetic horde of all kinds of monsters
+    const std::vector<std::string> ids = MonsterGenerator::generator().get_all_mtype_ids();
+    std::default_random_engine generator( 3 );
+    std::uniform_int_distribution<size_t> type_distribution( 0, ids.size() - 1 );
+    std::vector<monster> horde;
+    for( int i = 0; i < 2000; i++ ) {
+        horde.emplace_back( GetMType( ids[type_distribution( generator )] ) );
+    }
+
+    // The checks of sounds, movement and planning for each of them
+    const m_flag flags[] = { MF_HEARS, MF_GOODHEARING, MF_FLIES, MF_DIGS, MF_AQUATIC, MF_SWIMS,
+                             MF_CLIMBS, MF_ELECTRONIC, MF_SWARMS, MF_GROUP_MORALE
+                           };
+    const monster_trigger triggers[] = { MTRIG_HOSTILE_CLOSE, MTRIG_HOSTILE_WEAK, MTRIG_SOUND };
+    const int iterations = 100;
+
+    int found_sets = 0;
+    const auto start1 = std::chrono::steady_clock::now();
+    for( int i = 0; i < iterations; i++ ) {
+        for( const monster &critter : horde ) {
+            for( const m_flag f : flags ) {
+                found_sets += critter.type->flags.count( f );
+            }
+            for( const monster_trigger t : triggers ) {
+                found_sets += critter.type->anger.count( t ) + critter.type->fear.count( t );
+            }
+            found_sets += critter.type->species.count( "ZOMBIE" );
+        }
+    }
+    const auto end1 = std::chrono::steady_clock::now();
+
+    int found_bits = 0;
+    const int zombie = MonsterGenerator::generator().species_short_id( "ZOMBIE" );
+    const auto start2 = std::chrono::steady_clock::now();
+    for( int i = 0; i < iterations; i++ ) {
+        for( const monster &critter : horde ) {
+            for( const m_flag f : flags ) {
+                found_bits += critter.has_flag( f );
+            }
+            for( const monster_trigger t : triggers ) {
+                found_bits += critter.type->has_anger_trigger( t ) + critter.type->has_fear_trigger( t );
+            }
+            found_bits += critter.type->in_species( zombie );
+        }
+    }
+    const auto end2 = std::chrono::steady_clock::now();
+
+    // The species checks alone: the std::set of the old implementation, the string version that
+    // looks up the id on every call and the id the code resolves at load time
+    int found_species_sets = 0;
+    const auto start3 = std::chrono::steady_clock::now();
+    for( int i = 0; i < iterations; i++ ) {
+        for( const monster &critter : horde ) {
+            found_species_sets += critter.type->species.count( "ZOMBIE" );
+        }
+    }
+    const auto end3 = std::chrono::steady_clock::now();
+
+    int found_species_strings = 0;
+    const auto start4 = std::chrono::steady_clock::now();
+    for( int i = 0; i < iterations; i++ ) {
+        for( const monster &critter : horde ) {
+            found_species_strings += critter.type->in_species( "ZOMBIE" );
+        }
+    }
+    const auto end4 = std::chrono::steady_clock::now();
+
+    int found_species_ids = 0;
+    const auto start5 = std::chrono::steady_clock::now();
+    for( int i = 0; i < iterations; i++ ) {
+        for( const monster &critter : horde ) {
+            found_species_ids += critter.type->in_species( species_zombie );
+        }
+    }
+    const auto end5 = std::chrono::steady_clock::now();
+
+    CHECK( found_bits == found_sets );
+    CHECK( found_species_strings == found_species_sets );
+    CHECK( found_species_ids == found_species_sets );
+    printf( "Set lookups for a horde of %d executed %d times in %f seconds.\n", int( horde.size() ),
+            iterations, std::chrono::duration<double>( end1 - start1 ).count() );
+    printf( "Bitset lookups for a horde of %d executed %d times in %f seconds.\n", int( horde.size() ),
+            iterations, std::chrono::duration<double>( end2 - start2 ).count() );
+    printf( "Species set lookups for a horde of %d executed %d times in %f seconds.\n",
+            int( horde.size() ), iterations, std::chrono::duration<double>( end3 - start3 ).count() );
+    printf( "mtype::in_species( \"ZOMBIE\" ) for a horde of %d executed %d times in %f seconds.\n",
+            int( horde.size() ), iterations, std::chrono::duration<double>( end4 - start4 ).count() );
+    printf( "mtype::in_species( species_zombie ) for a horde of %d executed %d times in %f seconds (%d found).\n",
+            int( horde.size() ), iterations, std::chrono::duration<double>( end5 - start5 ).count(),
+            found_species_ids / iterations );
+}
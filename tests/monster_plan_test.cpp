@@ -0,0 +1,85 @@
+#define CATCH_CONFIG_MAIN
+#include "catch/catch.hpp"
+#include "test_game.h"
+
+#include "game.h"
+#include "map.h"
+#include "mapdata.h"
+#include "player.h"
+#include "monster.h"
+#include "monstergenerator.h"
+#include "sight_cache.h"
+#include "thread_pool.h"
+
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+static bool same_plans( const monster_plan &a, const monster_plan &b )
+{
+    return a.from == b.from && a.target == b.target && a.target_pos == b.target_pos &&
+           a.selected_slope == b.selected_slope && a.fleeing == b.fleeing &&
+           a.anger_change == b.anger_change && a.morale_change == b.morale_change &&
+           a.crowded == b.crowded && a.crowded_by == b.crowded_by;
+}
+
+TEST_CASE("Monsters choose the same targets on any number of threads.") {
+    init_game();
+    map &m = g->m;
+    g->clear_zombies();
+    std::default_random_engine generator( 17 );
+    std::uniform_int_distribution<int> tile_distribution( 0, 9 );
+    for( int x = 20; x < 100; x++ ) {
+        for( int y = 20; y < 100; y++ ) {
+            m.furn_set( tripoint( x, y, 0 ), f_null );
+            m.ter_set( tripoint( x, y, 0 ), tile_distribution( generator ) == 0 ? t_wall : t_floor );
+        }
+    }
+    g->u.setpos( tripoint( 60, 60, 0 ) );
+    m.ter_set( g->u.pos3(), t_floor );
+    m.build_map_cache( 0 );
+
+    // Hostile and friendly ones, some of them swarming
+    std::uniform_int_distribution<int> position_distribution( 30, 90 );
+    const char *types[] = { "mon_zombie", "mon_dog", "mon_ant", "mon_wasp" };
+    for( int i = 0; i < 200; i++ ) {
+        const tripoint p( position_distribution( generator ), position_distribution( generator ), 0 );
+        if( m.move_cost( p ) == 0 || g->mon_at( p ) != -1 || p == g->u.pos3() ) {
+            continue;
+        }
+        monster critter( GetMType( types[i % 4] ), p );
+        critter.friendly = i % 7 == 0 ? -1 : 0;
+        g->add_zombie( critter );
+    }
+    REQUIRE( g->num_zombies() > 100 );
+
+    // Choosing targets doesn't use the random number generator
+    srand( 23 );
+    std::vector<monster_plan> expected;
+    for( size_t i = 0; i < g->num_zombies(); i++ ) {
+        expected.push_back( g->zombie( i ).choose_target() );
+    }
+    const int next_random = rand();
+    srand( 23 );
+    CHECK( rand() == next_random );
+
+    int with_target = 0;
+    for( const auto &plan : expected ) {
+        with_target += plan.target != nullptr;
+    }
+    CHECK( with_target > 0 );
+
+    for( const int workers : { 1, 3 } ) {
+        thread_pool pool( workers );
+        sight_cache::invalidate();
+        std::vector<monster_plan> plans( g->num_zombies() );
+        pool.run( g->num_zombies(), [&]( const int i ) {
+            plans[i] = g->zombie( i ).choose_target();
+        } );
+        for( size_t i = 0; i < plans.size(); i++ ) {
+            INFO( "monster " << i << " with " << workers << " workers" );
+            CHECK( same_plans( plans[i], expected[i] ) );
+        }
+    }
+    g->clear_zombies();
+}
@@ -0,0 +1,260 @@
+#define CATCH_CONFIG_MAIN
+#include "catch/catch.hpp"
+#include "test_game.h"
+
+#include "game.h"
+#include "map.h"
+#include "mapdata.h"
+#include "player.h"
+#include "line.h"
+#include "turn_profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <random>
+#include <vector>
+#include "stdio.h"
+
+#define PERFORMANCE_TEST_ITERATIONS 2000
+
+// Fill the z-level 0 of the bubble with floor and put up parallel walls,
+// each with a single randomly placed gap, so straight lines never work.
+static void build_maze( unsigned seed )
+{
+    std::default_random_engine generator( seed );
+    std::uniform_int_distribution<int> gap_distribution( 1, SEEY * MAPSIZE - 2 );
+
+    map &m = g->m;
+    for( int x = 0; x < SEEX * MAPSIZE; x++ ) {
+        for( int y = 0; y < SEEY * MAPSIZE; y++ ) {
+            m.furn_set( tripoint( x, y, 0 ), f_null );
+            m.ter_set( tripoint( x, y, 0 ), t_floor );
+        }
+    }
+
+    for( int x = 8; x < SEEX * MAPSIZE - 8; x += 8 ) {
+        const int gap = gap_distribution( generator );
+        for( int y = 0; y < SEEY * MAPSIZE; y++ ) {
+            if( y != gap ) {
+                m.ter_set( tripoint( x, y, 0 ), t_wall );
+            }
+        }
+    }
+
+    // Keep the player out of the way of the routes
+    g->u.setpos( tripoint( 0, 0, 0 ) );
+}
+
+TEST_CASE("Reused pathfinder state gives identical routes.") {
+    init_game();
+    build_maze( 42 );
+
+    // map::route only searches the box around the end points (plus some padding),
+    // so they are near opposite edges to let it reach all the gaps
+    const tripoint from( 4, 3, 0 );
+    const tripoint to( SEEX * MAPSIZE - 4, SEEY * MAPSIZE - 4, 0 );
+    const tripoint other_from( 20, 5, 0 );
+    const tripoint other_to( 45, SEEY * MAPSIZE - 5, 0 );
+
+    const std::vector<tripoint> first = g->m.route( from, to, 0, 10000 );
+    REQUIRE( !first.empty() );
+    REQUIRE( first.back() == to );
+
+    // A search in between must not leave anything behind for the next one
+    const std::vector<tripoint> other = g->m.route( other_from, other_to, 0, 10000 );
+    REQUIRE( !other.empty() );
+
+    const std::vector<tripoint> second = g->m.route( from, to, 0, 10000 );
+    REQUIRE( first == second );
+
+    // Blocked off destination
+    g->m.ter_set( other_to, t_wall );
+    REQUIRE( g->m.route( other_from, other_to, 0, 10000 ).empty() );
+    g->m.ter_set( other_to, t_floor );
+    REQUIRE( g->m.route( other_from, other_to, 0, 10000 ) == other );
+}
+
+// Every step has to be to an adjacent, passable tile
+static bool route_is_continuous( const tripoint &from, const std::vector<tripoint> &route )
+{
+    tripoint prev = from;
+    for( const tripoint &p : route ) {
+        if( square_dist( prev, p ) != 1 || g->m.move_cost( p ) == 0 ) {
+            return false;
+        }
+        prev = p;
+    }
+    return true;
+}
+
+// Number of tiles and portals the searches of `route` closed, and whether it used the portal graph
+static std::pair<int, bool> count_expansions( const std::function<void()> &route )
+{
+    turn_profiler::set_enabled( true );
+    route();
+    turn_profiler::end_turn( 0 );
+    const int expanded = turn_profiler::get_stats( turn_profiler::COUNTER_ROUTE_EXPANSIONS ).last;
+    const bool portals = turn_profiler::get_stats( turn_profiler::COUNTER_PORTAL_ROUTES ).last > 0;
+    turn_profiler::set_enabled( false );
+    return std::make_pair( expanded, portals );
+}
+
+TEST_CASE("Long routes planned on the portal graph are continuous.") {
+    init_game();
+    build_maze( 99 );
+
+    const tripoint from( 2, 3, 0 );
+    const tripoint to( SEEX * MAPSIZE - 3, SEEY * MAPSIZE - 2, 0 );
+    std::vector<tripoint> graph_route;
+    const auto graph_search = count_expansions( [&]() {
+        graph_route = g->m.route( from, to, 0, 10000 );
+    } );
+    REQUIRE( !graph_route.empty() );
+    REQUIRE( graph_route.back() == to );
+    REQUIRE( route_is_continuous( from, graph_route ) );
+    CHECK( graph_search.second );
+
+    // Creatures that bash search the tiles, walls are too strong for this one
+    std::vector<tripoint> tile_route;
+    const auto tile_search = count_expansions( [&]() {
+        tile_route = g->m.route( from, to, 1, 10000 );
+    } );
+    REQUIRE( !tile_route.empty() );
+    REQUIRE( route_is_continuous( from, tile_route ) );
+    CHECK_FALSE( tile_search.second );
+    CHECK( graph_search.first < tile_search.first / 2 );
+    printf( "Long route: %d tiles and portals closed on the portal graph, %d without it.\n",
+            graph_search.first, tile_search.first );
+
+    // Blocking a tile dirties the graph, the next route rebuilds it
+    const tripoint blocker = graph_route[graph_route.size() / 2];
+    g->m.ter_set( blocker, t_wall );
+    std::vector<tripoint> rebuilt_route;
+    CHECK( count_expansions( [&]() {
+        rebuilt_route = g->m.route( from, to, 0, 10000 );
+    } ).second );
+    REQUIRE( std::find( rebuilt_route.begin(), rebuilt_route.end(), blocker ) == rebuilt_route.end() );
+    REQUIRE( route_is_continuous( from, rebuilt_route ) );
+}
+
+TEST_CASE("Flow field routes lead to the target.") {
+    init_game();
+    build_maze( 5 );
+
+    const tripoint target( SEEX * MAPSIZE / 2 + 3, SEEY * MAPSIZE / 2, 0 );
+    flow_field field;
+    field.update( g->m, target, 1 );
+    REQUIRE( field.distance( target ) == 0 );
+
+    for( const tripoint &from : { tripoint( 50, 10, 0 ), tripoint( 70, 100, 0 ), tripoint( 60, 60, 0 ) } ) {
+        std::vector<tripoint> route;
+        for( tripoint p = field.next_step( from ); p != tripoint_min; p = field.next_step( p ) ) {
+            REQUIRE( field.distance( p ) < field.distance( route.empty() ? from : route.back() ) );
+            route.push_back( p );
+        }
+        REQUIRE( !route.empty() );
+        REQUIRE( route.back() == target );
+        REQUIRE( route_is_continuous( from, route ) );
+    }
+
+    // Walls never get a route
+    REQUIRE( field.next_step( tripoint( 64, 0, 0 ) ) == tripoint_min );
+}
+
+TEST_CASE("A flow field against a route for each chasing monster.") {
+    init_game();
+    build_maze( 11 );
+
+    const tripoint target( SEEX * MAPSIZE / 2 + 3, SEEY * MAPSIZE / 2, 0 );
+    std::default_random_engine generator( 3 );
+    std::uniform_int_distribution<int> offset_distribution( -20, 20 );
+    std::vector<tripoint> chasers;
+    while( chasers.size() < 32 ) {
+        const tripoint p = target + tripoint( offset_distribution( generator ), offset_distribution( generator ), 0 );
+        if( g->m.move_cost( p ) > 0 && p != target ) {
+            chasers.push_back( p );
+        }
+    }
+
+    const int iterations = 50;
+    for( const size_t group : { 1, 4, 8, 16, 32 } ) {
+        int steps = 0;
+        const auto start1 = std::chrono::steady_clock::now();
+        for( int i = 0; i < iterations; i++ ) {
+            flow_field field;
+            field.update( g->m, target, i );
+            for( size_t c = 0; c < group; c++ ) {
+                steps += field.next_step( chasers[c] ) != tripoint_min;
+            }
+        }
+        const auto end1 = std::chrono::steady_clock::now();
+        int routes = 0;
+        const auto start2 = std::chrono::steady_clock::now();
+        for( int i = 0; i < iterations; i++ ) {
+            for( size_t c = 0; c < group; c++ ) {
+                routes += !g->m.route( chasers[c], target, 0, 1000 ).empty();
+            }
+        }
+        const auto end2 = std::chrono::steady_clock::now();
+        printf( "%d chasers, %d turns: flow field %f seconds (%d steps), routes %f seconds (%d routes).\n",
+                int( group ), iterations, std::chrono::duration<double>( end1 - start1 ).count(), steps,
+                std::chrono::duration<double>( end2 - start2 ).count(), routes );
+    }
+}
+
+TEST_CASE("Cached move costs follow terrain and furniture changes.") {
+    init_game();
+    build_maze( 3 );
+    g->m.build_map_cache( 0 );
+
+    const tripoint wall( 16, 0, 0 );
+    const tripoint floor( 20, 20, 0 );
+    REQUIRE( g->m.move_cost( wall ) == 0 );
+    REQUIRE( g->m.move_cost( floor ) == g->m.move_cost_ter_furn( floor ) );
+
+    g->m.ter_set( wall, t_floor );
+    g->m.furn_set( floor, f_table );
+    CHECK( g->m.move_cost( wall ) == g->m.move_cost_ter_furn( wall ) );
+    CHECK( g->m.move_cost( floor ) == g->m.move_cost_ter_furn( floor ) );
+
+    // Whole-level invalidation falls back to the map data until the next rebuild
+    g->m.set_pathfinding_cache_dirty( 0 );
+    g->m.furn_set( floor, f_null );
+    CHECK( g->m.move_cost( floor ) == g->m.move_cost_ter_furn( floor ) );
+    g->m.build_map_cache( 0 );
+    CHECK( g->m.move_cost( floor ) == g->m.move_cost_ter_furn( floor ) );
+}
+
+TEST_CASE("Routes per second across the reality bubble.") {
+    init_game();
+    build_maze( 1337 );
+
+    std::default_random_engine generator( 7 );
+    // Near the top and bottom edges, see above
+    std::uniform_int_distribution<int> y_distribution( 1, 7 );
+    std::uniform_int_distribution<int> x_distribution( 1, 7 );
+
+    std::vector<std::pair<tripoint, tripoint>> endpoints;
+    for( int i = 0; i < 64; i++ ) {
+        endpoints.emplace_back( tripoint( x_distribution( generator ), y_distribution( generator ), 0 ),
+                                tripoint( SEEX * MAPSIZE - x_distribution( generator ) - 1,
+                                          SEEY * MAPSIZE - y_distribution( generator ) - 1, 0 ) );
+    }
+
+    size_t found = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for( int i = 0; i < PERFORMANCE_TEST_ITERATIONS; i++ ) {
+        const auto &ends = endpoints[i % endpoints.size()];
+        if( !g->m.route( ends.first, ends.second, 0, 10000 ).empty() ) {
+            found++;
+        }
+    }
+    const auto end = std::chrono::steady_clock::now();
+    const double seconds = std::chrono::duration<double>( end - start ).count();
+
+    printf( "map::route() executed %d times in %f seconds (%.1f routes per second).\n",
+            PERFORMANCE_TEST_ITERATIONS, seconds, PERFORMANCE_TEST_ITERATIONS / seconds );
+
+    REQUIRE( found == PERFORMANCE_TEST_ITERATIONS );
+}
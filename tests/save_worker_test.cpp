@@ -0,0 +1,125 @@
+#define CATCH_CONFIG_MAIN
+#include "catch/catch.hpp"
+
+#include "filesystem.h"
+#include "mapsharing.h"
+#include "save_worker.h"
+
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <string>
+
+static std::string read_file( const std::string &path )
+{
+    std::ifstream fin( path.c_str(), std::ios_base::in | std::ios_base::binary );
+    std::ostringstream data;
+    data << fin.rdbuf();
+    return data.str();
+}
+
+TEST_CASE("The save worker writes files in the order they were queued.") {
+    const std::string dir = "save_worker_test_files";
+    REQUIRE( assure_dir_exist( dir ) );
+    const std::string path = dir + "/a.txt";
+
+    for( const bool background : { false, true } ) {
+        INFO( "background " << background );
+        save_worker worker( background );
+        // Holds up the worker until the test has queued the rest
+        std::mutex hold;
+        if( background ) {
+            hold.lock();
+        }
+        worker.write( dir + "/b.txt", [&hold]( std::ostream & fout ) {
+            std::lock_guard<std::mutex> wait( hold );
+            fout << "b";
+        } );
+        for( int i = 0; i < 10; i++ ) {
+            worker.write( path, [i]( std::ostream & fout ) {
+                fout << "version " << i;
+            } );
+        }
+        if( background ) {
+            hold.unlock();
+        }
+        worker.wait_for( path );
+        CHECK( read_file( path ) == "version 9" );
+        CHECK( worker.wait() );
+        CHECK( read_file( dir + "/b.txt" ) == "b" );
+        CHECK_FALSE( file_exist( path + ".temp" ) );
+        CHECK_FALSE( file_exist( path + ".lock" ) );
+    }
+    remove_file( path );
+    remove_file( dir + "/b.txt" );
+    remove( dir.c_str() );
+}
+
+TEST_CASE("Failed writes of the save worker keep the old file.") {
+    const std::string dir = "save_worker_test_files";
+    REQUIRE( assure_dir_exist( dir ) );
+    const std::string path = dir + "/a.txt";
+
+    save_worker worker( true );
+    int failures = 0;
+    worker.write( path, []( std::ostream & fout ) {
+        fout << "old";
+    }, [&failures]() {
+        failures++;
+    } );
+    worker.write( path, []( std::ostream & fout ) {
+        fout << "half of the new";
+        throw std::string( "serialization failed" );
+    }, [&failures]() {
+        failures += 10;
+    } );
+    CHECK_FALSE( worker.wait() );
+    CHECK( failures == 10 );
+    CHECK( worker.wait() );
+    CHECK( worker.collect() );
+    CHECK( failures == 10 );
+    CHECK( read_file( path ) == "old" );
+    CHECK_FALSE( file_exist( path + ".temp" ) );
+
+    // Files that are changed in place
+    bool locked = false;
+    worker.update( path, [&locked]( const std::string & file ) {
+        locked = file_exist( file + ".lock" );
+        std::ofstream fout( file.c_str(), std::ios_base::out | std::ios_base::app );
+        fout << " and more";
+        return true;
+    } );
+    worker.update( path, []( const std::string & ) {
+        return false;
+    }, [&failures]() {
+        failures += 100;
+    } );
+    CHECK_FALSE( worker.wait() );
+    CHECK( failures == 110 );
+#ifdef __linux__
+    CHECK( locked );
+#endif
+    CHECK( read_file( path ) == "old and more" );
+    CHECK_FALSE( file_exist( path + ".lock" ) );
+
+#ifdef __linux__
+    // Files locked by fopen_exclusive are left alone, and the write fails
+    std::ofstream fout;
+    fopen_exclusive( fout, path.c_str() );
+    REQUIRE( fout.is_open() );
+    worker.write( path, []( std::ostream & fout ) {
+        fout << "new";
+    }, [&failures]() {
+        failures += 1000;
+    } );
+    CHECK_FALSE( worker.wait() );
+    CHECK( failures == 1110 );
+    fout << "exclusive";
+    fclose_exclusive( fout, path.c_str() );
+    CHECK( read_file( path ) == "exclusive" );
+#endif
+
+    remove_file( path );
+    remove( dir.c_str() );
+}
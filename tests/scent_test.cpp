@@ -0,0 +1,182 @@
+#define CATCH_CONFIG_MAIN
+#include "catch/catch.hpp"
+#include "test_game.h"
+
+#include "game.h"
+#include "map.h"
+#include "mapdata.h"
+#include "player.h"
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include "stdio.h"
+
+#define PERFORMANCE_TEST_ITERATIONS 1000
+
+typedef int scent_array[SEEX * MAPSIZE][SEEY * MAPSIZE];
+
+// Floor with random walls and scent reducing fences on z-level 0
+static void build_terrain( unsigned seed )
+{
+    std::default_random_engine generator( seed );
+    std::uniform_int_distribution<int> tile_distribution( 0, 9 );
+
+    map &m = g->m;
+    for( int x = 0; x < SEEX * MAPSIZE; x++ ) {
+        for( int y = 0; y < SEEY * MAPSIZE; y++ ) {
+            const int roll = tile_distribution( generator );
+            m.furn_set( tripoint( x, y, 0 ), f_null );
+            m.ter_set( tripoint( x, y, 0 ), roll == 0 ? t_wall : ( roll == 1 ? t_fence_h : t_floor ) );
+        }
+    }
+}
+
+static void fill_scent( scent_array &scent, unsigned seed )
+{
+    std::default_random_engine generator( seed );
+    std::uniform_int_distribution<int> scent_distribution( 0, 10000 );
+    for( auto &column : scent ) {
+        for( int &s : column ) {
+            s = scent_distribution( generator );
+        }
+    }
+}
+
+// The diffusion step game::update_scent used to do itself, tile by tile
+static void reference_diffuse( scent_array &grscent, const int minx, const int miny,
+                               const int maxx, const int maxy )
+{
+    static int sum_3_scent_y[SEEY * MAPSIZE][SEEX * MAPSIZE];
+    static int squares_used_y[SEEY * MAPSIZE][SEEX * MAPSIZE];
+    bool blocks_scent[SEEX * MAPSIZE][SEEY * MAPSIZE] = {};
+    bool reduces_scent[SEEX * MAPSIZE][SEEY * MAPSIZE] = {};
+    const int diffusivity = 100;
+
+    g->m.scent_blockers( blocks_scent, reduces_scent, 0, 0, SEEX * MAPSIZE - 1, SEEY * MAPSIZE - 1 );
+    for( int x = minx - 1; x <= maxx + 1; ++x ) {
+        for( int y = miny; y <= maxy; ++y ) {
+            sum_3_scent_y[y][x] = 0;
+            squares_used_y[y][x] = 0;
+            for( int i = y - 1; i <= y + 1; ++i ) {
+                if( !blocks_scent[x][i] ) {
+                    if( reduces_scent[x][i] ) {
+                        sum_3_scent_y[y][x] += 2 * grscent[x][i];
+                        squares_used_y[y][x] += 2;
+                    } else {
+                        sum_3_scent_y[y][x] += 10 * grscent[x][i];
+                        squares_used_y[y][x] += 10;
+                    }
+                }
+            }
+        }
+    }
+
+    for( int x = minx; x <= maxx; ++x ) {
+        for( int y = miny; y <= maxy; ++y ) {
+            if( !blocks_scent[x][y] ) {
+                const int squares_used = squares_used_y[y][x - 1] + squares_used_y[y][x] +
+                                         squares_used_y[y][x + 1];
+                const int this_diffusivity = reduces_scent[x][y] ? diffusivity / 5 : diffusivity;
+                int temp_scent = grscent[x][y] * ( 10 * 1000 - squares_used * this_diffusivity );
+                temp_scent -= grscent[x][y] * this_diffusivity * ( 90 - squares_used ) / 5;
+                grscent[x][y] = ( temp_scent + this_diffusivity * ( sum_3_scent_y[y][x - 1] +
+                                  sum_3_scent_y[y][x] + sum_3_scent_y[y][x + 1] ) ) / ( 1000 * 10 );
+            } else {
+                grscent[x][y] = 0;
+            }
+        }
+    }
+}
+
+static bool same_scent( const scent_array &a, const scent_array &b )
+{
+    for( int x = 0; x < SEEX * MAPSIZE; x++ ) {
+        if( !std::equal( a[x], a[x] + SEEY * MAPSIZE, b[x] ) ) {
+            return false;
+        }
+    }
+    return true;
+}
+
+TEST_CASE("Scent diffusion matches the tile by tile algorithm.") {
+    init_game();
+    build_terrain( 17 );
+
+    static scent_array expected;
+    static scent_array actual;
+    fill_scent( expected, 4 );
+    std::copy( &expected[0][0], &expected[0][0] + SEEX * MAPSIZE * SEEY * MAPSIZE, &actual[0][0] );
+
+    const int minx = 20;
+    const int miny = 20;
+    const int maxx = 100;
+    const int maxy = 100;
+    for( int step = 0; step < 10; step++ ) {
+        reference_diffuse( expected, minx, miny, maxx, maxy );
+        g->m.diffuse_scent( actual, minx, miny, maxx, maxy );
+        REQUIRE( same_scent( expected, actual ) );
+    }
+
+    // Changed terrain has to make it into the cached blockers
+    g->m.ter_set( tripoint( 50, 50, 0 ), t_wall );
+    g->m.ter_set( tripoint( 51, 50, 0 ), t_fence_h );
+    g->m.ter_set( tripoint( 52, 50, 0 ), t_floor );
+    for( int step = 0; step < 10; step++ ) {
+        reference_diffuse( expected, minx + step, miny, maxx, maxy - step );
+        g->m.diffuse_scent( actual, minx + step, miny, maxx, maxy - step );
+        REQUIRE( same_scent( expected, actual ) );
+    }
+}
+
+TEST_CASE("Diffusing only around the nonzero scent matches diffusing everything.") {
+    init_game();
+    build_terrain( 31 );
+
+    static scent_array whole;
+    static scent_array active;
+    std::fill_n( &whole[0][0], SEEX * MAPSIZE * SEEY * MAPSIZE, 0 );
+    whole[60][60] = 5000;
+    whole[63][58] = 800;
+    std::copy( &whole[0][0], &whole[0][0] + SEEX * MAPSIZE * SEEY * MAPSIZE, &active[0][0] );
+
+    // Like game::update_scent, grow the box by one tile per step
+    int minx = 60;
+    int miny = 58;
+    int maxx = 63;
+    int maxy = 60;
+    for( int step = 0; step < 20; step++ ) {
+        g->m.diffuse_scent( whole, 20, 20, 100, 100 );
+        minx--;
+        miny--;
+        maxx++;
+        maxy++;
+        g->m.diffuse_scent( active, minx, miny, maxx, maxy );
+        REQUIRE( same_scent( whole, active ) );
+    }
+
+    // Scent disappears eventually, then nothing changes anymore
+    bool changed = true;
+    for( int step = 0; step < 2000 && changed; step++ ) {
+        changed = g->m.diffuse_scent( whole, 20, 20, 100, 100 );
+    }
+    CHECK( !changed );
+}
+
+TEST_CASE("Scent diffusion steps per second.") {
+    init_game();
+    build_terrain( 23 );
+
+    static scent_array scent;
+    fill_scent( scent, 8 );
+
+    const auto start = std::chrono::steady_clock::now();
+    for( int i = 0; i < PERFORMANCE_TEST_ITERATIONS; i++ ) {
+        g->m.diffuse_scent( scent, 26, 26, 106, 106 );
+    }
+    const auto end = std::chrono::steady_clock::now();
+    const double seconds = std::chrono::duration<double>( end - start ).count();
+
+    printf( "map::diffuse_scent() executed %d times in %f seconds (%.1f steps per second).\n",
+            PERFORMANCE_TEST_ITERATIONS, seconds, PERFORMANCE_TEST_ITERATIONS / seconds );
+}
@@ -3,6 +3,7 @@
 
 #include "map.h"
 #include "line.h"
+#include "thread_pool.h"
 
 #include <chrono>
 #include <random>
@@ -243,3 +244,65 @@ TEST_CASE("Regression test against old shadowcasting implementation.") {
 
     REQUIRE( passed );
 }
+
+TEST_CASE("Parallel shadowcasting matches serial shadowcasting.") {
+    const unsigned seed = std::chrono::system_clock::now().time_since_epoch().count();
+    std::default_random_engine generator(seed);
+    std::uniform_int_distribution<unsigned int> distribution(0, DENOMINATOR);
+    auto rng = std::bind ( distribution, generator );
+
+    float transparency_cache[MAPSIZE*SEEX][MAPSIZE*SEEY] = {0};
+    for( auto &inner : transparency_cache ) {
+        for( float &square : inner ) {
+            if( rng() < NUMERATOR ) {
+                square = 1.0f;
+            }
+        }
+    }
+
+    // At least one worker, so the parallel path runs even on a single core
+    thread_pool pool( 3 );
+
+    // The center, next to the edges and with part of the distance already used up by a mirror
+    const int origins[][3] = { { 65, 65, 0 }, { 0, 0, 0 }, { 131, 3, 0 }, { 20, 100, 10 }, { 70, 40, 55 } };
+    for( const auto &origin : origins ) {
+        bool seen_serial[MAPSIZE*SEEX][MAPSIZE*SEEY] = {0};
+        bool seen_parallel[MAPSIZE*SEEX][MAPSIZE*SEEY] = {0};
+        // Squares seen earlier have to stay seen
+        seen_serial[1][2] = true;
+        seen_parallel[1][2] = true;
+
+        castLightAll( seen_serial, transparency_cache, origin[0], origin[1], origin[2] );
+        castLightAll( seen_parallel, transparency_cache, origin[0], origin[1], origin[2], &pool );
+
+        bool passed = true;
+        for( int x = 0; x < MAPSIZE*SEEX; ++x ) {
+            for( int y = 0; y < MAPSIZE*SEEY; ++y ) {
+                if( seen_serial[x][y] != seen_parallel[x][y] ) {
+                    passed = false;
+                }
+            }
+        }
+        INFO( "seed " << seed << ", origin " << origin[0] << "," << origin[1] << "," << origin[2] );
+        REQUIRE( passed );
+    }
+
+    const int iterations = 100000;
+    bool seen_squares[MAPSIZE*SEEX][MAPSIZE*SEEY] = {0};
+    const auto start1 = std::chrono::steady_clock::now();
+    for( int i = 0; i < iterations; i++ ) {
+        castLightAll( seen_squares, transparency_cache, 65, 65 );
+    }
+    const auto end1 = std::chrono::steady_clock::now();
+    const auto start2 = std::chrono::steady_clock::now();
+    for( int i = 0; i < iterations; i++ ) {
+        castLightAll( seen_squares, transparency_cache, 65, 65, 0, &thread_pool::instance() );
+    }
+    const auto end2 = std::chrono::steady_clock::now();
+
+    printf( "Serial castLightAll() executed %d times in %f seconds.\n", iterations,
+            std::chrono::duration<double>( end1 - start1 ).count() );
+    printf( "Parallel castLightAll() on %d threads executed %d times in %f seconds.\n",
+            thread_pool::instance().size(), iterations,
+            std::chrono::duration<double>( end2 - start2 ).count() );
+}
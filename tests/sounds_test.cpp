@@ -0,0 +1,45 @@
+#define CATCH_CONFIG_MAIN
+#include "catch/catch.hpp"
+#include "test_game.h"
+
+#include "game.h"
+#include "map.h"
+#include "player.h"
+#include "monster.h"
+#include "monstergenerator.h"
+#include "sounds.h"
+#include "turn_profiler.h"
+#include "weather.h"
+
+TEST_CASE("Sounds only reach the monsters within twice their volume.") {
+    init_game();
+    g->clear_zombies();
+    sounds::reset_sounds();
+    g->u.setpos( tripoint( 10, 10, 0 ) );
+    const tripoint source( 40, 60, 0 );
+    const int vol = 20 - weather_data( g->weather ).sound_attn;
+    REQUIRE( vol > 5 );
+
+    // Zombies hear a sound closer than its volume, monsters with good hearing closer than twice that
+    const int distances[] = { 3, vol - 1, vol, vol + 3, vol * 2 - 1, vol * 2, 60 };
+    for( const int d : distances ) {
+        monster zombie( GetMType( "mon_zombie" ), source + tripoint( d, 0, 0 ) );
+        g->add_zombie( zombie );
+    }
+
+    turn_profiler::set_enabled( true );
+    sounds::sound( source, 20, "" );
+    sounds::process_sounds();
+    turn_profiler::end_turn( 0 );
+
+    for( size_t i = 0; i < g->num_zombies(); i++ ) {
+        const monster &critter = g->zombie( i );
+        const int dist = rl_dist( source, critter.pos3() );
+        INFO( "distance " << dist );
+        CHECK( ( critter.wandf > 0 ) == ( dist < vol ) );
+    }
+    CHECK( turn_profiler::get_stats( turn_profiler::COUNTER_SOUND_LISTENERS_TESTED ).last == 5 );
+    CHECK( turn_profiler::get_stats( turn_profiler::COUNTER_SOUND_LISTENERS_NOTIFIED ).last == 2 );
+    turn_profiler::set_enabled( false );
+    g->clear_zombies();
+}
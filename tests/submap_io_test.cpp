@@ -0,0 +1,436 @@
+#define CATCH_CONFIG_MAIN
+#include "catch/catch.hpp"
+#include "test_game.h"
+
+#include "game.h"
+#include "computer.h"
+#include "json.h"
+#include "mapdata.h"
+#include "player.h"
+#include "savegame.h"
+#include "submap_io.h"
+#include "trap.h"
+#include "vehicle.h"
+
+#include <chrono>
+#include <functional>
+#include <random>
+#include <sstream>
+#include "stdio.h"
+
+// The JSON writer of the old saves, for the quads that are still read in that format
+static void write_quad_json( std::ostream &fout, const submap_io::quad_out &submaps )
+{
+    JsonOut jsout( fout );
+    jsout.start_array();
+    for( auto &elem : submaps ) {
+        const tripoint &submap_addr = elem.first;
+        submap *sm = elem.second;
+
+        jsout.start_object();
+
+        jsout.member( "version", savegame_version);
+
+        jsout.member( "coordinates" );
+        jsout.start_array();
+        jsout.write( submap_addr.x );
+        jsout.write( submap_addr.y );
+        jsout.write( submap_addr.z );
+        jsout.end_array();
+
+        jsout.member( "turn_last_touched", sm->turn_last_touched );
+        jsout.member( "temperature", sm->temperature );
+
+        jsout.member( "terrain" );
+        jsout.start_array();
+        for(int j = 0; j < SEEY; j++) {
+            for(int i = 0; i < SEEX; i++) {
+                // Save terrains
+                jsout.write( terlist[sm->ter[i][j]].id );
+            }
+        }
+        jsout.end_array();
+
+        // Write out the radiation array in a simple RLE scheme.
+        // written in intensity, count pairs
+        jsout.member( "radiation" );
+        jsout.start_array();
+        int lastrad = -1;
+        int count = 0;
+        for(int j = 0; j < SEEY; j++) {
+            for(int i = 0; i < SEEX; i++) {
+                int r = sm->get_radiation(i, j);
+                if (r == lastrad) {
+                    count++;
+                } else {
+                    if (count) {
+                        jsout.write( count );
+                    }
+                    jsout.write( r );
+                    lastrad = r;
+                    count = 1;
+                }
+            }
+        }
+        jsout.write( count );
+        jsout.end_array();
+
+        jsout.member("furniture");
+        jsout.start_array();
+        for(int j = 0; j < SEEY; j++) {
+            for(int i = 0; i < SEEX; i++) {
+                // Save furniture
+                if( sm->get_furn( i, j ) != f_null ) {
+                    jsout.start_array();
+                    jsout.write( i );
+                    jsout.write( j );
+                    jsout.write( furnlist[ sm->get_furn( i, j ) ].id );
+                    jsout.end_array();
+                }
+            }
+        }
+        jsout.end_array();
+
+        jsout.member( "items" );
+        jsout.start_array();
+        for(int j = 0; j < SEEY; j++) {
+            for(int i = 0; i < SEEX; i++) {
+                if( sm->itm[i][j].empty() ) {
+                    continue;
+                }
+                jsout.write( i );
+                jsout.write( j );
+                jsout.write( sm->itm[i][j] );
+            }
+        }
+        jsout.end_array();
+
+        jsout.member( "traps" );
+        jsout.start_array();
+        for(int j = 0; j < SEEY; j++) {
+            for(int i = 0; i < SEEX; i++) {
+                // Save traps
+                if (sm->get_trap( i, j ) != tr_null) {
+                    jsout.start_array();
+                    jsout.write( i );
+                    jsout.write( j );
+                    // TODO: jsout should support writting an id like jsout.write( trap_id )
+                    jsout.write( sm->get_trap( i, j ).id().str() );
+                    jsout.end_array();
+                }
+            }
+        }
+        jsout.end_array();
+
+        jsout.member( "fields" );
+        jsout.start_array();
+        for(int j = 0; j < SEEY; j++) {
+            for(int i = 0; i < SEEX; i++) {
+                // Save fields
+                if (sm->fld[i][j].fieldCount() > 0) {
+                    jsout.write( i );
+                    jsout.write( j );
+                    jsout.start_array();
+                    for( auto &fld : sm->fld[i][j] ) {
+                        const field_entry &cur = fld.second;
+                            // We don't seem to have a string identifier for fields anywhere.
+                            jsout.write( cur.getFieldType() );
+                            jsout.write( cur.getFieldDensity() );
+                            jsout.write( cur.getFieldAge() );
+                    }
+                    jsout.end_array();
+                }
+            }
+        }
+        jsout.end_array();
+
+        jsout.member("cosmetics");
+        jsout.start_array();
+        for (int j = 0; j < SEEY; j++) {
+            for (int i = 0; i < SEEX; i++) {
+                if (sm->cosmetics[i][j].size() > 0) {
+                    jsout.start_array();
+                    jsout.write(i);
+                    jsout.write(j);
+                    jsout.write(sm->cosmetics[i][j]);
+                    jsout.end_array();
+                }
+            }
+        }
+        jsout.end_array();
+
+        // Output the spawn points
+        jsout.member( "spawns" );
+        jsout.start_array();
+        for( auto &elem : sm->spawns ) {
+            jsout.start_array();
+            jsout.write( elem.type );
+            jsout.write( elem.count );
+            jsout.write( elem.posx );
+            jsout.write( elem.posy );
+            jsout.write( elem.faction_id );
+            jsout.write( elem.mission_id );
+            jsout.write( elem.friendly );
+            jsout.write( elem.name );
+            jsout.end_array();
+        }
+        jsout.end_array();
+
+        jsout.member( "vehicles" );
+        jsout.start_array();
+        for( auto &elem : sm->vehicles ) {
+            // json lib doesn't know how to turn a vehicle * into a vehicle,
+            // so we have to iterate manually.
+            jsout.write( *elem );
+        }
+        jsout.end_array();
+
+        // Output the computer
+        if (sm->comp.name != "") {
+            jsout.member( "computers", sm->comp.save_data() );
+        }
+
+        // Output base camp if any
+        if (sm->camp.is_valid()) {
+            jsout.member( "camp" );
+            jsout.write( sm->camp.save_data() );
+        }
+        jsout.end_object();
+    }
+
+    jsout.end_array();
+}
+
+// A submap with a bit of everything that is saved, items, fields and vehicles only if `with_items`
+static void fill_submap( submap &sm, std::default_random_engine &generator, bool with_items )
+{
+    const ter_id terrain[] = { terfind( "t_dirt" ), terfind( "t_grass" ), terfind( "t_floor" ),
+                               terfind( "t_wall" )
+                             };
+    const furn_id furniture[] = { f_null, f_null, f_null, furnfind( "f_chair" ), furnfind( "f_table" ) };
+    const trap_id traps[] = { tr_null, tr_null, tr_null, tr_null, trap_str_id( "tr_beartrap" ),
+                              trap_str_id( "tr_bubblewrap" )
+                            };
+    std::uniform_int_distribution<int> pick( 0, 99 );
+    sm.turn_last_touched = 1234;
+    sm.temperature = -7;
+    for( int i = 0; i < SEEX; i++ ) {
+        for( int j = 0; j < SEEY; j++ ) {
+            // Runs of terrain, like in generated maps
+            sm.ter[i][j] = terrain[( i / 4 + j / 6 + pick( generator ) / 90 ) % 4];
+            sm.frn[i][j] = furniture[pick( generator ) % 5];
+            sm.trp[i][j] = traps[pick( generator ) % 6];
+            sm.rad[i][j] = i < 3 ? i * 20 + j : 0;
+            if( !with_items ) {
+                continue;
+            }
+            if( pick( generator ) < 20 ) {
+                sm.itm[i][j].push_back( item( "rock", 0 ) );
+            }
+            if( pick( generator ) < 5 ) {
+                item light( "flashlight_on", 0 );
+                light.active = true;
+                sm.itm[i][j].push_back( light );
+                sm.active_items.add( std::prev( sm.itm[i][j].end() ), point( i, j ) );
+                sm.update_lum_add( light, i, j );
+            }
+            if( pick( generator ) < 10 ) {
+                sm.fld[i][j].addField( fd_blood, 2, 30 );
+                sm.fld[i][j].addField( fd_smoke, 1, -5 );
+                sm.field_count += 2;
+                sm.set_field_tile( i, j );
+            }
+        }
+    }
+    sm.set_graffiti( 1, 2, "Go north" );
+    sm.frn[5][6] = furnfind( "f_sign" );
+    sm.set_signage( 5, 6, "Diner" );
+    sm.spawns.push_back( spawn_point( "mon_zombie", 3, 4, 5, -1, 7, true, "Bob" ) );
+    sm.spawns.push_back( spawn_point( "mon_dog", 1, 11, 0 ) );
+    if( with_items ) {
+        vehicle *veh = new vehicle( vproto_id( "bicycle" ) );
+        veh->posx = 6;
+        veh->posy = 7;
+        sm.vehicles.push_back( veh );
+    }
+    sm.comp = computer( "Test terminal", 3 );
+    sm.comp.add_option( "Unlock", COMPACT_OPEN, 2 );
+    sm.camp = basecamp( "Home", 8, 9 );
+}
+
+// The JSON writer covers all of the saved data, submaps that write the same JSON are equal.
+static std::string dump( const tripoint &p, submap &sm )
+{
+    std::ostringstream out;
+    write_quad_json( out, { { p, &sm } } );
+    return out.str();
+}
+
+static void check_loaded_quad( submap_io::quad_out &saved, submap_io::quad_in &loaded )
+{
+    REQUIRE( loaded.size() == saved.size() );
+    for( size_t n = 0; n < saved.size(); n++ ) {
+        submap &expected = *saved[n].second;
+        submap &actual = *loaded[n].second;
+        CHECK( loaded[n].first == saved[n].first );
+        CHECK( dump( loaded[n].first, actual ) == dump( saved[n].first, expected ) );
+        // The caches that are rebuilt when loading
+        CHECK( actual.field_count == expected.field_count );
+        CHECK( actual.active_items.get().size() == expected.active_items.get().size() );
+        for( int i = 0; i < SEEX; i++ ) {
+            CHECK( actual.field_tiles[i] == expected.field_tiles[i] );
+            for( int j = 0; j < SEEY; j++ ) {
+                CHECK( actual.lum[i][j] == expected.lum[i][j] );
+            }
+        }
+    }
+}
+
+TEST_CASE("Submaps are loaded from binary and JSON quads as they were saved.") {
+    init_game( false );
+    std::default_random_engine generator( 7 );
+    std::vector<std::unique_ptr<submap>> quad;
+    submap_io::quad_out saved;
+    for( int n = 0; n < 4; n++ ) {
+        quad.emplace_back( new submap() );
+        fill_submap( *quad.back(), generator, true );
+        saved.emplace_back( tripoint( 100 + n / 2, -40 + n % 2, n - 2 ), quad.back().get() );
+    }
+    // A submap without anything sparse
+    quad[3]->delete_vehicles();
+    quad[3]->spawns.clear();
+
+    SECTION("binary") {
+        std::ostringstream out;
+        submap_io::write_quad( out, saved );
+        const std::string data = out.str();
+        CHECK( submap_io::is_binary( data ) );
+        submap_io::quad_in loaded;
+        submap_io::read_quad( data, loaded );
+        check_loaded_quad( saved, loaded );
+        for( auto &elem : loaded ) {
+            CHECK_FALSE( elem.second->dirty );
+        }
+    }
+    SECTION("legacy JSON") {
+        std::ostringstream out;
+        write_quad_json( out, saved );
+        const std::string data = out.str();
+        CHECK_FALSE( submap_io::is_binary( data ) );
+        std::istringstream in( data );
+        submap_io::quad_in loaded;
+        submap_io::read_quad( in, loaded );
+        check_loaded_quad( saved, loaded );
+        // Converted to binary on the next save
+        for( auto &elem : loaded ) {
+            CHECK( elem.second->dirty );
+        }
+    }
+    SECTION("snapshot") {
+        for( auto &elem : saved ) {
+            std::unique_ptr<submap> copy = submap_io::snapshot( *elem.second );
+            CHECK( dump( elem.first, *copy ) == dump( elem.first, *elem.second ) );
+            REQUIRE( copy->vehicles.size() == elem.second->vehicles.size() );
+            for( size_t i = 0; i < copy->vehicles.size(); i++ ) {
+                CHECK( copy->vehicles[i] != elem.second->vehicles[i] );
+            }
+        }
+    }
+    SECTION("damaged binary data") {
+        std::ostringstream out;
+        submap_io::write_quad( out, saved );
+        const std::string data = out.str();
+        for( const size_t length : { size_t( 5 ), data.size() / 2, data.size() - 1 } ) {
+            submap_io::quad_in loaded;
+            CHECK_THROWS_AS( submap_io::read_quad( data.substr( 0, length ), loaded ), std::string );
+        }
+        submap_io::quad_in loaded;
+        CHECK_THROWS_AS( submap_io::read_quad( data + '\0', loaded ), std::string );
+        // Version 1, any game data version and ~4 billion terrain ids, too many to allocate
+        const std::string huge_palette = data.substr( 0, 4 ) + std::string( "\x01\x00\xff\xff\xff\xff\x0f", 7 );
+        CHECK_THROWS_AS( submap_io::read_quad( huge_palette, loaded ), std::string );
+    }
+}
+
+TEST_CASE("Changing a submap makes it dirty.") {
+    init_game( false );
+    submap sm;
+    CHECK( sm.dirty );
+    const auto check_dirty = [&sm]( const std::function<void()> &change ) {
+        sm.dirty = false;
+        change();
+        CHECK( sm.dirty );
+    };
+    check_dirty( [&sm]() {
+        sm.set_ter( 1, 2, terfind( "t_floor" ) );
+    } );
+    check_dirty( [&sm]() {
+        sm.set_furn( 1, 2, furnfind( "f_chair" ) );
+    } );
+    check_dirty( [&sm]() {
+        sm.set_trap( 1, 2, trap_str_id( "tr_beartrap" ) );
+    } );
+    check_dirty( [&sm]() {
+        sm.set_radiation( 1, 2, 5 );
+    } );
+    check_dirty( [&sm]() {
+        sm.set_graffiti( 1, 2, "Go north" );
+    } );
+    check_dirty( [&sm]() {
+        sm.delete_graffiti( 1, 2 );
+    } );
+    check_dirty( [&sm]() {
+        sm.set_signage( 1, 2, "Diner" );
+    } );
+    check_dirty( [&sm]() {
+        item light( "flashlight_on", 0 );
+        sm.itm[1][2].push_back( light );
+        sm.update_lum_add( light, 1, 2 );
+    } );
+    check_dirty( [&sm]() {
+        sm.update_lum_rem( sm.itm[1][2].front(), 1, 2 );
+        sm.itm[1][2].clear();
+    } );
+}
+
+TEST_CASE("Benchmark of saving and loading quads in both formats.") {
+    init_game( false );
+    std::default_random_engine generator( 11 );
+    const int iterations = 50;
+    for( const bool with_items : { false, true } ) {
+        std::vector<std::unique_ptr<submap>> quad;
+        submap_io::quad_out saved;
+        for( int n = 0; n < 4; n++ ) {
+            quad.emplace_back( new submap() );
+            fill_submap( *quad.back(), generator, with_items );
+            saved.emplace_back( tripoint( n / 2, n % 2, 0 ), quad.back().get() );
+        }
+
+        size_t sizes[2] = { 0, 0 };
+        for( const int binary : { 0, 1 } ) {
+            std::string data;
+            const auto start_save = std::chrono::steady_clock::now();
+            for( int i = 0; i < iterations; i++ ) {
+                std::ostringstream out;
+                if( binary ) {
+                    submap_io::write_quad( out, saved );
+                } else {
+                    write_quad_json( out, saved );
+                }
+                data = out.str();
+            }
+            const auto start_load = std::chrono::steady_clock::now();
+            for( int i = 0; i < iterations; i++ ) {
+                submap_io::quad_in loaded;
+                submap_io::read_quad( data, loaded );
+            }
+            const auto end = std::chrono::steady_clock::now();
+            sizes[binary] = data.size();
+            printf( "%s quad %s items, %d bytes, saved %d times in %f seconds, loaded in %f seconds.\n",
+                    binary ? "Binary" : "JSON", with_items ? "with" : "without", int( data.size() ),
+                    iterations, std::chrono::duration<double>( start_load - start_save ).count(),
+                    std::chrono::duration<double>( end - start_load ).count() );
+        }
+        CHECK( sizes[1] < sizes[0] );
+    }
+}
@@ -0,0 +1,47 @@
+#ifndef TEST_GAME_H
+#define TEST_GAME_H
+
+#include "morale.h"
+#include "game.h"
+#include "map.h"
+#include "mapsharing.h"
+#include "options.h"
+#include "path_info.h"
+#include "player.h"
+
+/**
+ * Sets up the game for the test cases of a test, the first call does the work.
+ * With `load_map`, a dummy player is placed and the map around them is loaded.
+ */
+inline void init_game( const bool load_map = true )
+{
+    if( g != nullptr ) {
+        return;
+    }
+
+    PATH_INFO::init_base_path("");
+    PATH_INFO::init_user_dir("./");
+    PATH_INFO::set_standard_filenames();
+
+    MAP_SHARING::setDefaults();
+
+    // Assume curses
+    initOptions();
+    load_options();
+    initscr();
+
+    g = new game;
+    g->load_static_data();
+    g->setup();
+
+    if( !load_map ) {
+        return;
+    }
+    player dummy;
+    dummy.normalize();
+    dummy.name = "dummy";
+    g->u = dummy;
+    g->m.load( g->get_levx(), g->get_levy(), g->get_levz(), false );
+}
+
+#endif